@@ -34,12 +34,30 @@ namespace rogue {
           * or Zynq AXI4 register space (using the rce_memmap driver). The driver
           * controls which space is availablet to the user. Multiple AxiMemMap classes
           * are allowed to be attached to the driver at the same time.
+          *
+          * When the path is a regular file, such as a PCI Express BAR resource file
+          * under /sys/bus/pci/devices, the file is mapped into user space and registers
+          * are accessed directly with 32-bit loads and stores instead of one ioctl per
+          * register. A plain file of the required size can be used in place of the 
+          * hardware for testing and benchmarking.
           */
          class AxiMemMap : public rogue::interfaces::memory::Slave {
 
                //! AxiMemMap file descriptor
                int32_t  fd_;
 
+               //! User space register mapping, NULL when accessed through the driver
+               uint8_t * map_;
+
+               //! Size of user space register mapping
+               uint64_t mapSize_;
+
+               // Service a transaction through the user space mapping
+               uint32_t mapTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
+
+               // Service a transaction through the driver
+               uint32_t driverTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
+
                // Logging
                std::shared_ptr<rogue::Logging> log_;
 
@@ -47,7 +65,7 @@ namespace rogue {
 
                //! Class factory which returns a AxiMemMapPtr to a newly created AxiMemMap object
                /** Exposed to Python as rogue.hardware.axi.AxiMemMap()
-                * @param path Path to device. i.e /dev/datadev_0
+                * @param path Path to device. i.e /dev/datadev_0, or a regular file to map
                 * @return AxiMemMap pointer (AxiMemMapPtr)
                 */
                static std::shared_ptr<rogue::hardware::axi::AxiMemMap> create (std::string path);
@@ -61,6 +79,11 @@ namespace rogue {
                // Destructor
                ~AxiMemMap();
 
+               //! Return true if registers are accessed through a user space mapping
+               /** Exposed to Python as isMapped()
+                */
+               bool isMapped();
+
                // Accept as transaction from the memory Master as defined in the Slave class.
                void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
          };
@@ -17,6 +17,10 @@
 #ifndef __ROGUE_ZMQ_CLIENT_H__
 #define __ROGUE_ZMQ_CLIENT_H__
 #include <thread>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <stdint.h>
 #include <rogue/Logging.h>
 
 #ifndef NO_PYTHON
@@ -26,7 +30,21 @@
 namespace rogue {
    namespace interfaces {
 
-      //! Logging
+      //! Rogue ZMQ Control Client
+      /** Variable updates are published by the server in a binary format. The message
+       * starts with the four byte tag 'RUP1' and a 32-bit record count. Each record
+       * contains a 32-bit variable id, an 8-bit value type, a 32-bit value length,
+       * the value, a 32-bit display length and the utf-8 display string. A display
+       * length of 0xFFFFFFFF indicates that no display value is available. All fields
+       * are little endian. The mapping between variable ids and paths is returned by
+       * a request to the __varids__ path.
+       *
+       * The client keeps the display values received on the update socket in a local
+       * cache. Calls to valueDisp() for published variables are served from this cache
+       * without a request to the server. The entry of a variable is dropped when this
+       * client sets it, until the next update arrives. Batches of variables can be read or written
+       * in a single request with getMany() and setMany().
+       */
       class ZmqClient {
 
             // Zeromq Context
@@ -46,10 +64,45 @@ namespace rogue {
             std::thread   * thread_;
             bool threadEn_;
 
+            // Variable ids by path
+            std::map<std::string, uint32_t> ids_;
+            bool idsValid_;
+
+            // Cached display values by id
+            std::map<uint32_t, std::string> values_;
+
+            // Cache lock
+            std::mutex cacheMtx_;
+
             void runThread();
 
+            bool cachedDisp(const std::string & path, std::string & disp);
+
+            void invalidate(const std::string & path);
+
          public:
 
+            //! Update value types
+            static const uint8_t UpdateNone   = 0;
+            static const uint8_t UpdateBool   = 1;
+            static const uint8_t UpdateInt    = 2;
+            static const uint8_t UpdateFloat  = 3;
+            static const uint8_t UpdateString = 4;
+            static const uint8_t UpdateBytes  = 5;
+            static const uint8_t UpdatePickle = 6;
+
+            //! Decoded update record
+            struct UpdateEntry {
+               uint32_t    id;
+               uint8_t     type;
+               std::string value;
+               std::string disp;
+               bool        dispValid;
+            };
+
+            //! Decode a binary update message, returns false if the message is malformed
+            static bool decodeUpdate(const std::string & data, std::vector<UpdateEntry> & entries);
+
             static std::shared_ptr<rogue::interfaces::ZmqClient> create(std::string addr, uint16_t port);
 
             //! Setup class in python
@@ -75,6 +128,24 @@ namespace rogue {
 
             std::string valueDisp(std::string path);
 
+            //! Get the display values of a list of variables in a single request
+            /** The hardware reads for all variables are issued before any are checked
+             * when read is true. Returns an empty string for unknown variables.
+             */
+            std::vector<std::string> getMany(std::vector<std::string> paths, bool read=true);
+
+            //! Set the display values of a set of variables in a single request
+            /** All values are updated before a single write, verify and check
+             * of the affected blocks when write is true.
+             */
+            void setMany(std::map<std::string, std::string> values, bool write=true);
+
+#ifndef NO_PYTHON
+            boost::python::list getManyPy(boost::python::object paths, bool read);
+
+            void setManyPy(boost::python::dict values, bool write);
+#endif
+
       };
       typedef std::shared_ptr<rogue::interfaces::ZmqClient> ZmqClientPtr;
 
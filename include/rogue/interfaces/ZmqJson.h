@@ -0,0 +1,58 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Rogue ZMQ JSON Helpers
+ * ----------------------------------------------------------------------------
+ * File       : ZmqJson.h
+ * Created    : 2019-05-02
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_ZMQ_JSON_H__
+#define __ROGUE_ZMQ_JSON_H__
+#include <string>
+#include <map>
+
+namespace rogue {
+   namespace interfaces {
+
+      //! Minimal JSON support for the ZMQ control interface
+      /** Shared by ZmqServer and ZmqClient to build and inspect request messages
+       * without a JSON library. Malformed input is reported through the return
+       * value, no method throws.
+       */
+      class ZmqJson {
+         public:
+
+            //! Encode a string as a JSON string literal
+            /** @param in Raw string
+             * @return Quoted and escaped string
+             */
+            static std::string quote(const std::string & in);
+
+            //! Decode a JSON string literal
+            /** @param raw Quoted and escaped string
+             * @param out Decoded string, UTF-8 encoded
+             * @return False if raw is not a valid string literal
+             */
+            static bool decode(const std::string & raw, std::string & out);
+
+            //! Split a JSON object into its top level fields
+            /** Whitespace outside of strings is removed from the raw values.
+             * @param data JSON object
+             * @param fields Map of key to raw value
+             * @return False if data is not a JSON object
+             */
+            static bool fields(const std::string & data, std::map<std::string, std::string> & fields);
+      };
+   }
+}
+
+#endif
+
@@ -17,7 +17,12 @@
 #ifndef __ROGUE_ZMQ_SERVER_H__
 #define __ROGUE_ZMQ_SERVER_H__
 #include <thread>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
 #include <rogue/Logging.h>
+#include <rogue/Queue.h>
 
 #ifndef NO_PYTHON
 #include <boost/python.hpp>
@@ -26,7 +31,15 @@
 namespace rogue {
    namespace interfaces {
 
-      //! Logging
+      //! Rogue ZMQ Control Server
+      /** Requests are received on a ROUTER socket by a broker thread and handed to a
+       * pool of worker threads which call doRequest(). A slow request only occupies
+       * one worker. Requests which are not answered within the configured timeout
+       * receive a null response. Read only value requests for variables in the
+       * snapshot cache are answered by the broker without calling doRequest().
+       * A request which sets a variable or calls a command drops the snapshot
+       * of that path until the next update is cached.
+       */
       class ZmqServer {
 
             // Zeromq Context
@@ -35,30 +48,79 @@ namespace rogue {
             // Zeromq publish port
             void * zmqPub_;
 
-            // Zeromq response port
+            // Zeromq request port (ROUTER)
             void * zmqRep_;
 
+            // Zeromq worker response port
+            void * zmqBack_;
+
+            // Inproc address for worker responses
+            std::string backAddr_;
+
             std::thread   * thread_;
             bool threadEn_;
 
+            // Workers
+            std::vector<std::thread *> workers_;
+            bool workersEn_;
+
+            // Work queue
+            rogue::Queue<std::pair<uint64_t, std::string> > workQueue_;
+
+            // Request timeout in milliseconds, 0 = disabled
+            std::atomic<uint32_t> timeout_;
+
+            // Cache entry
+            struct CacheEntry {
+               std::string json;
+               std::string disp;
+            };
+
+            // Snapshot cache
+            std::map<std::string, CacheEntry> cache_;
+
+            // Cache lock
+            std::mutex cacheMtx_;
+
             //! Log 
             std::shared_ptr<rogue::Logging> log_;
 
             void runThread();
 
+            void runWorker();
+
+            bool doCached(const std::string & data, std::string & ret);
+
          public:
 
-            static std::shared_ptr<rogue::interfaces::ZmqServer> create(std::string addr, uint16_t port);
+            static std::shared_ptr<rogue::interfaces::ZmqServer> create(std::string addr, uint16_t port, uint32_t workers=4);
 
             //! Setup class in python
             static void setup_python();
 
-            ZmqServer (std::string addr, uint16_t port);
+            ZmqServer (std::string addr, uint16_t port, uint32_t workers=4);
             virtual ~ZmqServer();
 
             void publish(std::string value);
 
             virtual std::string doRequest (std::string data);
+
+            //! Set the per request timeout in milliseconds, 0 to disable
+            void setTimeout(uint32_t msecs);
+
+            //! Update the snapshot cache for a path
+            /** The json string is the encoded value, or empty if the value can not be
+             * served from the cache. The disp string is the display value.
+             */
+            void updateCache(std::string path, std::string json, std::string disp);
+
+            //! Clear the snapshot cache
+            void clearCache();
+
+#ifndef NO_PYTHON
+            //! Update the snapshot cache from a python value, exposed as _updateCache
+            void updateCachePy(std::string path, boost::python::object value, std::string disp);
+#endif
       };
       typedef std::shared_ptr<rogue::interfaces::ZmqServer> ZmqServerPtr;
 
@@ -71,7 +133,7 @@ namespace rogue {
 
          public:
 
-            ZmqServerWrap (std::string addr, uint16_t port);
+            ZmqServerWrap (std::string addr, uint16_t port, uint32_t workers=4);
 
             std::string doRequest ( std::string data );
 
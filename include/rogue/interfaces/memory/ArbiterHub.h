@@ -0,0 +1,258 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Arbiter Hub
+ * ----------------------------------------------------------------------------
+ * File       : ArbiterHub.h
+ * Created    : 2019-01-24
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which shares a Slave between several Masters.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_ARBITER_HUB_H__
+#define __ROGUE_INTERFACES_MEMORY_ARBITER_HUB_H__
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <rogue/interfaces/memory/Hub.h>
+#include <rogue/interfaces/memory/Slave.h>
+#include <rogue/Logging.h>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface Arbiter Hub
+         /** The ArbiterHub shares its next level Slave between several independent
+          * Masters. Each Master attaches to its own ArbiterPort, which holds a queue
+          * of pending transactions, a weight and an outstanding limit. Masters which
+          * attach to the ArbiterHub directly share port 0, with a weight of 1.
+          *
+          * Queued transactions are forwarded in weighted round robin order: each port
+          * in turn may forward up to its weight in transactions, skipping ports which
+          * are empty or at their outstanding limit. The total number of transactions
+          * outstanding at the next level can also be limited.
+          *
+          * Transactions are forwarded with a copy of their data. Per port throughput
+          * and queueing delay are reported by getStats().
+          */
+         class ArbiterHub : public Hub {
+
+               // Port state
+               struct Port {
+                  uint32_t weight;
+                  uint32_t limit;
+                  uint32_t outstanding;
+
+                  std::deque<std::pair<std::shared_ptr<rogue::interfaces::memory::Transaction>,
+                                       std::chrono::steady_clock::time_point> > queue;
+
+                  uint64_t count;
+                  uint64_t bytes;
+                  uint64_t errors;
+                  uint64_t waitSum;
+                  uint64_t waitMax;
+                  uint64_t maxDepth;
+               };
+
+               // Ports, port 0 serves Masters attached to the hub directly
+               std::vector<Port> ports_;
+
+               // Round robin position and remaining weight of the current port
+               uint32_t rrPort_;
+               uint32_t rrCredit_;
+
+               // Max outstanding transactions, 0 for unlimited
+               uint32_t depth_;
+
+               // Outstanding transactions
+               uint32_t outstanding_;
+
+               // Start of the statistics interval
+               std::chrono::steady_clock::time_point statsTime_;
+
+               // Lock
+               std::mutex arbMtx_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Clear port statistics, arbMtx_ must be held
+               void clearStats();
+
+               // Forward queued transactions while slots are free
+               void dispatch();
+
+               // Forward a transaction
+               void forward(std::shared_ptr<rogue::interfaces::memory::Transaction> tran,
+                            std::chrono::steady_clock::time_point queued, uint32_t port);
+
+            public:
+
+               //! Class factory which returns a pointer to an ArbiterHub (ArbiterHubPtr)
+               /** Exposed to Python as rogue.interfaces.memory.ArbiterHub()
+                *
+                * @param offset The offset of this Hub device
+                * @param depth Max outstanding transactions at the next level, 0 for unlimited
+                */
+               static std::shared_ptr<rogue::interfaces::memory::ArbiterHub> create (uint64_t offset, uint32_t depth);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create an ArbiterHub device with a given offset
+               ArbiterHub(uint64_t offset, uint32_t depth);
+
+               // Destroy the ArbiterHub
+               ~ArbiterHub();
+
+               //! Add a port, called by ArbiterPort
+               /** @param weight Transactions forwarded per round robin turn
+                * @param limit Max outstanding transactions for the port, 0 for unlimited
+                * @return Port index
+                */
+               uint32_t addPort(uint32_t weight, uint32_t limit);
+
+               //! Set the weight and outstanding limit of a port
+               /** Exposed to Python as setPort()
+                * @param port Port index
+                * @param weight Transactions forwarded per round robin turn
+                * @param limit Max outstanding transactions for the port, 0 for unlimited
+                */
+               void setPort(uint32_t port, uint32_t weight, uint32_t limit);
+
+               //! Set the max outstanding transactions
+               /** Exposed to Python as setDepth()
+                * @param depth Max outstanding transactions at the next level, 0 for unlimited
+                */
+               void setDepth(uint32_t depth);
+
+               //! Get the number of queued transactions for a port
+               /** Exposed to Python as getQueued()
+                * @param port Port index
+                * @return Queued transaction count
+                */
+               uint32_t getQueued(uint32_t port);
+
+               //! Get the number of outstanding transactions
+               /** Exposed to Python as getOutstanding()
+                * @return Outstanding transaction count
+                */
+               uint32_t getOutstanding();
+
+               //! Reset port statistics
+               /** Exposed to Python as resetStats()
+                */
+               void resetStats();
+
+#ifndef NO_PYTHON
+
+               //! Get port statistics
+               /** Returns a dictionary keyed by port index. Each entry holds the weight,
+                * limit, queued and outstanding counts, the transaction, byte and error
+                * counts, the transaction and byte rates since the last reset and the
+                * average and maximum queueing delay in seconds.
+                *
+                * Exposed to Python as getStats()
+                * @return Python dictionary
+                */
+               boost::python::dict getStats();
+
+#endif
+
+               //! Queue a transaction for a port
+               /** The local address offset is applied and the transaction is queued.
+                * @param transaction Transaction pointer as TransactionPtr
+                * @param port Port index
+                */
+               void queueTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction, uint32_t port);
+
+               //! Interface to service the transaction request from an attached master
+               /** The transaction is queued on port 0.
+                *
+                * Not exposted to Python
+                * @param transaction Transaction pointer as TransactionPtr
+                */
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as ArbiterHubPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::ArbiterHub> ArbiterHubPtr;
+
+         //! Memory interface Arbiter Port
+         /** An ArbiterPort is the Slave a Master attaches to in order to share an
+          * ArbiterHub. Access sizes, address and slave id are those of the ArbiterHub.
+          */
+         class ArbiterPort : public Slave {
+
+               // Arbiter
+               std::shared_ptr<rogue::interfaces::memory::ArbiterHub> hub_;
+
+               // Port index
+               uint32_t port_;
+
+            public:
+
+               //! Class factory which returns a pointer to an ArbiterPort (ArbiterPortPtr)
+               /** Exposed to Python as rogue.interfaces.memory.ArbiterPort()
+                *
+                * @param hub ArbiterHub to attach to
+                * @param weight Transactions forwarded per round robin turn
+                * @param limit Max outstanding transactions for the port, 0 for unlimited
+                */
+               static std::shared_ptr<rogue::interfaces::memory::ArbiterPort> create (
+                     std::shared_ptr<rogue::interfaces::memory::ArbiterHub> hub, uint32_t weight, uint32_t limit);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create an ArbiterPort
+               ArbiterPort(std::shared_ptr<rogue::interfaces::memory::ArbiterHub> hub, uint32_t weight, uint32_t limit);
+
+               // Destroy the ArbiterPort
+               ~ArbiterPort();
+
+               //! Get the port index
+               /** Exposed to Python as getPort()
+                * @return Port index used in ArbiterHub statistics
+                */
+               uint32_t getPort();
+
+               // Return id of the ArbiterHub
+               uint32_t doSlaveId();
+
+               // Return min access size of the ArbiterHub
+               uint32_t doMinAccess();
+
+               // Return max access size of the ArbiterHub
+               uint32_t doMaxAccess();
+
+               // Return address of the ArbiterHub
+               uint64_t doAddress();
+
+               // Queue the transaction on this port
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as ArbiterPortPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::ArbiterPort> ArbiterPortPtr;
+      }
+   }
+}
+
+#endif
+
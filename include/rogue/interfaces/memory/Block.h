@@ -0,0 +1,365 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Block
+ * ----------------------------------------------------------------------------
+ * File       : Block.h
+ * Created    : 2019-01-15
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface master which holds the data for a block of variables.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_BLOCK_H__
+#define __ROGUE_INTERFACES_MEMORY_BLOCK_H__
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <rogue/interfaces/memory/Master.h>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory block
+         /** The Block is a memory Master which owns the data for a contiguous block of
+          * registers along with the bit fields of the variables which map into it.
+          * It holds the block data, the staged write data and mask, and the verify data
+          * and mask. Values are staged into the block bit by bit, merged into the block
+          * data before a write and compared against the verify data after a verify.
+          *
+          * The Block also keeps a shadow of the last data written to or read from the
+          * hardware, which allows a configuration write to skip blocks whose staged
+          * contents already match the hardware.
+          *
+          * Variable values of the UInt, Int, Bool and Float field types are packed and
+          * unpacked natively. Other types are passed as little endian byte arrays.
+          *
+          * The Block does not lock its buffers. The caller serializes access, the pyrogue
+          * RemoteBlock does this with its block lock.
+          */
+         class Block : public Master {
+
+               // Variable field
+               struct Field {
+                  std::vector<uint32_t> offset;
+                  std::vector<uint32_t> size;
+                  uint32_t bits;
+                  uint32_t type;
+               };
+
+               // Block offset and size
+               uint64_t offset_;
+               uint32_t size_;
+
+               // Block data
+               std::vector<uint8_t> bData_;
+
+               // Staged data and mask
+               std::vector<uint8_t> sData_;
+               std::vector<uint8_t> sDataMask_;
+
+               // Verify data and mask
+               std::vector<uint8_t> vData_;
+               std::vector<uint8_t> vDataMask_;
+
+               // Shadow of the hardware data and its valid flag
+               std::vector<uint8_t> hData_;
+               bool hValid_;
+
+               // Exclusive and overlap enabled variable masks
+               std::vector<uint8_t> excMask_;
+               std::vector<uint8_t> oleMask_;
+
+               // Variable fields
+               std::vector<Field> fields_;
+
+               // Poll data and last polled data, owned by the Poller
+               std::vector<uint8_t> pData_;
+               std::vector<uint8_t> pLast_;
+               bool pValid_;
+
+               // Write sequence, advanced each time staged data is merged for a write,
+               // and its value when the current poll read was issued
+               std::atomic<uint64_t> wrSeq_;
+               std::atomic<uint64_t> pSeq_;
+
+               // Check a field index
+               Field & field(uint32_t idx);
+
+            public:
+
+               //! Field is a byte array
+               static const uint32_t Bytes = 0;
+
+               //! Field is an unsigned integer up to 64 bits
+               static const uint32_t UInt  = 1;
+
+               //! Field is a signed integer up to 64 bits
+               static const uint32_t Int   = 2;
+
+               //! Field is a single bit boolean
+               static const uint32_t Bool  = 3;
+
+               //! Field is a 32 or 64 bit floating point value
+               static const uint32_t Float = 4;
+
+               //! Class factory which returns a pointer to a Block object (BlockPtr)
+               /** Exposed to Python as rogue.interfaces.memory.Block()
+                * @param offset Block offset relative to the base address of the slave
+                * @param size Block size in bytes
+                * @return Block pointer (BlockPtr)
+                */
+               static std::shared_ptr<rogue::interfaces::memory::Block> create (uint64_t offset, uint32_t size);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a Block object
+               Block(uint64_t offset, uint32_t size);
+
+               // Destroy the Block object
+               ~Block();
+
+               //! Get the block offset
+               /** Exposed to Python as _getOffset()
+                * @return Block offset
+                */
+               uint64_t getOffset();
+
+               //! Get the block size
+               /** Exposed to Python as _getSize()
+                * @return Block size in bytes
+                */
+               uint32_t getSize();
+
+               //! Add a variable field to the block
+               /** Exposed to Python as _addVariable()
+                * @param offset List of bit offsets, one per field segment
+                * @param size List of bit sizes, one per field segment
+                * @param overlapEn Variable is allowed to overlap other variables
+                * @param verify Variable is included in the verify mask
+                * @param type Field type (Bytes, UInt, Int, Bool or Float)
+                * @return Field index
+                */
+               uint32_t addVariable(std::vector<uint32_t> offset, std::vector<uint32_t> size,
+                                    bool overlapEn, bool verify, uint32_t type);
+
+               //! Check for overlap between exclusive and overlap enabled variables
+               /** Exposed to Python as _checkOverlap()
+                * @return True if an overlap exists
+                */
+               bool checkOverlap();
+
+               //! Get the overlap enable state of the block
+               /** Exposed to Python as _getOverlapEn()
+                * @return True if no exclusive variables exist in the block
+                */
+               bool getOverlapEn();
+
+               //! Get the verify enable state of the block
+               /** Exposed to Python as _getVerifyEn()
+                * @return True if any bits are included in the verify mask
+                */
+               bool getVerifyEn();
+
+               //! Stage a field value from a packed little endian bit array
+               /** @param idx Field index
+                * @param data Source data, holding the field bits starting at bit 0
+                */
+               void setBytes(uint32_t idx, const uint8_t *data);
+
+               //! Get a field value as a packed little endian bit array
+               /** Staged data is returned for segments which have been staged.
+                * @param idx Field index
+                * @param data Destination data, sized to hold the field bits
+                */
+               void getBytes(uint32_t idx, uint8_t *data);
+
+               //! Stage an unsigned integer field value
+               /** Throws a GeneralError if the value does not fit in the field.
+                * @param idx Field index
+                * @param value Field value
+                */
+               void setUInt(uint32_t idx, uint64_t value);
+
+               //! Get an unsigned integer field value
+               /** @param idx Field index
+                * @return Field value
+                */
+               uint64_t getUInt(uint32_t idx);
+
+               //! Stage a signed integer field value
+               /** Throws a GeneralError if the value does not fit in the field.
+                * @param idx Field index
+                * @param value Field value
+                */
+               void setInt(uint32_t idx, int64_t value);
+
+               //! Get a signed integer field value, sign extended from the field size
+               /** @param idx Field index
+                * @return Field value
+                */
+               int64_t getInt(uint32_t idx);
+
+               //! Stage a floating point field value
+               /** @param idx Field index
+                * @param value Field value
+                */
+               void setFloat(uint32_t idx, double value);
+
+               //! Get a floating point field value
+               /** @param idx Field index
+                * @return Field value
+                */
+               double getFloat(uint32_t idx);
+
+               //! Merge staged data into the block data
+               /** Advances the write sequence, a poll read issued before the merge is
+                * not applied.
+                *
+                * Exposed to Python as _applyStaged()
+                * @param clear Clear the staged data and mask after the merge
+                */
+               void applyStaged(bool clear);
+
+               //! Check for staged data
+               /** Exposed to Python as _stale()
+                * @return True if any bits are staged
+                */
+               bool stale();
+
+               //! Compare the verify data to the block data under the verify mask
+               /** Exposed to Python as _verifyMismatch()
+                * @return True if the verify data does not match
+                */
+               bool verifyMismatch();
+
+               //! Copy the block data into the hardware shadow
+               /** Called once a write or read of the block data has completed without error.
+                *
+                * Exposed to Python as _shadowUpdate()
+                */
+               void shadowUpdate();
+
+               //! Invalidate the hardware shadow
+               /** Called when the hardware state is unknown, after a failed transaction
+                * or a hardware reset.
+                *
+                * Exposed to Python as _shadowClear()
+                */
+               void shadowClear();
+
+               //! Compare the block data, with staged data applied, to the hardware shadow
+               /** Only bits which belong to a variable are compared.
+                *
+                * Exposed to Python as _shadowMatch()
+                * @return True if the shadow is valid and matches
+                */
+               bool shadowMatch();
+
+               //! Get a pointer to the block data
+               uint8_t * blockData();
+
+               //! Get a pointer to the verify data
+               uint8_t * verifyData();
+
+               //! Get a pointer to the poll data
+               /** Poll reads issued by the Poller complete into this buffer, which is
+                * separate from the block data so that polling does not interfere with
+                * transactions started by the block owner.
+                */
+               uint8_t * pollData();
+
+               //! Start a poll read
+               /** Called by the Poller before the poll read is issued, records the
+                * write sequence so that a result which predates a write is not applied.
+                */
+               void pollStart();
+
+               //! Compare the poll data to the previous poll
+               /** Called by the Poller once a poll read has completed.
+                * @return True if the data changed or this is the first poll
+                */
+               bool pollCompare();
+
+               //! Copy the poll data into the block data
+               /** The poll data is dropped if a write was started after the poll read
+                * was issued. The hardware shadow is never refreshed from a poll, it only
+                * follows transactions ordered by the block owner, but it is invalidated
+                * when the poll data differs from it. The caller must wait for any
+                * transaction of the block which uses the block data.
+                *
+                * Exposed to Python as _pollApply()
+                * @return True if the poll data was applied
+                */
+               bool pollApply();
+
+#ifndef NO_PYTHON
+
+               //! Stage a field value, python version
+               /** Exposed to Python as _setValue()
+                *
+                * Bytes fields take an object supporting the buffer protocol.
+                * @param idx Field index
+                * @param value Field value
+                */
+               void setValuePy(uint32_t idx, boost::python::object value);
+
+               //! Get a field value, python version
+               /** Exposed to Python as _getValue()
+                *
+                * Bytes fields are returned as a bytearray.
+                * @param idx Field index
+                * @return Field value
+                */
+               boost::python::object getValuePy(uint32_t idx);
+
+               //! Add a variable field to the block, python version
+               uint32_t addVariablePy(boost::python::object offset, boost::python::object size,
+                                      bool overlapEn, bool verify, uint32_t type);
+
+               //! Get a writable memoryview of the block data
+               /** Exposed to Python as _blockData()
+                *
+                * The view is valid for the life of the Block.
+                * @return memoryview object
+                */
+               boost::python::object blockDataPy();
+
+               //! Get a writable memoryview of the verify data
+               /** Exposed to Python as _verifyData()
+                * @return memoryview object
+                */
+               boost::python::object verifyDataPy();
+
+               //! Get a memoryview of the verify mask
+               /** Exposed to Python as _verifyMask()
+                * @return memoryview object
+                */
+               boost::python::object verifyMaskPy();
+
+#endif
+         };
+
+         //! Alias for using shared pointer as BlockPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::Block> BlockPtr;
+
+      }
+   }
+}
+
+#endif
+
@@ -0,0 +1,146 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Cache Hub
+ * ----------------------------------------------------------------------------
+ * File       : CacheHub.h
+ * Created    : 2018-03-14
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which serves reads of registered address ranges 
+ * from a local shadow copy.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_CACHE_HUB_H__
+#define __ROGUE_INTERFACES_MEMORY_CACHE_HUB_H__
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <rogue/interfaces/memory/Hub.h>
+#include <rogue/Logging.h>
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface Cache Hub
+         /** The CacheHub keeps a shadow copy of address ranges registered with addRange().
+          * A Read transaction which falls entirely within a registered range is served
+          * from the shadow copy when every byte was read from hardware within the 
+          * configured staleness bound. Otherwise the read is forwarded to the next level 
+          * and the shadow copy is refreshed from the result. Write and Post transactions 
+          * are always forwarded and invalidate the overlapping shadow bytes, since 
+          * hardware registers may not read back as written. Verify transactions and
+          * transactions outside of the registered ranges are forwarded unchanged.
+          *
+          * Range addresses are relative to this Hub, before the local offset is applied.
+          */
+         class CacheHub : public Hub {
+
+               // Shadow range
+               struct Range {
+                  uint32_t size;
+                  uint32_t gen;
+                  std::vector<uint8_t> data;
+                  std::vector<std::chrono::steady_clock::time_point> stamp;
+               };
+
+               // Shared cache state, held by in flight refills
+               struct Cache {
+                  std::mutex mtx;
+                  std::map<uint64_t, Range> ranges;
+                  std::chrono::microseconds staleness;
+                  uint64_t hits;
+                  uint64_t misses;
+               };
+
+               std::shared_ptr<Cache> cache_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Find the range containing an address span, cache lock must be held
+               static Range * findRange(std::shared_ptr<Cache> cache, uint64_t address, uint32_t size, uint64_t & start);
+
+               // Invalidate overlapping bytes, cache lock must be held
+               static void invalidate(std::shared_ptr<Cache> cache, uint64_t address, uint32_t size);
+
+            public:
+
+               //! Class factory which returns a pointer to a CacheHub (CacheHubPtr)
+               /** Exposed to Python as rogue.interfaces.memory.CacheHub()
+                *
+                * @param offset The offset of this Hub device
+                * @param staleness Max age of served data in microseconds
+                */
+               static std::shared_ptr<rogue::interfaces::memory::CacheHub> create (uint64_t offset, uint32_t staleness);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a CacheHub device with a given offset
+               CacheHub(uint64_t offset, uint32_t staleness);
+
+               // Destroy the CacheHub
+               ~CacheHub();
+
+               //! Register an address range for caching
+               /** Exposed to Python as addRange()
+                * @param address Start address of the range, relative to this Hub
+                * @param size Size of the range in bytes
+                */
+               void addRange(uint64_t address, uint32_t size);
+
+               //! Set the staleness bound
+               /** Exposed to Python as setStaleness()
+                * @param staleness Max age of served data in microseconds, 0 to disable caching
+                */
+               void setStaleness(uint32_t staleness);
+
+               //! Invalidate the full shadow copy
+               /** Exposed to Python as invalidate()
+                */
+               void invalidateAll();
+
+               //! Invalidate part of the shadow copy
+               /** Exposed to Python as invalidateRange()
+                * @param address Start address, relative to this Hub
+                * @param size Size in bytes
+                */
+               void invalidateRange(uint64_t address, uint32_t size);
+
+               //! Get the number of reads served from the shadow copy
+               /** Exposed to Python as getHits()
+                * @return Hit count
+                */
+               uint64_t getHits();
+
+               //! Get the number of reads of registered ranges forwarded to hardware
+               /** Exposed to Python as getMisses()
+                * @return Miss count
+                */
+               uint64_t getMisses();
+
+               //! Interface to service the transaction request from an attached master
+               /** Not exposted to Python
+                * @param transaction Transaction pointer as TransactionPtr
+                */
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as CacheHubPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::CacheHub> CacheHubPtr;
+      }
+   }
+}
+
+#endif
+
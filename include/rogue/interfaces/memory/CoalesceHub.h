@@ -0,0 +1,143 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Coalescing Hub
+ * ----------------------------------------------------------------------------
+ * File       : CoalesceHub.h
+ * Created    : 2018-03-12
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which merges adjacent transactions of the same type
+ * into larger downstream transactions.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_COALESCE_HUB_H__
+#define __ROGUE_INTERFACES_MEMORY_COALESCE_HUB_H__
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <rogue/interfaces/memory/Hub.h>
+#include <rogue/Logging.h>
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface Coalescing Hub
+         /** The CoalesceHub collects transactions for a short window, or until flush() is
+          * called, and merges transactions into larger transactions to the next level Slave.
+          * Transactions are never reordered. A transaction is merged into the group submitted
+          * just before it when both have the same type and it starts where that group ends.
+          * Read and Verify transactions which start no more than the configured gap past the
+          * end of the group are also merged, with the gap bytes read and discarded. Write and
+          * Post transactions are never padded, a write group whose size is not a multiple of
+          * the min access size is forwarded unmerged. Merged transactions never exceed the
+          * max access size of the next level. When the merged transaction completes the data
+          * and result are scattered back to the original transactions.
+          *
+          * This reduces the number of protocol frames when many small registers are
+          * accessed at once, for example when a Device reads all of its Blocks.
+          */
+         class CoalesceHub : public Hub {
+
+               // Collection window in microseconds
+               uint32_t window_;
+
+               // Max gap in bytes between merged reads
+               uint32_t gap_;
+
+               // Pending transactions
+               std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> > pend_;
+
+               // Pending byte count
+               uint32_t pendBytes_;
+
+               // Time at which pending transactions are flushed
+               std::chrono::steady_clock::time_point flushTime_;
+
+               // Lock and condition
+               std::mutex coalMtx_;
+               std::condition_variable coalCond_;
+
+               // Flush thread
+               std::thread * thread_;
+               bool threadEn_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Flush thread
+               void runThread();
+
+               // Merge and forward a list of transactions
+               void issue(std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> > & trans);
+
+               // Forward a merged transaction
+               void send(std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> >::iterator first,
+                         std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> >::iterator last,
+                         uint64_t address, uint32_t size, uint32_t type);
+
+            public:
+
+               //! Class factory which returns a pointer to a CoalesceHub (CoalesceHubPtr)
+               /** Exposed to Python as rogue.interfaces.memory.CoalesceHub()
+                *
+                * @param offset The offset of this Hub device
+                * @param window Collection window in microseconds, 0 to only merge on flush()
+                * @param gap Max gap in bytes between merged Read and Verify transactions
+                */
+               static std::shared_ptr<rogue::interfaces::memory::CoalesceHub> create (uint64_t offset, uint32_t window, uint32_t gap);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a CoalesceHub device with a given offset
+               CoalesceHub(uint64_t offset, uint32_t window, uint32_t gap);
+
+               // Destroy the CoalesceHub
+               ~CoalesceHub();
+
+               //! Set the collection window
+               /** Exposed to Python as setWindow()
+                * @param window Collection window in microseconds, 0 to only merge on flush()
+                */
+               void setWindow(uint32_t window);
+
+               //! Set the max gap between merged reads
+               /** Exposed to Python as setGap()
+                * @param gap Max gap in bytes
+                */
+               void setGap(uint32_t gap);
+
+               //! Merge and forward all pending transactions immediately
+               /** Exposed to Python as flush()
+                */
+               void flush();
+
+               //! Interface to service the transaction request from an attached master
+               /** The local address offset is applied and the transaction is queued
+                * for merging.
+                *
+                * Not exposted to Python
+                * @param transaction Transaction pointer as TransactionPtr
+                */
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as CoalesceHubPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::CoalesceHub> CoalesceHubPtr;
+      }
+   }
+}
+
+#endif
+
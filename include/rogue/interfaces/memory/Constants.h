@@ -113,6 +113,28 @@ namespace rogue {
           */
          static const uint32_t Verify = 0x4;
 
+         //////////////////////////////////
+         // Transaction Priority Constants
+         //////////////////////////////////
+
+         //! High priority transaction, used for time critical control accesses
+         /**
+          * Exposted to python as rogue.interfaces.memory.PriorityHigh
+          */
+         static const uint32_t PriorityHigh = 0x0;
+
+         //! Normal priority transaction, the default
+         /**
+          * Exposted to python as rogue.interfaces.memory.PriorityNormal
+          */
+         static const uint32_t PriorityNormal = 0x1;
+
+         //! Low priority transaction, used for background polling
+         /**
+          * Exposted to python as rogue.interfaces.memory.PriorityLow
+          */
+         static const uint32_t PriorityLow = 0x2;
+
       }
    }
 }
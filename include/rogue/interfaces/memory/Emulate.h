@@ -0,0 +1,153 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Emulator
+ * ----------------------------------------------------------------------------
+ * File       : Emulate.h
+ * Created    : 2018-03-20
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface slave which emulates a sparse memory space.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_EMULATE_H__
+#define __ROGUE_INTERFACES_MEMORY_EMULATE_H__
+#include <stdint.h>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <condition_variable>
+#include <rogue/interfaces/memory/Slave.h>
+#include <rogue/Logging.h>
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface emulator
+         /** The Emulate Slave serves transactions from a sparse memory space held in 
+          * fixed size pages. Pages are allocated on first write and unwritten memory
+          * reads as zero. Transactions are checked against the minimum and maximum 
+          * access sizes passed at creation.
+          *
+          * A completion latency can be configured, in which case transactions are 
+          * completed in order by a worker thread once the latency has elapsed. An error 
+          * rate can be configured, in which case a random fraction of transactions 
+          * complete with the configured error without accessing memory.
+          *
+          * Used to test memory Masters, Hubs and protocol bridges at high rates without
+          * hardware and without holding the Python GIL.
+          */
+         class Emulate : public Slave {
+
+               // Page size in bytes
+               static const uint32_t PageSize = 4096;
+
+               // Delayed transaction
+               struct Pending {
+                  std::shared_ptr<rogue::interfaces::memory::Transaction> tran;
+                  std::chrono::steady_clock::time_point due;
+                  uint32_t error;
+               };
+
+               // Page table, keyed by page index
+               std::unordered_map<uint64_t, std::unique_ptr<uint8_t[]> > pages_;
+
+               // Memory and configuration lock
+               std::mutex emuMtx_;
+
+               // Completion latency
+               std::chrono::microseconds latency_;
+
+               // Error injection
+               uint32_t errorRate_;
+               uint32_t errorCode_;
+               uint64_t rng_;
+
+               // Delayed transactions, in completion order
+               std::deque<Pending> queue_;
+
+               // Completion thread, created on first use
+               std::thread * thread_;
+               bool threadEn_;
+               std::condition_variable cond_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Copy between memory and a buffer, emuMtx_ must be held
+               void access(uint64_t address, uint32_t size, uint8_t *data, bool write);
+
+               // Service a transaction, transaction lock must be held
+               void service(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran, uint32_t error);
+
+               // Completion thread
+               void runThread();
+
+            public:
+
+               //! Class factory which returns a pointer to an Emulate object (EmulatePtr)
+               /** Exposed to Python as rogue.interfaces.memory.Emulate()
+                * @param min Minimum access size, transaction addresses must be aligned to this size
+                * @param max Maximum access size
+                * @return Emulate pointer (EmulatePtr)
+                */
+               static std::shared_ptr<rogue::interfaces::memory::Emulate> create (uint32_t min, uint32_t max);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create an Emulate object
+               Emulate(uint32_t min, uint32_t max);
+
+               // Destroy the Emulate object
+               ~Emulate();
+
+               //! Set the transaction completion latency
+               /** Exposed to Python as setLatency()
+                * @param latency Latency in microseconds, zero to complete in the caller
+                */
+               void setLatency(uint32_t latency);
+
+               //! Set the transaction error rate
+               /** Exposed to Python as setErrorRate()
+                * @param rate Fraction of transactions which fail, 0.0 to 1.0
+                * @param error Error value used for failed transactions
+                */
+               void setErrorRate(double rate, uint32_t error);
+
+               //! Get the number of allocated pages
+               /** Exposed to Python as getPageCount()
+                * @return Number of allocated pages
+                */
+               uint32_t getPageCount();
+
+               //! Release all memory, memory reads as zero afterwards
+               /** Exposed to Python as clear()
+                */
+               void clear();
+
+               //! Service a transaction from the memory Master
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as EmulatePtr
+         typedef std::shared_ptr<rogue::interfaces::memory::Emulate> EmulatePtr;
+
+      }
+   }
+}
+
+#endif
+
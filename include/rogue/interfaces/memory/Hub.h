@@ -28,6 +28,8 @@
 #include <rogue/interfaces/memory/Master.h>
 #include <rogue/interfaces/memory/Slave.h>
 #include <thread>
+#include <mutex>
+#include <atomic>
 
 #ifndef NO_PYTHON
 #include <boost/python.hpp>
@@ -53,6 +55,12 @@ namespace rogue {
           * cases where this Hub will master a paged address or other virtual address space.
           *
           * A pyrogue.Device instance is the most typical Hub used in Rogue.
+          *
+          * Chains of Hubs which only apply their offset are resolved once into a combined
+          * offset and a direct pointer to the first downstream device which does more,
+          * so a transaction skips the intermediate levels. The min access, max access and
+          * address queries are cached in the same way. Both are refreshed whenever
+          * setSlave() is called anywhere in the tree.
           */
          class Hub : public Master, public Slave {
 
@@ -62,6 +70,36 @@ namespace rogue {
                // Flag if this is a base slave
                bool root_;
 
+               // Lock for the cached downstream path
+               std::mutex flatMtx_;
+
+               // Cached downstream path and the tree epoch it was resolved in
+               std::shared_ptr<rogue::interfaces::memory::Slave> flatSlave_;
+               uint64_t flatOffset_;
+               uint64_t flatEpoch_;
+
+               // Cached query results and the tree epoch they were resolved in
+               uint32_t infoMin_;
+               uint32_t infoMax_;
+               uint64_t infoAddr_;
+               uint64_t infoEpoch_;
+
+               // Resolve the downstream path
+               void flatten(std::shared_ptr<rogue::interfaces::memory::Slave> & slave, uint64_t & offset);
+
+               // Refresh cached query results
+               void refreshInfo();
+
+            protected:
+
+               //! Return true if this Hub only applies its offset
+               /** Transactions passing through such a Hub may be forwarded directly
+                * to its downstream device with the offset applied by the upstream Hub.
+                * Only an instance of exactly this class qualifies.
+                * @return True if the Hub can be skipped
+                */
+               virtual bool passThrough();
+
             public:
 
                //! Class factory which returns a pointer to a Hub (HubPtr)
@@ -158,6 +196,17 @@ namespace rogue {
             public rogue::interfaces::memory::Hub, 
             public boost::python::wrapper<rogue::interfaces::memory::Hub> {
 
+               // Python override state, 0 = unknown, 1 = none, 2 = overridden
+               std::atomic<int> override_;
+
+               // Check for a python _doTransaction override, done once
+               bool overridden();
+
+            protected:
+
+               // Return true if this Hub only applies its offset
+               bool passThrough();
+
             public:
 
                // Constructor
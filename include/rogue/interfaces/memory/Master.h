@@ -24,6 +24,12 @@
 #include <vector>
 #include <map>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <future>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
 #include <rogue/Logging.h>
 
 #ifndef NO_PYTHON
@@ -36,6 +42,7 @@ namespace rogue {
 
          class Slave;
          class Transaction;
+         class TransactionStats;
 
          //! Master for a memory transaction interface
          /** The Master class is the initiator for any Memory transactions on a bus. Each 
@@ -46,13 +53,35 @@ namespace rogue {
          class Master {
             friend class Transaction;
 
+            public:
+
+               //! Alias for asynchronous completion callback, called with transaction id and error
+               typedef std::function<void(uint32_t, uint32_t)> AsyncCallback;
+
+               //! Bulk transaction request, see reqTransactions()
+               struct Request {
+                  uint64_t address;
+                  uint32_t size;
+                  void *   data;
+                  uint32_t type;
+               };
+
             private:
 
-               //! Alias for map
-               typedef std::map<uint32_t, std::shared_ptr<rogue::interfaces::memory::Transaction> > TransactionMap;
+               //! Pending asynchronous transaction
+               struct AsyncEntry {
+                  std::shared_ptr<rogue::interfaces::memory::Transaction> tran;
+                  AsyncCallback cb;
+               };
 
-               //! Transaction map
-               TransactionMap tranMap_;
+               //! Maximum number of idle transactions held for reuse
+               static const uint32_t PoolSize = 256;
+
+               //! Transactions waiting for waitTransaction()
+               std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> > tranList_;
+
+               //! Completed transactions available for reuse
+               std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> > tranPool_;
 
                //! Slave. Used for request forwards.
                std::shared_ptr<rogue::interfaces::memory::Slave> slave_;
@@ -66,9 +95,49 @@ namespace rogue {
                //! Error status
                uint32_t error_;
 
+               //! Priority of issued transactions
+               std::atomic<uint32_t> priority_;
+
                //! Log
                std::shared_ptr<rogue::Logging> log_;
 
+               //! Pending asynchronous transactions
+               std::map<uint32_t, AsyncEntry> asyncMap_;
+
+               //! Completed asynchronous transaction ids
+               std::vector<uint32_t> asyncDone_;
+
+               //! Next time pending asynchronous transactions must be checked for timeout
+               std::chrono::steady_clock::time_point asyncScan_;
+
+               //! Asynchronous completion lock and condition
+               std::mutex asyncMtx_;
+               std::condition_variable asyncCond_;
+
+               //! Asynchronous completion thread, created on first use
+               std::thread * asyncThread_;
+               bool asyncEn_;
+
+               //! Statistics object for the current slave, see rim::TransactionStats
+               std::shared_ptr<rogue::interfaces::memory::TransactionStats> stats_;
+
+               //! Slave and statistics registry epochs when stats_ was looked up
+               uint64_t statsSlaveEpoch_;
+               uint64_t statsEpoch_;
+
+               //! Asynchronous completion thread
+               void runAsync();
+
+               //! Attach the slave statistics object to a transaction if enabled, mastMtx_ must be held
+               bool attachStats(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran);
+
+               //! Refresh the cached statistics object and attach it to a transaction
+               void updateStats(std::shared_ptr<rogue::interfaces::memory::Slave> & slave,
+                                std::shared_ptr<rogue::interfaces::memory::Transaction> & tran);
+
+               //! Record a completed transaction into its statistics object
+               void recordStats(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran, uint32_t error);
+
             public:
 
                //! Class factory which returns a pointer to a Master (MasterPtr)
@@ -162,13 +231,35 @@ namespace rogue {
 
                //! Set timeout value for transactions
                /** Sets the timeout value for future transactions. THis is the amount of time
-                * to wait for a transaction to complete.
+                * to wait for a transaction to complete. Each Transaction gets a fixed deadline
+                * of the timeout past the time it is issued.
                 *
                 * Exposted to python as _setTimeout()
                 * @param timeout Timeout value
                 */
                void setTimeout(uint64_t timeout);
 
+               //! Get the timeout value
+               /** Exposted to python as _getTimeout()
+                * @return Timeout value in microseconds
+                */
+               uint64_t getTimeout();
+
+               //! Set the priority of transactions issued by this Master
+               /** The priority values are defined in Constants. The priority is carried
+                * by each Transaction and used by scheduling Slaves such as the PriorityHub.
+                *
+                * Exposted to python as _setPriority()
+                * @param priority Transaction priority
+                */
+               void setPriority(uint32_t priority);
+
+               //! Get the priority of transactions issued by this Master
+               /** Exposted to python as _getPriority()
+                * @return Transaction priority
+                */
+               uint32_t getPriority();
+
                //! Start a new transaction
                /** This method generates the creation of a Transaction object which is then forwarded
                 * to the lowest level Slave in the memory bus tree. The passed addres is relative
@@ -184,8 +275,156 @@ namespace rogue {
                 */
                uint32_t reqTransaction(uint64_t address, uint32_t size, void *data, uint32_t type);
 
+               //! Start a new transaction with its own timeout
+               /** This method behaves as reqTransaction but the Transaction deadline is set
+                * the passed timeout past the time it is issued, instead of using the Master
+                * timeout. This is used to carry the remaining budget of a Transaction
+                * across a bridge.
+                *
+                * Not exposted to Python
+                * @param address Relative 64-bit transaction offset address
+                * @param size Transaction size in bytes
+                * @param data Pointer to data array used for transaction.
+                * @param type Transaction type
+                * @param timeout Timeout in microseconds, 0 to use the Master timeout
+                * @return 32-bit transaction id
+                */
+               uint32_t reqTransactionTimeout(uint64_t address, uint32_t size, void *data, uint32_t type, uint64_t timeout);
+
+               //! Start a new transaction with a completion callback
+               /** This method behaves as reqTransaction but does not require a call
+                * to waitTransaction. Instead the passed callback is executed with the
+                * transaction id and error value once the Transaction completes or times 
+                * out. Callbacks are executed in order of completion from a single 
+                * completion thread owned by this Master, allowing a large number of 
+                * transactions to be kept in flight without a thread per requester.
+                * Callbacks should not block. The data buffer must remain valid until the
+                * callback is executed.
+                *
+                * Not exposted to Python (see reqTransactionAsyncPy)
+                * @param address Relative 64-bit transaction offset address
+                * @param size Transaction size in bytes
+                * @param data Pointer to data array used for transaction.
+                * @param type Transaction type
+                * @param callback Completion callback, called with id and error value
+                * @return 32-bit transaction id
+                */
+               uint32_t reqTransactionAsync(uint64_t address, uint32_t size, void *data, uint32_t type, AsyncCallback callback);
+
+               //! Start a new transaction and return a future for its result
+               /** The returned future is set with the transaction error value, 0
+                * for success, once the Transaction completes or times out. The
+                * data buffer must remain valid until the future is ready.
+                *
+                * Not exposted to Python
+                * @param address Relative 64-bit transaction offset address
+                * @param size Transaction size in bytes
+                * @param data Pointer to data array used for transaction.
+                * @param type Transaction type
+                * @return Future holding the transaction error value
+                */
+               std::future<uint32_t> reqTransactionFuture(uint64_t address, uint32_t size, void *data, uint32_t type);
+
+               //! Start a list of new transactions
+               /** This method behaves as a call to reqTransaction for each passed request, but 
+                * the Master lock is only taken once for the full list. The ids of the started 
+                * transactions are returned in the passed ids vector, in request order.
+                *
+                * Not exposted to Python (see reqTransactionsPy)
+                * @param reqs List of transaction requests
+                * @param ids Vector to be filled with the transaction ids
+                */
+               void reqTransactions(const std::vector<Request> & reqs, std::vector<uint32_t> & ids);
+
+               //! Wait for a list of transactions to complete
+               /** The errors vector is filled with the error value of each transaction, in the
+                * order of the passed ids. Ids which are not pending return 0. The Master
+                * error value is updated in the same way as waitTransaction().
+                *
+                * Not exposted to Python (see waitTransactionsPy)
+                * @param ids List of transaction ids to wait for
+                * @param errors Vector to be filled with the transaction errors
+                */
+               void waitTransactions(const std::vector<uint32_t> & ids, std::vector<uint32_t> & errors);
+
+               //! Copy bits between two byte arrays
+               /** Bits in the destination range are replaced with the source bits, bits
+                * outside of the range are not changed. Ranges with matching bit alignment are
+                * copied with memcpy, others are shifted 64 bits per step (128 with SSE2).
+                *
+                * Not exposed to Python
+                * @param dst Destination byte array
+                * @param dstLsb Least signficant bit in destination byte array for copy
+                * @param src Source byte array
+                * @param srcLsb Least significant bit in source byte array for copy
+                * @param size Number of bits to copy
+                */
+               static void copyBits(uint8_t *dst, uint32_t dstLsb, const uint8_t *src, uint32_t srcLsb, uint32_t size);
+
+               //! Set a range of bits in a byte array
+               /** Not exposed to Python
+                * @param dst Destination byte array
+                * @param lsb Least signficant bit in destination byte array for set
+                * @param size Number of bits to set
+                */
+               static void setBits(uint8_t *dst, uint32_t lsb, uint32_t size);
+
+               //! Return true if any bits in a range of a byte array are set
+               /** Not exposed to Python
+                * @param src Source byte array to check
+                * @param lsb Least signficant bit in source byte array to check
+                * @param size Number of bits to check
+                */
+               static bool anyBits(const uint8_t *src, uint32_t lsb, uint32_t size);
+
+               //! Reference version of copyBits, processing one bit per step
+               /** Source bits are ORed into the destination range. Kept as the test
+                * oracle for copyBits.
+                *
+                * Not exposed to Python
+                * @param dst Destination byte array
+                * @param dstLsb Least signficant bit in destination byte array for copy
+                * @param src Source byte array
+                * @param srcLsb Least significant bit in source byte array for copy
+                * @param size Number of bits to copy
+                */
+               static void copyBitsRef(uint8_t *dst, uint32_t dstLsb, const uint8_t *src, uint32_t srcLsb, uint32_t size);
+
+               //! Reference version of setBits, processing one bit per step
+               /** Not exposed to Python
+                * @param dst Destination byte array
+                * @param lsb Least signficant bit in destination byte array for set
+                * @param size Number of bits to set
+                */
+               static void setBitsRef(uint8_t *dst, uint32_t lsb, uint32_t size);
+
+               //! Reference version of anyBits, processing one bit per step
+               /** Not exposed to Python
+                * @param src Source byte array to check
+                * @param lsb Least signficant bit in source byte array to check
+                * @param size Number of bits to check
+                */
+               static bool anyBitsRef(const uint8_t *src, uint32_t lsb, uint32_t size);
+
 #ifndef NO_PYTHON
 
+               //! Python version of reqTransactions
+               /** Each entry in the passed list is a tuple of (address, byte array, size, 
+                * offset, type) with the same meaning as the _reqTransaction arguments. 
+                *
+                * Exposted to Python as _reqTransactions()
+                * @param reqs List of request tuples
+                * @return List of transaction ids
+                */
+               boost::python::list reqTransactionsPy(boost::python::object reqs);
+
+               //! Python version of waitTransactions
+               /** Exposted to Python as _waitTransactions()
+                * @param ids List of transaction ids
+                * @return List of transaction error values
+                */
+               boost::python::list waitTransactionsPy(boost::python::object ids);
+
                //! Python version of reqTransaction. Takes a byte array instead of a data pointer.
                /** This method generates the creation of a Transaction object which is then forwarded
                 * to the lowest level Slave in the memory bus tree. The passed addres is relative
@@ -202,8 +441,26 @@ namespace rogue {
                 */
                uint32_t reqTransactionPy(uint64_t address, boost::python::object p, uint32_t size, uint32_t offset, uint32_t type);
 
+               //! Python version of reqTransactionAsync. Takes a byte array instead of a data pointer.
+               /** The callback is called as callback(id, error) from the completion thread
+                * of this Master once the Transaction completes or times out. A reference to 
+                * the byte array is held until the Transaction is complete.
+                *
+                * Exposted to Python as _reqTransactionAsync()
+                * @param address Relative 64-bit transaction offset address
+                * @param p Byte array used for transaction data
+                * @param size Transaction size in bytes
+                * @param offset Offset within byte array for transaction
+                * @param type Transaction type
+                * @param callback Python callable
+                * @return 32-bit transaction id
+                */
+               uint32_t reqTransactionAsyncPy(uint64_t address, boost::python::object p, uint32_t size, 
+                                              uint32_t offset, uint32_t type, boost::python::object callback);
+
                //! Helper function to optmize bit copies between byte arrays.
-               /** This method will copy bits between two byte arrays.
+               /** This method will copy bits between two byte arrays. Bits in the 
+                * destination range are replaced, bits outside of the range are not changed.
                 *
                 * Exposed to python as _copyBits
                 * @param dst Destination Python byte array
@@ -234,13 +491,67 @@ namespace rogue {
                 */
                static bool anyBits(boost::python::object src, uint32_t lsb, uint32_t size);
 
+               //! Python version of copyBitsRef
+               /** Exposed to python as _copyBitsRef
+                * @param dst Destination Python byte array
+                * @param dstLsb Least signficant bit in destination byte array for copy
+                * @param src Source Python byte array
+                * @param srcLsb Least significant bit in source byte array for copy
+                * @param size Number of bits to copy
+                */
+               static void copyBitsRef(boost::python::object dst, uint32_t dstLsb, boost::python::object src, uint32_t srcLsb, uint32_t size);
+
+               //! Python version of setBitsRef
+               /** Exposed to python as _setBitsRef
+                * @param dst Destination Python byte array
+                * @param lsb Least signficant bit in destination byte array for set
+                * @param size Number of bits to set
+                */
+               static void setBitsRef(boost::python::object dst, uint32_t lsb, uint32_t size);
+
+               //! Python version of anyBitsRef
+               /** Exposed to python as _anyBitsRef
+                * @param src Source Python byte array to check
+                * @param lsb Least signficant bit in source byte array to check
+                * @param size Number of bits to check
+                */
+               static bool anyBitsRef(boost::python::object src, uint32_t lsb, uint32_t size);
+
 #endif
 
             protected:
 
+               //! Global count of setSlave() calls, used to invalidate cached tree paths
+               static std::atomic<uint64_t> slaveEpoch_;
+
                //! Internal transaction
                uint32_t intTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
 
+               //! Forward a list of transactions, taking the Master lock once
+               void bulkTransaction(std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> > & trans);
+
+               //! Get a transaction from the free list or create a new one
+               std::shared_ptr<rogue::interfaces::memory::Transaction> allocTransaction();
+
+               //! Forward an asynchronous transaction
+               uint32_t asyncTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran, AsyncCallback cb);
+
+               //! Return a completed transaction to the free list if no other references remain
+               void freeTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran);
+
+               //! Stop the asynchronous completion thread
+               /** Waits for a running callback to return. Callbacks of transactions still
+                * in flight are discarded. A sub-class whose callbacks reference its own
+                * members should call this from its destructor.
+                */
+               void stopAsync();
+
+#ifndef NO_PYTHON
+               //! Setup a transaction with a python buffer
+               std::shared_ptr<rogue::interfaces::memory::Transaction> pyTransaction(uint64_t address, boost::python::object p, 
+                                                                                     uint32_t size, uint32_t offset, uint32_t type);
+#endif
+
             public:
 
                //! Wait for one or more transactions to complete
@@ -0,0 +1,249 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Poller
+ * ----------------------------------------------------------------------------
+ * File       : Poller.h
+ * Created    : 2019-01-15
+ * ----------------------------------------------------------------------------
+ * Description:
+ * Periodic poll scheduler for memory Blocks.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_POLLER_H__
+#define __ROGUE_INTERFACES_MEMORY_POLLER_H__
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <condition_variable>
+#include <rogue/interfaces/memory/Block.h>
+#include <rogue/Logging.h>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         class Slave;
+
+         //! Memory block poller
+         /** The Poller owns the poll schedule for a set of Blocks. Blocks are held in a
+          * hashed timer wheel with a configurable tick. On each tick the Blocks which are
+          * due are read into their poll buffers, with the reads for each Slave issued as
+          * a single bulk request and waited on together. Poll reads are issued with
+          * PriorityLow so that a PriorityHub serves control accesses ahead of them, and
+          * with the longest timeout of the Blocks in the request.
+          *
+          * A poll result is not applied to a Block which has started a write since the
+          * poll read was issued, so a late poll never replaces newer data.
+          *
+          * Blocks whose data changed since the previous poll, or whose read failed, are
+          * reported once per tick. From Python the registered callback is called with
+          * a list of (block, error) tuples, holding the GIL once for the full list. When
+          * no callback is registered the poll data is copied into the block data directly.
+          *
+          * Poll and jitter statistics are kept per Block. Jitter is the difference between
+          * the scheduled and actual start of a poll.
+          */
+         class Poller {
+
+               // Number of timer wheel slots
+               static const uint32_t Slots = 1024;
+
+               // Poll entry
+               struct Entry {
+                  std::shared_ptr<rogue::interfaces::memory::Block> block;
+                  uint64_t interval;
+                  uint64_t due;
+                  uint32_t gen;
+                  bool     enable;
+
+                  uint64_t polls;
+                  uint64_t changes;
+                  uint64_t errors;
+                  uint64_t jitterSum;
+                  uint64_t jitterMax;
+               };
+
+               // Wheel slot reference, stale once the entry generation changes
+               struct Ref {
+                  rogue::interfaces::memory::Block * block;
+                  uint32_t gen;
+               };
+
+               // Poll in progress, holds the block until the poll completes.
+               // The reference may be the last one to a python owned block.
+               struct Poll {
+                  std::shared_ptr<rogue::interfaces::memory::Block> block;
+                  uint32_t gen;
+                  uint64_t jitter;
+                  uint32_t error;
+                  bool     notify;
+               };
+
+               // Poll entries, keyed by block
+               std::map<rogue::interfaces::memory::Block *, Entry> entries_;
+
+               // Timer wheel
+               std::vector<Ref> wheel_[Slots];
+
+               // Tick period and current tick
+               std::chrono::microseconds tickTime_;
+               std::chrono::steady_clock::time_point startTime_;
+               uint64_t tick_;
+
+               // Generation counter
+               uint32_t gen_;
+
+               // Bulk read masters, one per slave
+               std::map<rogue::interfaces::memory::Slave *, std::shared_ptr<rogue::interfaces::memory::Master> > masters_;
+
+               // Statistics
+               uint64_t batches_;
+               uint64_t maxBatch_;
+               uint64_t lateTicks_;
+
+               // Schedule lock
+               std::mutex pollMtx_;
+               std::condition_variable cond_;
+
+               // Poll thread
+               std::thread * thread_;
+               bool threadEn_;
+
+#ifndef NO_PYTHON
+               // Update callback, callback_ is only accessed with the GIL held
+               boost::python::object callback_;
+               std::atomic<bool> callbackEn_;
+#endif
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Place an entry in the wheel, pollMtx_ must be held
+               void schedule(Entry & entry);
+
+               // Read a batch of blocks and report changes
+               void poll(std::vector<Poll> & batch);
+
+               // Poll thread
+               void runThread();
+
+            public:
+
+               //! Class factory which returns a pointer to a Poller object (PollerPtr)
+               /** Exposed to Python as rogue.interfaces.memory.Poller()
+                * @param tick Timer wheel tick in microseconds, the resolution of poll intervals
+                * @return Poller pointer (PollerPtr)
+                */
+               static std::shared_ptr<rogue::interfaces::memory::Poller> create (uint32_t tick);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a Poller object
+               Poller(uint32_t tick);
+
+               // Destroy the Poller object
+               ~Poller();
+
+               //! Start the poll thread
+               /** Exposed to Python as start()
+                */
+               void start();
+
+               //! Stop the poll thread
+               /** Exposed to Python as stop()
+                */
+               void stop();
+
+               //! Add a block to the poll schedule or update its interval
+               /** The block is polled on the next tick and then at the passed interval.
+                *
+                * Exposed to Python as addBlock()
+                * @param block Block to poll
+                * @param interval Poll interval in seconds
+                */
+               void addBlock(std::shared_ptr<rogue::interfaces::memory::Block> block, double interval);
+
+               //! Remove a block from the poll schedule
+               /** Exposed to Python as removeBlock()
+                * @param block Block to remove
+                */
+               void removeBlock(std::shared_ptr<rogue::interfaces::memory::Block> block);
+
+               //! Enable or disable polling of a block without changing its schedule
+               /** Exposed to Python as setEnable()
+                * @param block Block to update
+                * @param enable Enable state
+                */
+               void setEnable(std::shared_ptr<rogue::interfaces::memory::Block> block, bool enable);
+
+               //! Get the poll interval of a block
+               /** Exposed to Python as getInterval()
+                * @param block Block to query
+                * @return Poll interval in seconds, zero if the block is not polled
+                */
+               double getInterval(std::shared_ptr<rogue::interfaces::memory::Block> block);
+
+               //! Get the number of polled blocks
+               /** Exposed to Python as getCount()
+                * @return Number of blocks in the poll schedule
+                */
+               uint32_t getCount();
+
+               //! Reset poll statistics
+               /** Exposed to Python as resetStats()
+                */
+               void resetStats();
+
+#ifndef NO_PYTHON
+
+               //! Set the update callback
+               /** The callback is called from the poll thread with a list of (block, error)
+                * tuples for the blocks which changed or failed during a tick. The callback
+                * is responsible for moving the poll data into the block data, see Block::pollApply().
+                *
+                * Exposed to Python as setCallback()
+                * @param callback Python callable, or None to apply poll data natively
+                */
+               void setCallback(boost::python::object callback);
+
+               //! Get poll statistics
+               /** Returns a dictionary with the tick period, batch count, largest batch,
+                * late tick count and a list of per block statistics. Each block entry holds
+                * the block, interval, poll count, change count, error count and the average
+                * and maximum jitter in seconds.
+                *
+                * Exposed to Python as getStats()
+                * @return Python dictionary
+                */
+               boost::python::dict getStats();
+
+#endif
+         };
+
+         //! Alias for using shared pointer as PollerPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::Poller> PollerPtr;
+
+      }
+   }
+}
+
+#endif
+
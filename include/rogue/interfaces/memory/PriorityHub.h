@@ -0,0 +1,186 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Priority Hub
+ * ----------------------------------------------------------------------------
+ * File       : PriorityHub.h
+ * Created    : 2019-01-22
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which schedules transactions by priority.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_PRIORITY_HUB_H__
+#define __ROGUE_INTERFACES_MEMORY_PRIORITY_HUB_H__
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <rogue/interfaces/memory/Hub.h>
+#include <rogue/Logging.h>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface Priority Hub
+         /** The PriorityHub holds a queue per transaction priority (see Constants) and
+          * limits the number of transactions outstanding at the next level Slave. When a
+          * slot is free the oldest transaction of the highest priority lane is forwarded,
+          * so that a burst of low priority polling never sits in front of a control write.
+          *
+          * To protect lower lanes from starvation, a transaction which has waited longer
+          * than the starvation limit is forwarded ahead of higher priority work.
+          *
+          * Transactions are forwarded with a copy of their data, the priority is carried
+          * to the next level. Per lane counts, queue wait and completion latency are kept.
+          */
+         class PriorityHub : public Hub {
+
+               // Number of priority lanes
+               static const uint32_t Lanes = 3;
+
+               // Queued transaction
+               struct Queued {
+                  std::shared_ptr<rogue::interfaces::memory::Transaction> tran;
+                  std::chrono::steady_clock::time_point queued;
+               };
+
+               // Lane statistics
+               struct LaneStats {
+                  uint64_t count;
+                  uint64_t errors;
+                  uint64_t promoted;
+                  uint64_t waitSum;
+                  uint64_t waitMax;
+                  uint64_t latSum;
+                  uint64_t latMax;
+                  uint64_t maxDepth;
+               };
+
+               // Lane queues
+               std::deque<Queued> lanes_[Lanes];
+
+               // Lane statistics
+               LaneStats laneStats_[Lanes];
+
+               // Max outstanding transactions, 0 for unlimited
+               uint32_t depth_;
+
+               // Outstanding transactions
+               uint32_t outstanding_;
+
+               // Starvation limit
+               std::chrono::microseconds starve_;
+
+               // Lock
+               std::mutex prioMtx_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Forward queued transactions while slots are free
+               void dispatch();
+
+               // Forward a transaction
+               void forward(Queued & q, uint32_t lane);
+
+            public:
+
+               //! Class factory which returns a pointer to a PriorityHub (PriorityHubPtr)
+               /** Exposed to Python as rogue.interfaces.memory.PriorityHub()
+                *
+                * @param offset The offset of this Hub device
+                * @param depth Max outstanding transactions at the next level, 0 for unlimited
+                */
+               static std::shared_ptr<rogue::interfaces::memory::PriorityHub> create (uint64_t offset, uint32_t depth);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a PriorityHub device with a given offset
+               PriorityHub(uint64_t offset, uint32_t depth);
+
+               // Destroy the PriorityHub
+               ~PriorityHub();
+
+               //! Set the max outstanding transactions
+               /** Exposed to Python as setDepth()
+                * @param depth Max outstanding transactions at the next level, 0 for unlimited
+                */
+               void setDepth(uint32_t depth);
+
+               //! Get the max outstanding transactions
+               /** Exposed to Python as getDepth()
+                * @return Max outstanding transactions
+                */
+               uint32_t getDepth();
+
+               //! Set the starvation limit
+               /** Exposed to Python as setStarvation()
+                * @param limit Max queue wait in microseconds before a transaction is
+                *        forwarded ahead of higher priority lanes, 0 to disable
+                */
+               void setStarvation(uint32_t limit);
+
+               //! Get the number of queued transactions in a lane
+               /** Exposed to Python as getQueued()
+                * @param priority Lane priority
+                * @return Queued transaction count
+                */
+               uint32_t getQueued(uint32_t priority);
+
+               //! Get the number of outstanding transactions
+               /** Exposed to Python as getOutstanding()
+                * @return Outstanding transaction count
+                */
+               uint32_t getOutstanding();
+
+               //! Reset lane statistics
+               /** Exposed to Python as resetStats()
+                */
+               void resetStats();
+
+#ifndef NO_PYTHON
+
+               //! Get lane statistics
+               /** Returns a dictionary keyed by lane priority. Each entry holds the
+                * transaction, error and promotion counts, the largest queue depth and the
+                * average and maximum queue wait and latency in seconds.
+                *
+                * Exposed to Python as getStats()
+                * @return Python dictionary
+                */
+               boost::python::dict getStats();
+
+#endif
+
+               //! Interface to service the transaction request from an attached master
+               /** The local address offset is applied and the transaction is queued
+                * in the lane for its priority.
+                *
+                * Not exposted to Python
+                * @param transaction Transaction pointer as TransactionPtr
+                */
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as PriorityHubPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::PriorityHub> PriorityHubPtr;
+      }
+   }
+}
+
+#endif
+
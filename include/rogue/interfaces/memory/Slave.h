@@ -22,6 +22,9 @@
 #include <stdint.h>
 #include <vector>
 #include <map>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
 #include <rogue/interfaces/memory/Master.h>
 
 #ifndef NO_PYTHON
@@ -42,9 +45,28 @@ namespace rogue {
           * Examples of Slave sub-class implementations are included elsewhere in this document.
           *
           * The Slave object provides mechanisms for tracking current transactions.
+          * Tracked transactions are held in a fixed table indexed by transaction ID, 
+          * with an overflow map for colliding IDs, and their timeouts are managed by 
+          * a hashed timer wheel serviced by a background thread. The table and thread 
+          * are only created once the first transaction is tracked.
           */
          class Slave {
 
+               // Size of the transaction table, must be a power of 2
+               static const uint32_t TableSize = 4096;
+
+               // Number of timer wheel slots
+               static const uint32_t WheelSize = 512;
+
+               // Timer wheel tick period in microseconds
+               static const uint32_t WheelTick = 10000;
+
+               // Timer wheel entry, transaction ID and the tick it is due
+               struct WheelEntry {
+                  uint32_t id;
+                  uint64_t tick;
+               };
+
                // Class instance counter
                static uint32_t classIdx_;
 
@@ -57,8 +79,26 @@ namespace rogue {
                // Alias for map
                typedef std::map<uint32_t, std::shared_ptr<rogue::interfaces::memory::Transaction> > TransactionMap;
 
-               // Transaction map
-               TransactionMap tranMap_;
+               // Transaction table, indexed by the low bits of the transaction ID
+               std::vector<std::shared_ptr<rogue::interfaces::memory::Transaction> > tranTable_;
+
+               // Overflow map for transactions colliding in the table
+               TransactionMap tranOver_;
+
+               // Number of tracked transactions
+               uint32_t tranCount_;
+
+               // Timer wheel
+               std::vector<std::vector<WheelEntry> > wheel_;
+
+               // Timer wheel base time and last processed tick
+               std::chrono::steady_clock::time_point wheelBase_;
+               uint64_t wheelTick_;
+
+               // Timer wheel thread
+               std::thread * wheelThread_;
+               bool wheelEn_;
+               std::condition_variable wheelCond_;
 
                // Slave lock
                std::mutex slaveMtx_;
@@ -88,6 +128,42 @@ namespace rogue {
                // Destroy the Slave
                virtual ~Slave();
 
+            private:
+
+               // Find a tracked transaction, slaveMtx_ must be held
+               std::shared_ptr<rogue::interfaces::memory::Transaction> findTransaction(uint32_t id);
+
+               // Remove a tracked transaction, slaveMtx_ must be held
+               bool removeTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
+
+               // Schedule a timer wheel entry, slaveMtx_ must be held
+               void schedule(uint32_t id, std::chrono::steady_clock::time_point time);
+
+               // Timer wheel thread
+               void runWheel();
+
+            protected:
+
+               //! Stop the timer wheel thread
+               /** A sub-class which overrides expireTransaction() should call this 
+                * method from its destructor.
+                */
+               void stopWheel();
+
+               //! Called when a tracked transaction has timed out
+               /** This method is called from the timer wheel thread when a transaction 
+                * which was added with addTransaction() reaches its deadline, or is abandoned 
+                * by its Master, without being retrieved. The transaction has already been removed from the tracking 
+                * table. By default the transaction is completed with a TimeoutError. A 
+                * sub-class may override this method to perform additional cleanup.
+                *
+                * Not exposed to Python
+                * @param transaction Pointer to transaction as TransactionPtr
+                */
+               virtual void expireTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+
+            public:
+
                //! Add a transaction to the internal tracking map
                /** This method is called by the sub-class to add a transaction into the local
                 * tracking map for later retrieval. This is used when the transaction will be
@@ -102,8 +178,7 @@ namespace rogue {
                /** This method is called by the sub-class to retrieve an existing transaction
                 * using the unique transaction ID. If the transaction exists in the list the
                 * pointer to that transaction will be returned. If not a NULL pointer will be
-                * returned. When getTransaction() is called the map will also be checked for
-                * stale transactions which will be removed from the map.
+                * returned.
                 *
                 * Exposed to python as _getTransaction()
                 * @param index ID of transaction to lookup
@@ -111,6 +186,15 @@ namespace rogue {
                 */
                std::shared_ptr<rogue::interfaces::memory::Transaction> getTransaction(uint32_t index);
 
+               //! Get the number of transactions in the internal tracking map
+               /** Timed out transactions are removed by the timer wheel. This allows 
+                * a Slave sub-class to limit the number of outstanding transactions.
+                *
+                * Not exposted to Python
+                * @return Number of tracked transactions
+                */
+               uint32_t tranCount();
+
                //! Get min size from slave
                /** Not exposted to Python
                 * @return Minimum transaction size
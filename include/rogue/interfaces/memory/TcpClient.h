@@ -22,6 +22,8 @@
 #include <rogue/interfaces/memory/Slave.h>
 #include <rogue/Logging.h>
 #include <thread>
+#include <deque>
+#include <condition_variable>
 #include <stdint.h>
 
 namespace rogue {
@@ -35,6 +37,18 @@ namespace rogue {
           * TCP bridge implments a memory Master device which executes the memory Transaction 
           * to an attached Slave.
           *
+          * Transactions are queued and sent to the server in batches. All transactions which
+          * are pending when the send thread wakes up are packed into a single request message
+          * and the server returns the results in batched response messages. The number of
+          * transactions which may be outstanding in the bridge is limited by a configurable
+          * window. Once the window is full the doTransaction() call will block until the
+          * server responds or the oldest transactions expire.
+          *
+          * Each request carries the time remaining before the Transaction deadline, so
+          * the server side Transaction expires with the original. Transactions which expire
+          * while waiting for window space, or while queued, are completed with a
+          * TimeoutError without being sent.
+          *
           * The TcpClient memory interface will drop transactions when the remote server is not 
           * present or when the pipeline backs up.
           */
@@ -55,9 +69,18 @@ namespace rogue {
                // Zeromq outbound port
                void * zmqResp_;
 
+               // Request record header size: id, addr, size, type, remaining time
+               static const uint32_t ReqHeadSize  = 24;
+
+               // Response record header size: id, addr, size, type, result
+               static const uint32_t RespHeadSize = 24;
+
                // Thread background
                void runThread();
 
+               // Send thread background
+               void runSendThread();
+
                // Log
                std::shared_ptr<rogue::Logging> bridgeLog_;
 
@@ -65,9 +88,24 @@ namespace rogue {
                std::thread * thread_;
                bool threadEn_;
 
+               // Send thread
+               std::thread * sendThread_;
+
                // Lock
                std::mutex bridgeMtx_;
 
+               // Pending transactions waiting to be sent
+               std::deque<std::shared_ptr<rogue::interfaces::memory::Transaction> > sendQueue_;
+
+               // Send queue condition
+               std::condition_variable sendCond_;
+
+               // Window condition
+               std::condition_variable winCond_;
+
+               // Max outstanding transactions
+               uint32_t window_;
+
             public:
 
                //! Create a TcpClient object and return as a TcpServerPtr
@@ -97,8 +135,22 @@ namespace rogue {
                // Close the connections
                void close();
 
+               //! Set the transaction window
+               /** Set the maximum number of transactions which may be outstanding in
+                * the bridge, including transactions waiting to be sent. The default is 256.
+                *
+                * Exposed as setWindow() to Python
+                * @param window Max number of outstanding transactions
+                */
+               void setWindow(uint32_t window);
+
                // Process transaction from Master
                void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
+
+            protected:
+
+               //! Free the window slot of a timed out transaction
+               void expireTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
          };
 
          //! Alias for using shared pointer as TcpClientPtr
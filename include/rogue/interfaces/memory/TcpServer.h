@@ -34,6 +34,12 @@ namespace rogue {
           * the memory Transaction to an attached Slave. On the other end of the link a
           * TcpClient accepts a memory Transaction from an attached Master and forwards it to
           * this TcpSver.
+          *
+          * Requests arrive as batches of transaction records. All transactions received in
+          * a batch are dispatched to the attached Slave before waiting on any of them so
+          * that the downstream Slave can service them concurrently. The results are returned
+          * in a single batched response message. Each Transaction is issued with the time
+          * remaining before the deadline of the client side Transaction as its timeout.
           */
          class TcpServer : public rogue::interfaces::memory::Master {
 
@@ -52,6 +58,15 @@ namespace rogue {
                // Zeromq outbound port
                void * zmqResp_;
 
+               // Request record header size: id, addr, size, type, remaining time
+               static const uint32_t ReqHeadSize  = 24;
+
+               // Response record header size: id, addr, size, type, result
+               static const uint32_t RespHeadSize = 24;
+
+               // Max number of request messages to combine into a single dispatch
+               static const uint32_t MaxBatch = 64;
+
                // Thread background
                void runThread();
 
@@ -0,0 +1,181 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Trace Hub
+ * ----------------------------------------------------------------------------
+ * File       : TraceHub.h
+ * Created    : 2019-01-28
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which records transactions to a trace file.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_TRACE_HUB_H__
+#define __ROGUE_INTERFACES_MEMORY_TRACE_HUB_H__
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <rogue/interfaces/memory/Hub.h>
+#include <rogue/Logging.h>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface Trace Hub
+         /** The TraceHub records every transaction passing through it to a binary trace
+          * file, which can be re-issued against any Slave with a TraceReplay Master.
+          * While no file is open transactions are passed through as in a plain Hub.
+          *
+          * The file starts with a 32-bit magic value (TraceMagic) and a 32-bit version
+          * (TraceVersion). It is followed by one record per completed transaction, all
+          * values little endian:
+          *
+          *    [31:0]  Record length in bytes, excluding this word
+          *    [31:24] Transaction type
+          *    [23:16] Flags, bit 0 set if the record holds data
+          *    [15:0]  Reserved
+          *    [63:0]  Request time in microseconds since the file was opened
+          *    [63:0]  Address, with the offset of this Hub applied
+          *    [31:0]  Size in bytes
+          *    [31:0]  Error value
+          *    [31:0]  Latency in microseconds
+          *    Data, size bytes. Write data for Write and Post transactions, the
+          *    returned data for Read and Verify transactions.
+          *
+          * Records are written in completion order.
+          */
+         class TraceHub : public Hub {
+
+            public:
+
+               //! Trace file magic value
+               static const uint32_t TraceMagic = 0x43525452;
+
+               //! Trace file version
+               static const uint32_t TraceVersion = 1;
+
+               //! Size of the fixed part of a record, including the length word
+               static const uint32_t RecordHeader = 36;
+
+               //! Flag set in records which hold data
+               static const uint32_t FlagData = 0x1;
+
+            private:
+
+               // Size at which the record buffer is written to the file
+               static const uint32_t FlushSize = 1048576;
+
+               // File descriptor
+               int32_t fd_;
+
+               // Record buffer
+               std::vector<uint8_t> buffer_;
+
+               // Data recording enable
+               bool dataEn_;
+
+               // Record count and file size
+               uint64_t count_;
+               uint64_t size_;
+
+               // Time the file was opened
+               std::chrono::steady_clock::time_point start_;
+
+               // Lock
+               std::mutex traceMtx_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Write the record buffer to the file, traceMtx_ must be held
+               void flush();
+
+               // Append a record, traceMtx_ must be held
+               void record(uint32_t type, uint64_t time, uint64_t address, uint32_t size,
+                           uint32_t error, uint32_t latency, uint8_t *data);
+
+            public:
+
+               //! Class factory which returns a pointer to a TraceHub (TraceHubPtr)
+               /** Exposed to Python as rogue.interfaces.memory.TraceHub()
+                *
+                * @param offset The offset of this Hub device
+                */
+               static std::shared_ptr<rogue::interfaces::memory::TraceHub> create (uint64_t offset);
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a TraceHub device with a given offset
+               TraceHub(uint64_t offset);
+
+               // Destroy the TraceHub
+               ~TraceHub();
+
+               //! Open a trace file and start recording
+               /** An existing file is replaced.
+                *
+                * Exposed to Python as open()
+                * @param file Trace file name
+                */
+               void open(std::string file);
+
+               //! Stop recording and close the trace file
+               /** Transactions still in flight are not recorded.
+                *
+                * Exposed to Python as close()
+                */
+               void close();
+
+               //! Enable or disable recording of transaction data
+               /** Without data the file holds only the access pattern.
+                *
+                * Exposed to Python as setDataEnable()
+                * @param enable True to record data, the default
+                */
+               void setDataEnable(bool enable);
+
+               //! Get the number of recorded transactions
+               /** Exposed to Python as getCount()
+                * @return Record count since open
+                */
+               uint64_t getCount();
+
+               //! Get the size of the trace file
+               /** Exposed to Python as getSize()
+                * @return File size in bytes, including buffered records
+                */
+               uint64_t getSize();
+
+               //! Interface to service the transaction request from an attached master
+               /** The local address offset is applied. While recording, the transaction
+                * is forwarded with a copy of its data and recorded once it completes.
+                *
+                * Not exposted to Python
+                * @param transaction Transaction pointer as TransactionPtr
+                */
+               void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> transaction);
+         };
+
+         //! Alias for using shared pointer as TraceHubPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::TraceHub> TraceHubPtr;
+      }
+   }
+}
+
+#endif
+
@@ -0,0 +1,160 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Trace Replay
+ * ----------------------------------------------------------------------------
+ * File       : TraceReplay.h
+ * Created    : 2019-01-28
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface master which re-issues a recorded transaction trace.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_TRACE_REPLAY_H__
+#define __ROGUE_INTERFACES_MEMORY_TRACE_REPLAY_H__
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <rogue/interfaces/memory/Master.h>
+#include <rogue/Logging.h>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Memory interface Trace Replay Master
+         /** The TraceReplay loads a trace file written by a TraceHub and re-issues its
+          * transactions against the attached Slave, in request order. Transactions are
+          * issued either at their recorded times, scaled by a speed factor, or back to
+          * back at the maximum rate. In both cases the number of transactions in flight
+          * is limited by the replay depth.
+          *
+          * Read data is compared against the recorded data when the trace holds it, and
+          * write data is taken from the trace (zero filled when it does not). Throughput,
+          * latency and the latency recorded in the trace are reported by getStats().
+          */
+         class TraceReplay : public Master {
+
+               // Trace record
+               struct Record {
+                  uint64_t time;
+                  uint64_t address;
+                  uint32_t size;
+                  uint32_t type;
+                  uint32_t error;
+                  uint32_t latency;
+                  uint64_t offset;
+                  bool     data;
+               };
+
+               // Loaded records, in request order
+               std::vector<Record> records_;
+
+               // Recorded data, and replay data indexed by Record offset
+               std::vector<uint8_t> data_;
+               std::vector<uint8_t> work_;
+
+               // Max transactions in flight
+               uint32_t depth_;
+
+               // Transactions in flight
+               uint32_t outstanding_;
+
+               // Replay statistics
+               uint64_t count_;
+               uint64_t bytes_;
+               uint64_t errors_;
+               uint64_t mismatches_;
+               uint64_t latSum_;
+               uint64_t latMax_;
+               double   elapsed_;
+
+               // Lock and completion condition
+               std::mutex replayMtx_;
+               std::condition_variable replayCond_;
+
+               // Log
+               std::shared_ptr<rogue::Logging> log_;
+
+               // Record completion
+               void complete(uint32_t index, std::chrono::steady_clock::time_point sent, uint32_t error);
+
+            public:
+
+               //! Class factory which returns a pointer to a TraceReplay (TraceReplayPtr)
+               /** Exposed to Python as rogue.interfaces.memory.TraceReplay()
+                */
+               static std::shared_ptr<rogue::interfaces::memory::TraceReplay> create ();
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a TraceReplay
+               TraceReplay();
+
+               // Destroy the TraceReplay
+               ~TraceReplay();
+
+               //! Load a trace file
+               /** Exposed to Python as load()
+                * @param file Trace file name
+                */
+               void load(std::string file);
+
+               //! Get the number of loaded transactions
+               /** Exposed to Python as getCount()
+                * @return Record count
+                */
+               uint32_t getCount();
+
+               //! Set the max transactions in flight
+               /** Exposed to Python as setDepth()
+                * @param depth Max transactions in flight, 0 for unlimited. The default is 16.
+                */
+               void setDepth(uint32_t depth);
+
+               //! Re-issue the loaded trace and wait for it to complete
+               /** Exposed to Python as run()
+                * @param speed Rate relative to the recorded timing, 1.0 for the original
+                *        rate, 0 to issue transactions at the maximum rate
+                */
+               void run(double speed);
+
+#ifndef NO_PYTHON
+
+               //! Get statistics of the last run
+               /** Returns a dictionary with the transaction, byte, error and data mismatch
+                * counts, the elapsed and recorded durations in seconds, the transaction and
+                * byte rates and the average and maximum latency, replayed and recorded,
+                * in seconds.
+                *
+                * Exposed to Python as getStats()
+                * @return Python dictionary
+                */
+               boost::python::dict getStats();
+
+#endif
+         };
+
+         //! Alias for using shared pointer as TraceReplayPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::TraceReplay> TraceReplayPtr;
+      }
+   }
+}
+
+#endif
+
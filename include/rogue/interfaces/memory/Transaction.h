@@ -24,7 +24,11 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <sys/time.h>
 
 #ifndef NO_PYTHON
 #include <boost/python.hpp>
@@ -37,6 +41,8 @@ namespace rogue {
          class TransactionLock;
          class Master;
          class Hub;
+         class CoalesceHub;
+         class TransactionStats;
 
          //! Transaction Container
          /** The Transaction is passed between the Master and Slave to initiate a transaction. 
@@ -49,6 +55,12 @@ namespace rogue {
             friend class TransactionLock;
             friend class Master;
             friend class Hub;
+            friend class Slave;
+            friend class CoalesceHub;
+            friend class CacheHub;
+            friend class PriorityHub;
+            friend class ArbiterHub;
+            friend class TraceHub;
 
             public: 
                
@@ -58,24 +70,33 @@ namespace rogue {
             private:
 
                // Class instance counter
-               static uint32_t classIdx_;
+               static std::atomic<uint32_t> classIdx_;
 
-               // Class instance lock
-               static std::mutex classMtx_;
+               // Completion lock, protects done_ and error_ for the waiter
+               std::mutex condMtx_;
 
-               // Conditional
+               // Conditional, signaled on completion
                std::condition_variable cond_;
 
+               // Completion notifier, called by done() with the completion lock held
+               std::function<void(uint32_t)> notify_;
+
             protected:
 
                // Transaction timeout 
-               struct timeval timeout_;
+               std::chrono::microseconds timeout_;
 
-               // Transaction end time
-               struct timeval endTime_;
+               // Transaction deadline, fixed when the transaction is issued
+               std::chrono::steady_clock::time_point endTime_;
 
                // Transaction start time
-               struct timeval startTime_;
+               std::chrono::steady_clock::time_point startTime_;
+
+               // Transaction completion time
+               std::chrono::steady_clock::time_point doneTime_;
+
+               // Statistics recorder, set by the Master when enabled
+               std::shared_ptr<rogue::interfaces::memory::TransactionStats> stats_;
 
 #ifndef NO_PYTHON
                // Transaction python buffer
@@ -97,6 +118,9 @@ namespace rogue {
                // Transaction type
                uint32_t type_;
 
+               // Transaction priority
+               uint32_t priority_;
+
                // Transaction error
                uint32_t error_;
 
@@ -104,7 +128,7 @@ namespace rogue {
                uint32_t id_;
 
                // Done state
-               bool done_;
+               std::atomic<bool> done_;
 
                // Transaction lock
                std::mutex lock_;
@@ -115,6 +139,18 @@ namespace rogue {
                // Wait for the transaction to complete, called by Master
                uint32_t wait();
 
+               // Reset a completed transaction for reuse with a new id, called by Master
+               void reset(struct timeval timeout);
+
+               // Set completion notifier, called by Master for asynchronous transactions
+               void setNotify(std::function<void(uint32_t)> notify);
+
+               // Set the deadline, called by Master and by Hubs which forward a copy
+               void setDeadline(std::chrono::steady_clock::time_point deadline);
+
+               // Time out the transaction if its deadline has passed, returns true if done
+               bool expire();
+
             public:
 
                // Setup class for use in python
@@ -133,15 +169,33 @@ namespace rogue {
                std::shared_ptr<rogue::interfaces::memory::TransactionLock> lock();
 
                //! Get expired flag
-               /** The expired flag is set by the Master when the Transaction times out
-                * and the Master is no longer wiating for the Transaction to complete.
-                * Lock must be held before checking the expired status.
+               /** A Transaction is expired once its deadline has passed or the Master is
+                * no longer waiting for it to complete. Expired transactions should be
+                * dropped without being sent. Lock must be held before checking the
+                * expired status.
                 *
                 * Exposed as expired() to Python
                 * @return True if transaction is expired.
                 */
                bool expired();
 
+               //! Get the Transaction deadline
+               /** The deadline is fixed when the Master issues the Transaction and is
+                * not extended by later activity.
+                *
+                * Not exposed to Python
+                * @return Absolute deadline
+                */
+               std::chrono::steady_clock::time_point deadline();
+
+               //! Get the time remaining before the deadline
+               /** Used to carry the deadline across bridges to another process.
+                *
+                * Exposed as remaining() to Python
+                * @return Remaining time in microseconds, 0 if the deadline has passed
+                */
+               uint64_t remaining();
+
                //! Get 32-bit Transaction ID
                /** Exposed as id() to Python
                 * @return 32-bit transaction ID
@@ -167,19 +221,19 @@ namespace rogue {
                 */
                uint32_t type();
 
-               //! Refresh transaction timer
-               /** Called to refresh the Transaction timer. If the passed reference
-                * Transaction is NULL or the Transaction start time is later than the 
-                * reference transaction, the Transaction timer will be refreshed.
-                *
-                * Not exposed to Python
-                * @param reference Reference TransactionPtr
+               //! Get Transaction priority
+               /** The transaction priority values are defined in Constants, the
+                * priority is set by the issuing Master.
+                * Exposed as priority() to Python
+                * @return 32-bit Transaction priority
                 */
-               void refreshTimer(std::shared_ptr<rogue::interfaces::memory::Transaction> reference);
+               uint32_t priority();
 
                //! Complete transaction with passed error
                /** Lock must be held before calling this method. The
-                * error types are defined in Constants.
+                * error types are defined in Constants. The waiting Master
+                * is woken immediately. Completing a Transaction which has
+                * already timed out has no effect.
                 *
                 * Exposted as done() to Python
                 * @param error Transaction error value or 0 for no error.
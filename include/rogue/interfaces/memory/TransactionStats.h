@@ -0,0 +1,159 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Transaction Statistics
+ * ----------------------------------------------------------------------------
+ * File       : TransactionStats.h
+ * Created    : 2018-03-19
+ * ----------------------------------------------------------------------------
+ * Description:
+ * Latency, throughput and error statistics for memory transactions serviced 
+ * by a Slave device.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_INTERFACES_MEMORY_TRANSACTION_STATS_H__
+#define __ROGUE_INTERFACES_MEMORY_TRANSACTION_STATS_H__
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+#endif
+
+namespace rogue {
+   namespace interfaces {
+      namespace memory {
+
+         //! Transaction statistics for a Slave device
+         /** A TransactionStats object accumulates the submit to completion latency, byte
+          * count, error count and timeout count of transactions serviced by the Slave 
+          * device with a given Slave ID, separately for each transaction type. Latency is
+          * recorded in a histogram with power of 2 microsecond bins. Statistics are 
+          * recorded by the Master when it collects a completed transaction, and only
+          * when enabled, so disabled statistics cost a single flag check.
+          *
+          * One object exists per Slave ID and is created on first request.
+          */
+         class TransactionStats {
+
+            public:
+
+               //! Number of latency histogram bins
+               static const uint32_t HistBins = 24;
+
+            private:
+
+               // Per type statistics
+               struct TypeStats {
+                  uint64_t count;
+                  uint64_t bytes;
+                  uint64_t errors;
+                  uint64_t timeouts;
+                  uint64_t totalUs;
+                  uint64_t maxUs;
+                  uint64_t hist[HistBins];
+               };
+
+               // Registry of statistics objects by slave ID
+               static std::map<uint32_t, std::shared_ptr<rogue::interfaces::memory::TransactionStats> > registry_;
+
+               // Registry lock
+               static std::mutex regMtx_;
+
+               // Registry change count
+               static std::atomic<uint64_t> regEpoch_;
+
+               // Slave ID
+               uint32_t id_;
+
+               // Enable flag
+               std::atomic<bool> enable_;
+
+               // Statistics, indexed by transaction type
+               TypeStats stats_[4];
+
+               // Lock
+               std::mutex statMtx_;
+
+            public:
+
+               //! Get the statistics object for a Slave ID, creating it if needed
+               /** Exposed to Python as rogue.interfaces.memory.TransactionStats.get()
+                * @param id Slave ID as returned by reqSlaveId()
+                * @return TransactionStats pointer (TransactionStatsPtr)
+                */
+               static std::shared_ptr<rogue::interfaces::memory::TransactionStats> get(uint32_t id);
+
+               //! Get the statistics object for a Slave ID if it exists
+               /** Not exposed to Python
+                * @param id Slave ID
+                * @return TransactionStats pointer or NULL
+                */
+               static std::shared_ptr<rogue::interfaces::memory::TransactionStats> find(uint32_t id);
+
+               //! Get the registry change count, used by Masters to refresh cached lookups
+               static uint64_t epoch();
+
+               // Setup class for use in python
+               static void setup_python();
+
+               // Create a statistics object, use get()
+               TransactionStats(uint32_t id);
+
+               //! Enable or disable recording
+               /** Exposed to Python as setEnable()
+                * @param enable True to enable
+                */
+               void setEnable(bool enable);
+
+               //! Get enable state
+               /** Exposed to Python as getEnable()
+                * @return True if enabled
+                */
+               bool getEnable();
+
+               //! Clear all statistics
+               /** Exposed to Python as reset()
+                */
+               void reset();
+
+               //! Record a completed transaction
+               /** Not exposed to Python
+                * @param type Transaction type
+                * @param size Transaction size in bytes
+                * @param error Transaction error value
+                * @param latency Submit to completion time in microseconds
+                */
+               void record(uint32_t type, uint32_t size, uint32_t error, uint64_t latency);
+
+#ifndef NO_PYTHON
+               //! Get statistics as a dictionary
+               /** The dictionary is keyed by transaction type name. Each entry holds count,
+                * bytes, errors, timeouts, meanUs, maxUs and hist. Entry N of hist counts 
+                * transactions with a latency below 2^N microseconds and at least 2^(N-1).
+                *
+                * Exposed to Python as getStats()
+                * @return Python dictionary
+                */
+               boost::python::dict getStatsPy();
+#endif
+         };
+
+         //! Alias for using shared pointer as TransactionStatsPtr
+         typedef std::shared_ptr<rogue::interfaces::memory::TransactionStats> TransactionStatsPtr;
+      }
+   }
+}
+
+#endif
+
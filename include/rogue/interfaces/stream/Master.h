@@ -48,6 +48,9 @@ namespace rogue {
                // Vector of slaves
                std::vector<std::shared_ptr<rogue::interfaces::stream::Slave> > slaves_;
 
+               // Primary slave has been set, otherwise the default sink is used
+               bool primarySet_;
+
                // Slave mutex
                std::mutex slaveMtx_;
 
@@ -89,6 +92,15 @@ namespace rogue {
                 */
                void addSlave ( std::shared_ptr<rogue::interfaces::stream::Slave> slave );
 
+               //! Get the number of attached Slaves
+               /** Allows a Master to skip generating data which no Slave will receive.
+                * The default primary Slave, which discards frames, is not counted.
+                *
+                * Exposed as _slaveCount() to Python.
+                * @return Number of primary and secondary Slaves
+                */
+               uint32_t slaveCount ();
+
                //! Request new Frame to be allocated by primary Slave
                /** This method is called to create a new Frame oject. An empty Frame with 
                 * the requested payload capacity is create. The Master will forward this
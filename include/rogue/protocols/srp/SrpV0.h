@@ -23,6 +23,9 @@
 #define __ROGUE_PROTOCOLS_SRP_SRPV0_H__
 #include <stdint.h>
 #include <thread>
+#include <map>
+#include <mutex>
+#include <atomic>
 #include <rogue/interfaces/stream/Master.h>
 #include <rogue/interfaces/stream/Slave.h>
 #include <rogue/interfaces/memory/Slave.h>
@@ -49,10 +52,43 @@ namespace rogue {
                static const uint32_t RxHeadLen  = 8;
                static const uint32_t TailLen    = 4;
 
+               // Largest request carried by a single frame
+               static const uint32_t FrameMax = 2048;
+
+               // Largest transaction accepted, larger transactions are split into FrameMax requests
+               static const uint32_t SplitMax = 0xFFFFFFFC;
+
+               // State of a transaction split into multiple requests
+               struct Split {
+                  std::shared_ptr<rogue::interfaces::memory::Transaction> tran;
+                  uint32_t next;     // Offset of next request to send
+                  uint32_t recv;     // Bytes completed
+                  uint32_t pending;  // Requests in flight
+               };
+
+               // Split transactions, keyed by transaction id
+               std::map<uint32_t, Split> splitMap_;
+               std::mutex splitMtx_;
+
+               // Split requests kept in flight per transaction
+               std::atomic<uint32_t> depth_;
+
                // Setup header, return write flag
-               bool setupHeader(std::shared_ptr<rogue::interfaces::memory::Transaction> tran, 
+               bool setupHeader(uint32_t type, uint32_t id, uint64_t address, uint32_t size,
                                 uint32_t *header, uint32_t &headerLen, uint32_t &frameLen, bool tx);
 
+               // Send a request for a section of a transaction, transaction lock must be held
+               void sendRequest(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran, 
+                                uint32_t offset, uint32_t size);
+
+               // Send split requests up to the pipeline depth, transaction lock must be held
+               void sendSplit(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran);
+
+               // Process a response for a split transaction
+               void acceptSplit(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran,
+                                std::shared_ptr<rogue::interfaces::stream::Frame> & frame,
+                                uint32_t *header, uint32_t fSize);
+
             public:
 
                //! Class creation
@@ -67,6 +103,17 @@ namespace rogue {
                //! Deconstructor
                ~SrpV0();
 
+               //! Set the number of requests kept in flight for a split transaction
+               /** Transactions larger than a single frame are split into frame sized requests
+                * which complete the original transaction once all have completed. 
+                * Exposed to python as setSplitDepth()
+                * @param depth Number of outstanding requests per transaction
+                */
+               void setSplitDepth(uint32_t depth);
+
+               //! Get the number of requests kept in flight for a split transaction
+               uint32_t getSplitDepth();
+
                //! Post a transaction. Master will call this method with the access attributes.
                void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
 
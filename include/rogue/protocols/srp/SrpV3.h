@@ -23,6 +23,10 @@
 #define __ROGUE_PROTOCOLS_SRP_SRPV3_H__
 #include <stdint.h>
 #include <thread>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
 #include <rogue/interfaces/stream/Master.h>
 #include <rogue/interfaces/stream/Slave.h>
 #include <rogue/interfaces/memory/Slave.h>
@@ -47,10 +51,82 @@ namespace rogue {
                static const uint32_t HeadLen = 20;
                static const uint32_t TailLen = 4;
 
+               // Largest request carried by a single frame
+               static const uint32_t FrameMax = 4096;
+
+               // Largest transaction accepted, larger transactions are split into FrameMax requests
+               static const uint32_t SplitMax = 0xFFFFFFFC;
+
+               // State of a transaction split into multiple requests
+               struct Split {
+                  std::shared_ptr<rogue::interfaces::memory::Transaction> tran;
+                  uint32_t next;     // Offset of next request to send
+                  uint32_t recv;     // Bytes completed
+                  uint32_t pending;  // Requests in flight
+               };
+
+               // Split transactions, keyed by transaction id
+               std::map<uint32_t, Split> splitMap_;
+               std::mutex splitMtx_;
+
+               // Split requests kept in flight per transaction
+               std::atomic<uint32_t> depth_;
+
+               // Request waiting for a credit
+               struct Request {
+                  std::shared_ptr<rogue::interfaces::memory::Transaction> tran;
+                  uint32_t offset;
+                  uint32_t size;
+               };
+
+               // Requests waiting for a credit, in submission order
+               std::deque<Request> queue_;
+
+               // Requests in flight, keyed by transaction id
+               std::map<uint32_t, uint32_t> credits_;
+
+               // Outstanding request window, zero for no limit
+               uint32_t window_;
+
+               // Requests in flight
+               uint32_t outstanding_;
+
+               // Queue statistics
+               uint64_t stalls_;
+               uint32_t maxQueue_;
+
+               // Window lock
+               std::mutex winMtx_;
+
                // Setup header, return write flag
-               bool setupHeader(std::shared_ptr<rogue::interfaces::memory::Transaction> tran, 
+               bool setupHeader(uint32_t type, uint32_t id, uint64_t address, uint32_t size,
                                 uint32_t *header, uint32_t &frameLen, bool tx);
 
+               // Send a request for a section of a transaction, transaction lock must be held
+               void sendRequest(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran, 
+                                uint32_t offset, uint32_t size);
+
+               // Send a request if a credit is available, otherwise queue it, transaction lock must be held
+               void issueRequest(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran, 
+                                 uint32_t offset, uint32_t size);
+
+               // Return credits held by a transaction
+               void releaseCredit(uint32_t id, bool all);
+
+               // Send queued requests while credits are available, no transaction lock may be held
+               void drainQueue();
+
+               // Drop split transactions which are no longer waited on
+               void dropExpired();
+
+               // Send split requests up to the pipeline depth, transaction lock must be held
+               void sendSplit(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran);
+
+               // Process a response for a split transaction
+               void acceptSplit(std::shared_ptr<rogue::interfaces::memory::Transaction> & tran,
+                                std::shared_ptr<rogue::interfaces::stream::Frame> & frame,
+                                uint32_t *header, uint32_t *tail, uint32_t fSize);
+
             public:
 
                //! Class creation
@@ -65,12 +141,55 @@ namespace rogue {
                //! Deconstructor
                ~SrpV3();
 
+               //! Set the number of requests kept in flight for a split transaction
+               /** Transactions larger than a single frame are split into frame sized requests
+                * which complete the original transaction once all have completed. 
+                * Exposed to python as setSplitDepth()
+                * @param depth Number of outstanding requests per transaction
+                */
+               void setSplitDepth(uint32_t depth);
+
+               //! Get the number of requests kept in flight for a split transaction
+               uint32_t getSplitDepth();
+
+               //! Set the outstanding request window
+               /** Requests beyond the window are queued in submission order and sent as
+                * responses return. The window should match the request depth of the firmware
+                * SRP engine. Posted writes receive no response and are not limited.
+                * Exposed to python as setWindow()
+                * @param window Maximum requests in flight, zero for no limit
+                */
+               void setWindow(uint32_t window);
+
+               //! Get the outstanding request window
+               uint32_t getWindow();
+
+               //! Get the number of requests in flight
+               uint32_t getOutstanding();
+
+               //! Get the number of requests waiting for a credit
+               uint32_t getQueueDepth();
+
+               //! Get the largest number of requests which have waited for a credit
+               uint32_t getMaxQueueDepth();
+
+               //! Get the number of requests which have waited for a credit
+               uint64_t getStallCount();
+
+               //! Reset the queue statistics
+               void resetStats();
+
                //! Post a transaction. Master will call this method with the access attributes.
                void doTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
 
                //! Accept a frame from master
                void acceptFrame ( std::shared_ptr<rogue::interfaces::stream::Frame> frame );
 
+            protected:
+
+               //! Return the credits of a timed out transaction
+               void expireTransaction(std::shared_ptr<rogue::interfaces::memory::Transaction> tran);
+
          };
 
          // Convienence
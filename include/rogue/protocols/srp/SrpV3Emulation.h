@@ -0,0 +1,79 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title         : SLAC Register Protocol (SRP) SrpV3 Emulation
+ * ----------------------------------------------------------------------------
+ * File          : SrpV3Emulation.h
+ * Created       : 2018-03-20
+ *-----------------------------------------------------------------------------
+ * Description :
+ *    Firmware side of SRP Version 3, serving requests from a memory slave
+ *-----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+    * https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ *-----------------------------------------------------------------------------
+**/
+#ifndef __ROGUE_PROTOCOLS_SRP_SRPV3_EMULATION_H__
+#define __ROGUE_PROTOCOLS_SRP_SRPV3_EMULATION_H__
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include <rogue/interfaces/stream/Master.h>
+#include <rogue/interfaces/stream/Slave.h>
+#include <rogue/interfaces/memory/Master.h>
+#include <rogue/Logging.h>
+
+namespace rogue {
+   namespace protocols {
+      namespace srp {
+
+         //! SRP SrpV3 Emulation
+         /*
+          * Emulates the firmware side of the SRP Version 3 protocol. Request frames 
+          * received from an SrpV3 bridge are executed as transactions against the
+          * attached memory slave and answered with response frames. Connecting an SrpV3
+          * object to an SrpV3Emulation over a stream loopback, with an Emulate memory
+          * slave attached, allows the full register stack to be exercised without hardware.
+          */
+         class SrpV3Emulation : public rogue::interfaces::stream::Master,
+                                public rogue::interfaces::stream::Slave,
+                                public rogue::interfaces::memory::Master {
+
+               std::shared_ptr<rogue::Logging> log_;
+
+               static const uint32_t HeadLen = 20;
+               static const uint32_t TailLen = 4;
+
+               // Send a response frame for a completed request
+               void respond(std::shared_ptr<std::vector<uint8_t> > buff, uint32_t size, uint32_t error);
+
+            public:
+
+               //! Class creation
+               static std::shared_ptr<rogue::protocols::srp::SrpV3Emulation> create ();
+
+               //! Setup class in python
+               static void setup_python();
+
+               //! Creator
+               SrpV3Emulation();
+
+               //! Deconstructor
+               ~SrpV3Emulation();
+
+               //! Accept a request frame
+               void acceptFrame ( std::shared_ptr<rogue::interfaces::stream::Frame> frame );
+
+         };
+
+         // Convienence
+         typedef std::shared_ptr<rogue::protocols::srp::SrpV3Emulation> SrpV3EmulationPtr;
+      }
+   }
+}
+#endif
+
@@ -16,7 +16,6 @@
 import rogue.interfaces.memory as rim
 import threading
 import time
-import math
 import textwrap
 import pyrogue as pr
 import inspect
@@ -142,6 +141,9 @@ class BaseBlock(object):
 
     def _forceStale(self):
         pass
+
+    def _shadowSkip(self):
+        return False
         
     def updated(self):
         pass
@@ -257,27 +259,43 @@ class LocalBlock(BaseBlock):
             self.updated()
 
 
-class RemoteBlock(BaseBlock, rim.Master):
+def _fieldType(var):
+    """ Return the native rim.Block field type used to pack and unpack a variable """
+    bits = sum(var.bitSize)
+
+    if var._base is pr.UInt and bits <= 64:
+        return rim.Block.UInt
+    elif var._base is pr.Int and bits <= 64:
+        return rim.Block.Int
+    elif var._base is pr.Bool and bits == 1:
+        return rim.Block.Bool
+    elif var._base is pr.Float and (bits == 32 or bits == 64):
+        return rim.Block.Float
+    else:
+        return rim.Block.Bytes
+
+
+class RemoteBlock(BaseBlock, rim.Block):
     def __init__(self, *, offset, size, variables):
      
-        rim.Master.__init__(self)
+        rim.Block.__init__(self, offset, size)
         self._setSlave(variables[0].parent)
         
         BaseBlock.__init__(self, path=variables[0].path, mode=variables[0].mode, device=variables[0].parent)
-        self._verifyEn  = False
         self._bulkEn    = False
         self._doVerify  = False
         self._verifyWr  = False
-        self._sData     = bytearray(size)  # Set data
-        self._sDataMask = bytearray(size)  # Set data mask
-        self._bData     = bytearray(size)  # Block data
-        self._vData     = bytearray(size)  # Verify data
-        self._vDataMask = bytearray(size)  # Verify data mask
+        self._shadowType = None
+        self._bData     = self._blockData()   # Block data, owned by rim.Block
+        self._vData     = self._verifyData()  # Verify data, owned by rim.Block
+        self._vDataMask = self._verifyMask()  # Verify data mask, owned by rim.Block
         self._size      = size
         self._offset    = offset
         self._minSize   = self._reqMinAccess()
         self._maxSize   = self._reqMaxAccess()
         self._variables = variables
+        self._bulkMaster = None
+        self._bulkId     = None
 
         if self._minSize == 0 or self._maxSize == 0:
             raise MemoryError(name=self.path, address=self.address, msg="Invalid min/max size")
@@ -287,10 +305,6 @@ class RemoteBlock(BaseBlock, rim.Master):
             msg = f'Block {self.path} size {self._size} exceeds maxSize {self._maxSize}'
             raise MemoryError(name=self.path, address=self.address, msg=msg)
 
-        # Temp bit masks
-        excMask = bytearray(size)  # Variable bit mask for exclusive variables
-        oleMask = bytearray(size)  # Variable bit mask for overlap enabled variables
-
         # Go through variables
         for var in variables:
 
@@ -306,29 +320,22 @@ class RemoteBlock(BaseBlock, rim.Master):
             if var.mode != self._mode:
                 self._mode = 'RW'
 
-            # Update variable masks
-            for x in range(len(var.bitOffset)):
-
-                # Variable allows overlaps, add to overlap enable mask
-                if var._overlapEn:
-                    self._setBits(oleMask,var.bitOffset[x],var.bitSize[x])
+            # Add variable field, updates the overlap and verify masks
+            var._blockType  = _fieldType(var)
+            var._blockIndex = self._addVariable(var.bitOffset, var.bitSize, var._overlapEn,
+                                                (var.mode == 'RW' and var.verify is True), var._blockType)
 
-                # Otherwise add to exclusive mask
-                else:
-                    self._setBits(excMask,var.bitOffset[x],var.bitSize[x])
+        # Command only blocks are interactive, serve them ahead of bulk and poll traffic
+        if not self._bulkEn:
+            self._setPriority(rim.PriorityHigh)
 
-                # update verify mask
-                if var.mode == 'RW' and var.verify is True:
-                    self._verifyEn = True
-                    self._setBits(self._vDataMask,var.bitOffset[x],var.bitSize[x])
+        # Check for overlaps between exclusive and overlap enabled variables
+        if self._checkOverlap():
+            raise MemoryError(name=self.path, address=self.address, msg="Variable bit overlap detected.")
 
-        # Check for overlaps by anding exclusive and overmap bit vectors
-        for b1, b2 in zip(oleMask, excMask):
-            if b1 & b2 != 0:
-                raise MemoryError(name=self.path, address=self.address, msg="Variable bit overlap detected.")
-
-        # Set exclusive flag
-        self._overlapEn = all (excMask[i] == 0 for i in range(size))
+        # Set exclusive and verify flags
+        self._overlapEn = self._getOverlapEn()
+        self._verifyEn  = self._getVerifyEn()
 
         # Force block to be stale at startup
         self._forceStale()
@@ -338,7 +345,7 @@ class RemoteBlock(BaseBlock, rim.Master):
 
     @property
     def stale(self):
-        return any([b != 0 for b in self._sDataMask])
+        return self._stale()
 
     @property
     def offset(self):
@@ -386,13 +393,10 @@ class RemoteBlock(BaseBlock, rim.Master):
             raise MemoryError(name=var.path, address=self.address, msg=msg)
 
         with self._lock:
-            ba = var._base.toBytes(value, sum(var.bitSize))
+            if var._blockType == rim.Block.Bytes:
+                value = var._base.toBytes(value, sum(var.bitSize))
 
-            srcBit = 0
-            for x in range(len(var.bitOffset)):
-                self._copyBits(self._sData, var.bitOffset[x], ba, srcBit, var.bitSize[x])
-                self._setBits( self._sDataMask, var.bitOffset[x], var.bitSize[x])
-                srcBit += var.bitSize[x]
+            self._setValue(var._blockIndex, value)
 
     def get(self, var):
         """
@@ -401,81 +405,146 @@ class RemoteBlock(BaseBlock, rim.Master):
         bytearray is returned
         """
         with self._lock:
-            ba = bytearray(int(math.ceil(float(sum(var.bitSize)) / 8.0)))
+            value = self._getValue(var._blockIndex)
 
-            dstBit = 0
-            for x in range(len(var.bitOffset)):
-                if self._anyBits(self._sDataMask, var.bitOffset[x], var.bitSize[x]):
-                    self._copyBits(ba, dstBit, self._sData, var.bitOffset[x], var.bitSize[x])
-                else:
-                    self._copyBits(ba, dstBit, self._bData, var.bitOffset[x], var.bitSize[x])
-                dstBit += var.bitSize[x]
+            if var._blockType == rim.Block.Bytes:
+                value = var._base.fromBytes(value, sum(var.bitSize))
 
-            return var._base.fromBytes(ba,sum(var.bitSize))
+            return value
 
     def startTransaction(self, type, check=False):
         """
         Start a transaction.
         """
         with self._lock:
+            tData = self._stageTransaction(type)
 
-            #print(f'Called {self.name}.startTransaction(check={check})')
+            # Start transaction
+            if tData is not None:
+                self._reqTransaction(self.offset,tData,0,0,type)
 
-            # Check for invalid combinations
-            if (type == rim.Write  and (self.mode == 'RO')) or \
-               (type == rim.Post   and (self.mode == 'RO')) or \
-               (type == rim.Read   and (self.mode == 'WO')) or \
-               (type == rim.Verify and (self.mode == 'WO' or \
-                                        self.mode == 'RO' or \
-                                        self._verifyWr == False)):
-                return
+        if check:
+            #print(f'Checking {self.path}.startTransaction(check={check})')
+            self._checkTransaction()
 
-            self._waitTransaction(0)
-            self.error = 0
+    def _bulkStart(self, type):
+        """
+        Stage a transaction which will be submitted by the parent Device as part of
+        a bulk request. Returns the request tuple or None if nothing is to be sent.
+        """
+        with self._lock:
+            tData = self._stageTransaction(type)
 
-            # Move staged write data to block. Clear stale.
-            if type == rim.Write or type == rim.Post:
-                for x in range(self._size):
-                    self._bData[x] = self._bData[x] & (self._sDataMask[x] ^ 0xFF)
-                    self._bData[x] = self._bData[x] | (self._sDataMask[x] & self._sData[x])
+            if tData is None:
+                return None
+            else:
+                return (self.offset,tData,0,0,type)
 
-                self._sData = bytearray(self._size)
-                self._sDataMask = bytearray(self._size)
+    def _bulkSet(self, master, tid):
+        with self._lock:
+            self._bulkMaster = master
+            self._bulkId     = tid
 
-            # Do not write to hardware for a disabled device
-            if (self._device.enable.value() is not True):
-                return
+    def _bulkDone(self, tid, error):
+        with self._lock:
+            if self._bulkId == tid:
+                if error != 0: self.error = error
+                self._bulkId = None
+
+    def _bulkWait(self):
+        """ Wait for an outstanding bulk transaction, lock must be held """
+        if self._bulkId is not None:
+            error = self._bulkMaster._waitTransactions([self._bulkId])[0]
+            if error != 0: self.error = error
+            self._bulkId = None
+
+    def _stageTransaction(self, type):
+        """
+        Prepare the block for a transaction. Lock must be held. Returns
+        the transaction data buffer or None if nothing is to be sent.
+        """
 
-            self._log.debug(f'startTransaction type={type}')
-            self._log.debug(f'len bData = {len(self._bData)}, vData = {len(self._vData)}, vDataMask = {len(self._vDataMask)}')
+        #print(f'Called {self.name}.startTransaction(check={check})')
 
-            # Track verify after writes. 
-            # Only verify blocks that have been written since last verify
-            if type == rim.Write:
-                self._verifyWr = self._verifyEn
-                  
-            # Setup transaction
-            self._doVerify = (type == rim.Verify)
-            self._doUpdate = True
+        # Check for invalid combinations
+        if (type == rim.Write  and (self.mode == 'RO')) or \
+           (type == rim.Post   and (self.mode == 'RO')) or \
+           (type == rim.Read   and (self.mode == 'WO')) or \
+           (type == rim.Verify and (self.mode == 'WO' or \
+                                    self.mode == 'RO' or \
+                                    self._verifyWr == False)):
+            return None
 
-            # Set data pointer
-            tData = self._vData if self._doVerify else self._bData
+        self._waitTransaction(0)
+        self._bulkWait()
+        self._shadowDone()
+        self.error = 0
 
-            # Start transaction
-            self._reqTransaction(self.offset,tData,0,0,type)
+        # Move staged write data to block. Clear stale.
+        if type == rim.Write or type == rim.Post:
+            self._applyStaged(True)
 
-        if check:
-            #print(f'Checking {self.path}.startTransaction(check={check})')
-            self._checkTransaction()
+        # Do not write to hardware for a disabled device
+        if (self._device.enable.value() is not True):
+            return None
+
+        self._log.debug(f'startTransaction type={type}')
+        self._log.debug(f'len bData = {len(self._bData)}, vData = {len(self._vData)}, vDataMask = {len(self._vDataMask)}')
+
+        # Track verify after writes. 
+        # Only verify blocks that have been written since last verify
+        if type == rim.Write:
+            self._verifyWr = self._verifyEn
+
+        # Track the hardware shadow
+        self._shadowType = type
+              
+        # Setup transaction
+        self._doVerify = (type == rim.Verify)
+        self._doUpdate = True
+
+        # Set data pointer
+        return self._vData if self._doVerify else self._bData
 
     def _forceStale(self):
-        for b in self._sDataMask: b = 0xFF
+        """ The hardware state is unknown, the next write can not be skipped """
+        with self._lock:
+            self._shadowClear()
+
+    def _shadowDone(self):
+        """ Update the hardware shadow for a completed transaction, lock must be held """
+        if self._shadowType == rim.Write or self._shadowType == rim.Post or self._shadowType == rim.Read:
+            if self.error == 0:
+                self._shadowUpdate()
+            else:
+                self._shadowClear()
+
+        self._shadowType = None
+
+    def _shadowSkip(self):
+        """
+        Check if a write of the block can be skipped because the block data,
+        with staged data applied, matches the hardware shadow. The staged data
+        is moved to the block when the write is skipped.
+        """
+        with self._lock:
+            self._waitTransaction(0)
+            self._bulkWait()
+            self._shadowDone()
+
+            if not self._shadowMatch():
+                return False
+
+            self._applyStaged(True)
+            return True
 
     def _checkTransaction(self):
         
         doUpdate = False
         with self._lock:
             self._waitTransaction(0)
+            self._bulkWait()
+            self._shadowDone()
 
             #print(f'Checking {self.path}._checkTransaction()')            
 
@@ -489,13 +558,12 @@ class RemoteBlock(BaseBlock, rim.Master):
             if self._doVerify:
                 self._verifyWr = False
 
-                for x in range(self._size):
-                    if (self._vData[x] & self._vDataMask[x]) != (self._bData[x] & self._vDataMask[x]):
-                        msg  = ('Local='    + ''.join(f'{x:#02x}' for x in self._bData))
-                        msg += ('. Verify=' + ''.join(f'{x:#02x}' for x in self._vData))
-                        msg += ('. Mask='   + ''.join(f'{x:#02x}' for x in self._vDataMask))
+                if self._verifyMismatch():
+                    msg  = ('Local='    + ''.join(f'{x:#02x}' for x in self._bData))
+                    msg += ('. Verify=' + ''.join(f'{x:#02x}' for x in self._vData))
+                    msg += ('. Mask='   + ''.join(f'{x:#02x}' for x in self._vDataMask))
 
-                        raise MemoryError(name=self.path, address=self.address, error=rim.VerifyError, msg=msg, size=self._size)
+                    raise MemoryError(name=self.path, address=self.address, error=rim.VerifyError, msg=msg, size=self._size)
 
                # Updated
             doUpdate = self._doUpdate
@@ -504,15 +572,34 @@ class RemoteBlock(BaseBlock, rim.Master):
         # Update variables outside of lock
         if doUpdate: self.updated()
 
+    def _pollDone(self, error):
+        """
+        Called from the poll queue when a native poll changed the block data or failed.
+        """
+        with self._lock:
+            if error != 0:
+                self._log.warning(str(MemoryError(name=self.path, address=self.address, error=error, size=self._size)))
+                return
+
+            # Block data may still be in use by a write
+            self._waitTransaction(0)
+            self._bulkWait()
+            self._shadowDone()
+
+            # Poll data predates a write
+            if not self._pollApply():
+                return
+
+        # Update variables outside of lock
+        self.updated()
+
     def _setDefault(self, var, value):
         with self._lock:
             # Stage the default data        
             self.set(var, value)
 
             # Move stage data to block, but keep it staged as well
-            for x in range(self._size):
-                self._bData[x] = self._bData[x] & (self._sDataMask[x] ^ 0xFF)
-                self._bData[x] = self._bData[x] | (self._sDataMask[x] & self._sData[x])
+            self._applyStaged(False)
 
 
     def updated(self):
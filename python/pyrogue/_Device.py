@@ -20,6 +20,7 @@ import functools as ft
 import pyrogue as pr
 import inspect
 import threading
+import asyncio
 import math
 import time
 
@@ -108,6 +109,39 @@ class DeviceError(Exception):
     pass
 
 
+class _AsyncTransaction(object):
+    """
+    Tracks a group of asynchronous memory transactions and resolves an asyncio
+    future on the passed event loop once all of them have completed.
+    """
+    def __init__(self, loop):
+        self._loop  = loop
+        self._fut   = loop.create_future()
+        self._lock  = threading.Lock()
+        self._pend  = 1
+        self._error = 0
+
+    def add(self):
+        with self._lock:
+            self._pend += 1
+
+    def done(self, tid, error):
+        with self._lock:
+            if error != 0: self._error = error
+            self._pend -= 1
+            fin = (self._pend == 0)
+
+        if fin: self._loop.call_soon_threadsafe(self._resolve)
+
+    def _resolve(self):
+        if not self._fut.done():
+            self._fut.set_result(self._error)
+
+    def finish(self):
+        self.done(0,0)
+        return self._fut
+
+
 class Device(pr.Node,rim.Hub):
     """Device class holder. TODO: Update comments"""
 
@@ -134,6 +168,10 @@ class Device(pr.Node,rim.Hub):
         # Hub.__init__ must be called first for _setSlave to work below
         rim.Hub.__init__(self,offset,hubMin,hubMax)
 
+        # Master used to submit block transactions in bulk
+        self._bulk = rim.Master()
+        self._bulk._setSlave(self)
+
         # Blocks
         self._blocks    = []
         self._memBase   = memBase
@@ -276,9 +314,11 @@ class Device(pr.Node,rim.Hub):
                     b.startTransaction(rim.Write, check=checkEach)
 
         else:
-            for block in self._blocks:
-                if (force or block.stale) and block.bulkEn:
-                    block.startTransaction(rim.Write, check=checkEach)
+            # Skip blocks which match the hardware shadow
+            shadow = (not force) and self.root.ShadowWrite.value()
+
+            self._bulkTransaction([block for block in self._blocks if (force or block.stale) and block.bulkEn and
+                                   not (shadow and block._shadowSkip())], rim.Write, checkEach)
 
             if recurse:
                 for key,value in self.devices.items():
@@ -298,9 +338,7 @@ class Device(pr.Node,rim.Hub):
                 b.startTransaction(rim.Verify, check=checkEach)
 
         else:
-            for block in self._blocks:
-                if block.bulkEn:
-                    block.startTransaction(rim.Verify, checkEach)
+            self._bulkTransaction([block for block in self._blocks if block.bulkEn], rim.Verify, checkEach)
 
             if recurse:
                 for key,value in self.devices.items():
@@ -321,9 +359,7 @@ class Device(pr.Node,rim.Hub):
                 b.startTransaction(rim.Read, check=checkEach)
 
         else:
-            for block in self._blocks:
-                if block.bulkEn:
-                    block.startTransaction(rim.Read, check=checkEach)
+            self._bulkTransaction([block for block in self._blocks if block.bulkEn], rim.Read, checkEach)
 
             if recurse:
                 for key,value in self.devices.items():
@@ -341,6 +377,7 @@ class Device(pr.Node,rim.Hub):
                     b._checkTransaction()
 
             else:
+                self._bulkWait()
                 for block in self._blocks:
                     block._checkTransaction()
 
@@ -359,7 +396,45 @@ class Device(pr.Node,rim.Hub):
         self.readBlocks(recurse=recurse, variable=variable, checkEach=checkEach)
         self.checkBlocks(recurse=recurse, variable=variable)
 
-    def _rawTxnChunker(self, offset, data, base=pr.UInt, stride=4, wordBitSize=32, txnType=rim.Write, numWords=1):
+    def _bulkTransaction(self, blocks, type, checkEach):
+        """
+        Start transactions for the passed blocks. Remote blocks are submitted
+        to hardware with a single native call unless each block is to be checked.
+        """
+        if checkEach:
+            for block in blocks:
+                block.startTransaction(type, check=True)
+            return
+
+        reqs   = []
+        staged = []
+
+        for block in blocks:
+            if isinstance(block, pr.RemoteBlock):
+                req = block._bulkStart(type)
+                if req is not None:
+                    reqs.append(req)
+                    staged.append(block)
+            else:
+                block.startTransaction(type, check=False)
+
+        if len(reqs) > 0:
+            for block, tid in zip(staged, self._bulk._reqTransactions(reqs)):
+                block._bulkSet(self._bulk, tid)
+
+    def _bulkWait(self):
+        """
+        Wait for all outstanding bulk block transactions with a single native call
+        """
+        pend = [(block, block._bulkId) for block in self._blocks 
+                if isinstance(block, pr.RemoteBlock) and block._bulkId is not None]
+
+        if len(pend) > 0:
+            errors = self._bulk._waitTransactions([tid for _,tid in pend])
+            for (block, tid), error in zip(pend, errors):
+                block._bulkDone(tid, error)
+
+    def _rawTxnChunker(self, offset, data, base=pr.UInt, stride=4, wordBitSize=32, txnType=rim.Write, numWords=1, asyncTxn=None):
         if offset + (numWords * stride) > self._size:
             raise pr.MemoryError(name=self.name, address=offset|self.address,
                                  msg='Raw transaction outside of device size')
@@ -387,7 +462,11 @@ class Device(pr.Node,rim.Hub):
                 sliceOffset = i | self.offset
                 txnSize = min(self._reqMaxAccess(), len(ldata)-(i-offset))
                 #print(f'sliceOffset: {sliceOffset:#x}, ldata: {ldata}, txnSize: {txnSize}, buffOffset: {i-offset}')
-                self._reqTransaction(sliceOffset, ldata, txnSize, i-offset, txnType)
+                if asyncTxn is None:
+                    self._reqTransaction(sliceOffset, ldata, txnSize, i-offset, txnType)
+                else:
+                    asyncTxn.add()
+                    self._reqTransactionAsync(sliceOffset, ldata, txnSize, i-offset, txnType, asyncTxn.done)
 
             return ldata
 
@@ -417,15 +496,47 @@ class Device(pr.Node,rim.Hub):
                 self._waitTransaction(0)
 
                 if self._getError() == 0:
-                    if numWords == 1:
-                        return base.fromBytes(base.mask(ldata, wordBitSize),wordBitSize)
-                    else:
-                        return [base.fromBytes(base.mask(ldata[i:i+stride], wordBitSize),wordBitSize) for i in range(0, len(ldata), stride)]
+                    return self._rawDecode(ldata, numWords, base, stride, wordBitSize)
                 self._log.warning("Retrying raw read transaction")
                 
             # If we get here an error has occured
             raise pr.MemoryError (name=self.name, address=offset|self.address, error=self._getError())
 
+    def _rawDecode(self, ldata, numWords, base, stride, wordBitSize):
+        if numWords == 1:
+            return base.fromBytes(base.mask(ldata, wordBitSize),wordBitSize)
+        else:
+            return [base.fromBytes(base.mask(ldata[i:i+stride], wordBitSize),wordBitSize) for i in range(0, len(ldata), stride)]
+
+    async def _rawWriteAsync(self, offset, data, base=pr.UInt, stride=4, wordBitSize=32, posted=False):
+        """
+        Asyncio version of _rawWrite. Completion is delivered by the memory Master 
+        completion thread so no thread is blocked while the write is in flight.
+        """
+        if posted: txn = rim.Post
+        else: txn = rim.Write
+
+        asyncTxn = _AsyncTransaction(asyncio.get_event_loop())
+        self._rawTxnChunker(offset, data, base, stride, wordBitSize, txn, asyncTxn=asyncTxn)
+        error = await asyncTxn.finish()
+
+        if error != 0:
+            raise pr.MemoryError (name=self.name, address=offset|self.address, error=error)
+
+    async def _rawReadAsync(self, offset, numWords=1, base=pr.UInt, stride=4, wordBitSize=32, data=None):
+        """
+        Asyncio version of _rawRead. Completion is delivered by the memory Master 
+        completion thread so no thread is blocked while the read is in flight.
+        """
+        asyncTxn = _AsyncTransaction(asyncio.get_event_loop())
+        ldata = self._rawTxnChunker(offset, data, base, stride, wordBitSize, txnType=rim.Read, numWords=numWords, asyncTxn=asyncTxn)
+        error = await asyncTxn.finish()
+
+        if error != 0:
+            raise pr.MemoryError (name=self.name, address=offset|self.address, error=error)
+
+        return self._rawDecode(ldata, numWords, base, stride, wordBitSize)
+
 
     def _getBlocks(self, variables):
         """
@@ -520,6 +631,7 @@ class Device(pr.Node,rim.Hub):
             block.timeout = timeout
 
         rim.Master._setTimeout(self, int(timeout*1000000))
+        self._bulk._setTimeout(int(timeout*1000000))
 
         for key,value in self._nodes.items():
             if isinstance(value,Device):
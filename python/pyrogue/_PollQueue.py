@@ -36,10 +36,22 @@ class PollQueueEntry(object):
         return self.readTime > other.readTime
 
 class PollQueue(object):
+    """
+    Poll scheduler. RemoteBlocks are polled by the native rogue.interfaces.memory.Poller,
+    which only calls back into python when polled data changes. LocalBlocks run python
+    get functions and are polled from the python thread.
+    """
+
+    # Native poller tick in seconds
+    Tick = 0.01
 
     def __init__(self,*, root):
         self._pq = [] # The heap queue
         self._entries = {} # {Block: Entry} mapping to look up if a block is already in the queue
+        self._remote = {} # {Block: interval} for blocks polled by the native poller
+        self._devices = set() # Devices with an enable listener
+        self._poller = rogue.interfaces.memory.Poller(int(self.Tick * 1000000))
+        self._poller.setCallback(self._pollUpdates)
         self._counter = itertools.count()
         self._lock = threading.RLock()
         self._update = threading.Condition()
@@ -51,9 +63,62 @@ class PollQueue(object):
         self._log = pr.logInit(cls=self)
 
     def _start(self):
+        self._poller.start()
         self._pollThread.start()
         self._log.info("PollQueue Started")
 
+    def _pollUpdates(self, updates):
+        """Called by the native poller with a list of (block, error) for changed or failed blocks"""
+        with self._root.updateGroup():
+            for block, error in updates:
+                try:
+                    block._pollDone(error)
+                except Exception as e:
+                    self._log.exception(e)
+
+    def _remoteEntry(self, block, interval):
+        """Add, update or remove a block in the native poller"""
+        if interval == 0:
+            if block in self._remote:
+                self._poller.removeBlock(block)
+                del self._remote[block]
+            return
+
+        # Write only blocks are never read
+        if block.mode == 'WO' or self._remote.get(block) == interval:
+            return
+
+        self._remote[block] = interval
+        self._poller.addBlock(block, interval)
+
+        # Track device enable, only enabled devices are polled
+        dev = block._device
+        self._poller.setEnable(block, dev.enable.value() is True)
+
+        if dev not in self._devices:
+            self._devices.add(dev)
+            dev.enable.addListener(lambda path, value, disp, dev=dev: self._enableChanged(dev))
+
+    def _enableChanged(self, dev):
+        en = (dev.enable.value() is True)
+
+        with self._lock:
+            for block in self._remote:
+                if block._device is dev:
+                    self._poller.setEnable(block, en)
+
+    def getStats(self):
+        """
+        Return native poll statistics. The per block list is keyed by block path, 
+        intervals and jitter are in seconds.
+        """
+        stats = self._poller.getStats()
+        stats['blocks'] = {b.pop('block').path : b for b in stats['blocks']}
+        return stats
+
+    def resetStats(self):
+        self._poller.resetStats()
+
     def _addEntry(self, block, interval):
         with self._lock:
             timedelta = datetime.timedelta(seconds=interval)
@@ -81,7 +146,14 @@ class PollQueue(object):
 
                 return
 
-            if var._block in self._entries.keys():
+            if isinstance(var._block, pr.RemoteBlock):
+                blockVars = [v for v in var._block._variables if v.pollInterval > 0]
+                if len(blockVars) > 0:
+                    self._remoteEntry(var._block, min(v.pollInterval for v in blockVars))
+                else:
+                    self._remoteEntry(var._block, 0)
+
+            elif var._block in self._entries.keys():
                 oldInterval = self._entries[var._block].interval
                 blockVars = [v for v in var._block._variables if v.pollInterval > 0]
                 if len(blockVars) > 0:
@@ -177,6 +249,8 @@ class PollQueue(object):
             return len(self._pq)==0
 
     def stop(self):
+        self._poller.stop()
+
         with self._lock, self._update:
             self._run = False
             self._update.notify()
@@ -25,6 +25,7 @@ import pyrogue.interfaces
 import functools as ft
 import time
 import queue
+import struct
 import jsonpickle
 from contextlib import contextmanager
 
@@ -81,8 +82,13 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
         self._pollQueue = None
 
         # Zeromq server
-        self._zmqServer = None
-        self._structure = ""
+        self._zmqServer   = None
+        self._structure   = ""
+        self._pubInterval = 0.0
+
+        # Variable ids used for binary updates
+        self._varIds   = {}
+        self._varIdStr = ""
 
         # List of variable listeners
         self._varListeners  = []
@@ -102,6 +108,9 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
         self.add(pr.LocalVariable(name='ForceWrite', value=False, mode='RW', hidden=True,
             description='Configuration Flag To Always Write Non Stale Blocks For WriteAll, LoadConfig and setYaml'))
 
+        self.add(pr.LocalVariable(name='ShadowWrite', value=False, mode='RW', hidden=True,
+            description='Configuration Flag To Only Write Blocks Which Differ From The Last Value Written To Or Read From Hardware For WriteAll, LoadConfig and setYaml'))
+
         self.add(pr.LocalVariable(name='InitAfterConfig', value=False, mode='RW', hidden=True,
             description='Configuration Flag To Execute Initialize after LoadConfig or setYaml'))
 
@@ -155,12 +164,18 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
         self.add(pr.LocalCommand(name='Exit', function=self._exit, hidden=False,
                                  description='Exit the server application'))
 
-    def start(self, timeout=1.0, initRead=False, initWrite=False, pollEn=True, zmqPort=9099):
-        """Setup the tree. Start the polling thread."""
+    def start(self, timeout=1.0, initRead=False, initWrite=False, pollEn=True, zmqPort=9099, pubInterval=0.0):
+        """
+        Setup the tree. Start the polling thread.
+        Variable updates published over zmq are coalesced so that they are sent
+        at most once every pubInterval seconds.
+        """
 
         if self._running:
             raise pr.NodeError("Root is already started! Can't restart!")
 
+        self._pubInterval = pubInterval
+
         # Create poll queue object
         if pollEn:
             self._pollQueue = pr.PollQueue(root=self)
@@ -240,6 +255,10 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
         if self._pollQueue:
             self._pollQueue.stop()
 
+        # Pending updates are published before the server is released
+        if self._updateThread is not None and self._updateThread is not threading.current_thread():
+            self._updateThread.join()
+
         if self._zmqServer is not None:
             self._zmqServer = None
 
@@ -293,6 +312,119 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
         obj = self.getNode(path)
         return obj.call(arg)
 
+    @pr.expose
+    def getMany(self,paths,read=True,disp=False):
+        """
+        Return a list of values for a list of variable paths. When read is True
+        the hardware reads for all of the variables are issued before any of them
+        are checked. Pass disp=True to return display strings.
+        """
+        return [d if disp else v for i,v,d in self._getManyEntries(paths,read)]
+
+    @pr.expose
+    def setMany(self,values,write=True,disp=False):
+        """
+        Set a dictionary of variable path/value pairs. All values are updated
+        before a single write, verify and check of the affected blocks.
+        Pass disp=True when the values are display strings.
+        """
+        devs = odict()
+
+        with self.updateGroup():
+            for p,val in values.items():
+                n = self.getNode(p)
+
+                if not isinstance(n,pr.BaseVariable):
+                    self._log.error("Entry {} not found".format(p))
+                    continue
+
+                # Variables without a block are written on their own
+                w = write and n._block is None
+
+                if disp:
+                    n.setDisp(val,write=w)
+                else:
+                    n.set(val,write=w)
+
+                if n._block is not None:
+                    devs.setdefault(n.parent,[]).append(n)
+
+            if write:
+                try:
+                    for d,vl in devs.items():
+                        d.writeBlocks(force=True, recurse=False, variable=vl)
+                    for d,vl in devs.items():
+                        d.verifyBlocks(recurse=False, variable=vl)
+                    for d,vl in devs.items():
+                        d.checkBlocks(recurse=False, variable=vl)
+                except Exception as e:
+                    self._log.exception(e)
+
+    @pr.expose
+    def setMemoryStats(self,enable):
+        """
+        Enable or disable transaction statistics for every memory slave used
+        by the tree. Statistics are kept per slave and per transaction type.
+        """
+        for sid in set(d._reqSlaveId() for d in self.deviceList):
+            rogue.interfaces.memory.TransactionStats.get(sid).setEnable(enable)
+
+    @pr.expose
+    def getMemoryStats(self,reset=False):
+        """
+        Return a dictionary of transaction statistics keyed by the path of the
+        first device using each memory slave. Each entry holds the latency
+        histogram, byte, error and timeout counts for each transaction type.
+        Pass reset=True to clear the statistics after reading them.
+        """
+        ret = odict()
+        ids = set()
+
+        for d in self.deviceList:
+            sid = d._reqSlaveId()
+
+            if sid in ids:
+                continue
+            ids.add(sid)
+
+            stats = rogue.interfaces.memory.TransactionStats.get(sid)
+            ret[d.path] = stats.getStats()
+
+            if reset:
+                stats.reset()
+
+        return ret
+
+    def _getManyEntries(self,paths,read):
+        """Read a list of variables, returns a list of (id, value, valueDisp) tuples"""
+        nodes = [self.getNode(p) for p in paths]
+
+        if read:
+            devs = odict()
+
+            for n in nodes:
+                if isinstance(n,pr.BaseVariable) and n._block is not None:
+                    devs.setdefault(n.parent,[]).append(n)
+
+            with self.updateGroup():
+                try:
+                    for d,vl in devs.items():
+                        d.readBlocks(recurse=False, variable=vl)
+                    for d,vl in devs.items():
+                        d.checkBlocks(recurse=False, variable=vl)
+                except Exception as e:
+                    self._log.exception(e)
+
+        ret = []
+        for p,n in zip(paths,nodes):
+            if not isinstance(n,pr.BaseVariable):
+                ret.append((0,None,None))
+            else:
+                v = n.get(read=(read and n._block is None))
+                ret.append((self._varIds.get(p,0),v,n.genDisp(v)))
+
+        return ret
+
     @contextmanager
     def updateGroup(self):
 
@@ -364,6 +496,10 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
 
         self._buildBlocks()
 
+        # Assign variable ids
+        self._varIds = {v.path:i for i,v in enumerate(self.variableList,1)}
+        self._varIdStr = '\n'.join('{} {}'.format(i,p) for p,i in self._varIds.items())
+
         # Some variable initialization can run until the blocks are built
         for v in self.variables.values():
             v._finishInit()
@@ -516,13 +652,28 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
         # Init
         count = 0
         uvars = {}
+        pend  = odict()
+        last  = {}
+        pubTime = 0.0
 
         while True:
-            ent = self._updateQueue.get()
 
-            # Done
+            # Wake up to publish coalesced updates
+            tmo = None
+            if len(pend) > 0:
+                tmo = max(0.0, pubTime + self._pubInterval - time.time())
+
+            try:
+                ent = self._updateQueue.get(timeout=tmo)
+            except queue.Empty:
+                pubTime = self._publishUpdates(pend,last)
+                continue
+
+            # Done, publish coalesced updates which are still pending
             if ent is None:
                 self._log.info("Stopping update thread")
+                if len(pend) > 0:
+                    self._publishUpdates(pend,last)
                 return
 
             # Increment
@@ -552,22 +703,30 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
                         # Call listener functions,
                         with self._varListenLock:
                             for func in self._varListeners:
-                                func(p,val.value.val,valueDisp)
+                                func(p,val.value,val.valueDisp)
                     except Exception as e:
                         self._log.exception(e)
                         
                 self._log.debug(F"Done update group. Length={len(uvars)}. Entry={list(uvars.keys())[0]}")
 
 
-                # Generate yaml stream
-                try:
-                    self._sendYamlFrame(dataToYaml(d,varEncode=False))
-                except Exception as e:
-                    self._log.exception(e)
+                # Generate yaml stream, only when a stream slave is attached
+                if self._slaveCount() > 0:
+                    try:
+                        self._sendYamlFrame(dataToYaml(d,varEncode=False))
+                    except Exception as e:
+                        self._log.exception(e)
 
-                # Send over zmq link
+                # Refresh the request cache and queue for publishing
                 if self._zmqServer is not None:
-                    self._zmqServer._publish(jsonpickle.encode(d))
+                    for p,val in d.items():
+                        if val.valueDisp is not None:
+                            self._zmqServer._updateCache(p,val.value,val.valueDisp)
+
+                    pend.update(d)
+
+                    if time.time() >= (pubTime + self._pubInterval):
+                        pubTime = self._publishUpdates(pend,last)
 
                 # Init var list
                 uvars = {}
@@ -575,6 +734,143 @@ class Root(rogue.interfaces.stream.Master,pr.Device):
             # Set done
             self._updateQueue.task_done()
 
+    def _publishUpdates(self,pend,last):
+        """
+        Publish the pending updates over zmq in binary form. Only values which
+        changed since they were last published are sent. Returns the publish time.
+        """
+        lst = []
+
+        for p,val in pend.items():
+            vid = self._varIds.get(p,None)
+
+            if vid is None:
+                continue
+
+            if vid in last and last[vid][1] == val.valueDisp and not _valueChanged(last[vid][0],val.value):
+                continue
+
+            last[vid] = (val.value,val.valueDisp)
+            lst.append((vid,val.value,val.valueDisp))
+
+        pend.clear()
+
+        if len(lst) > 0 and self._zmqServer is not None:
+            self._zmqServer._publish(updateToBinary(lst))
+
+        return time.time()
+
+def _valueChanged(old,new):
+    try:
+        return type(old) != type(new) or bool(old != new)
+    except Exception:
+        return True
+
+# Binary variable update format. The message starts with a four byte tag and a
+# 32-bit record count. Each record contains a 32-bit variable id, an 8-bit value
+# type, a 32-bit value length, the value, a 32-bit display length and the utf-8
+# display string. A display length of 0xFFFFFFFF indicates a display value of None.
+# All fields are little endian.
+UpdateTag    = b'RUP1'
+UpdateNone   = 0
+UpdateBool   = 1
+UpdateInt    = 2
+UpdateFloat  = 3
+UpdateString = 4
+UpdateBytes  = 5
+UpdatePickle = 6
+
+_updHeader = struct.Struct('<4sI')
+_updRecord = struct.Struct('<IBI')
+_updLen    = struct.Struct('<I')
+_updInt    = struct.Struct('<q')
+_updFloat  = struct.Struct('<d')
+
+def updateToBinary(entries):
+    """Encode a list of (id, value, valueDisp) tuples as a binary update message"""
+    parts = [_updHeader.pack(UpdateTag,len(entries))]
+
+    for vid,value,disp in entries:
+        t = type(value)
+
+        if value is None:
+            typ = UpdateNone
+            enc = b''
+        elif t is bool:
+            typ = UpdateBool
+            enc = b'\x01' if value else b'\x00'
+        elif t is int and -(1 << 63) <= value < (1 << 63):
+            typ = UpdateInt
+            enc = _updInt.pack(value)
+        elif t is float:
+            typ = UpdateFloat
+            enc = _updFloat.pack(value)
+        elif t is str:
+            typ = UpdateString
+            enc = value.encode('utf-8')
+        elif t is bytes or t is bytearray:
+            typ = UpdateBytes
+            enc = bytes(value)
+        else:
+            typ = UpdatePickle
+            enc = jsonpickle.encode(value).encode('utf-8')
+
+        parts.append(_updRecord.pack(vid,typ,len(enc)))
+        parts.append(enc)
+
+        if disp is None:
+            parts.append(_updLen.pack(0xFFFFFFFF))
+        else:
+            denc = disp.encode('utf-8')
+            parts.append(_updLen.pack(len(denc)))
+            parts.append(denc)
+
+    return b''.join(parts)
+
+def binaryToUpdate(data):
+    """Decode a binary update message into a list of (id, value, valueDisp) tuples"""
+    tag,count = _updHeader.unpack_from(data,0)
+
+    if tag != UpdateTag:
+        raise pr.NodeError("Invalid update message tag {}".format(tag))
+
+    pos = _updHeader.size
+    ret = []
+
+    for i in range(count):
+        vid,typ,vlen = _updRecord.unpack_from(data,pos)
+        pos += _updRecord.size
+        enc = data[pos:pos+vlen]
+        pos += vlen
+
+        if typ == UpdateNone:
+            value = None
+        elif typ == UpdateBool:
+            value = enc != b'\x00'
+        elif typ == UpdateInt:
+            value = _updInt.unpack(enc)[0]
+        elif typ == UpdateFloat:
+            value = _updFloat.unpack(enc)[0]
+        elif typ == UpdateString:
+            value = enc.decode('utf-8')
+        elif typ == UpdateBytes:
+            value = bytes(enc)
+        else:
+            value = jsonpickle.decode(enc.decode('utf-8'))
+
+        dlen, = _updLen.unpack_from(data,pos)
+        pos += _updLen.size
+
+        if dlen == 0xFFFFFFFF:
+            disp = None
+        else:
+            disp = data[pos:pos+dlen].decode('utf-8')
+            pos += dlen
+
+        ret.append((vid,value,disp))
+
+    return ret
+
 def yamlToData(stream):
     """Load yaml to data structure"""
 
@@ -34,6 +34,12 @@ def genBaseList(cls):
     return ret
 
 
+class VirtualValue(object):
+    def __init__(self, value, valueDisp):
+        self.value     = value
+        self.valueDisp = valueDisp
+
+
 class VirtualProperty(object):
     def __init__(self, node, attr):
         self._attr = attr
@@ -180,6 +186,8 @@ class VirtualClient(rogue.interfaces.ZmqClient):
         rogue.interfaces.ZmqClient.__init__(self,addr,port)
         self._varListeners = []
         self._root = None
+        self._varPaths = {}
+        self._cache = {}
 
         # Setup logging
         self._log = pr.logInit(cls=self,name="VirtualClient",path=None)
@@ -196,6 +204,13 @@ class VirtualClient(rogue.interfaces.ZmqClient):
         print("Getting structure for {}".format(rn))
         self.setTimeout(120000)
         r = self._remoteAttr('__structure__', None)
+
+        # Get variable ids for binary updates
+        ids = self._remoteAttr('__varids__', None)
+        for line in ids.splitlines():
+            i,p = line.split(' ',1)
+            self._varPaths[int(i)] = p
+
         print("Ready to use {}".format(rn))
 
         # Update tree
@@ -203,6 +218,24 @@ class VirtualClient(rogue.interfaces.ZmqClient):
         self._root = r
 
     def _remoteAttr(self, path, attr, *args, **kwargs):
+
+        # Values of published variables are served from the local cache
+        if path in self._cache and len(args) == 0:
+            if attr in ('value','valueDisp') and len(kwargs) == 0:
+                return self._cache[path][attr == 'valueDisp']
+            elif attr in ('get','getDisp') and kwargs == {'read':False}:
+                return self._cache[path][attr == 'getDisp']
+
+        # Requests which change a value drop its cache entry, before and after the
+        # request, until the published update arrives
+        inval = [path] if attr in ('set','setDisp','post','call','__call__') else []
+
+        if attr == 'setMany' and len(args) > 0:
+            inval = list(args[0].keys())
+
+        for k in inval:
+            self._cache.pop(k,None)
+
         snd = { 'path':path, 'attr':attr, 'args':args, 'kwargs':kwargs }
         y = jsonpickle.encode(snd)
         try:
@@ -212,27 +245,40 @@ class VirtualClient(rogue.interfaces.ZmqClient):
             print("got remote exception: {}".format(msg))
             ret = None
 
+        for k in inval:
+            self._cache.pop(k,None)
+
         return ret
 
     def _addVarListener(self,func):
         self._varListeners.append(func)
 
+    def getMany(self, paths, read=True, disp=False):
+        """Get the values of a list of variable paths in a single request"""
+        return self._remoteAttr(self._root.path, 'getMany', paths, read=read, disp=disp)
+
+    def setMany(self, values, write=True, disp=False):
+        """Set a dictionary of variable path/value pairs in a single request"""
+        self._remoteAttr(self._root.path, 'setMany', values, write=write, disp=disp)
+
     def _doUpdate(self,data):
         if self._root is None:
             return
 
-        d = jsonpickle.decode(data)
+        for vid,value,disp in pr.binaryToUpdate(data):
+            k = self._varPaths.get(vid,None)
+            n = None if k is None else self._root.getNode(k)
 
-        for k,val in d.items():
-            n = self._root.getNode(k)
             if n is None:
-                self._log.error("Failed to find node {}".format(k))
-            else:
-                n._doUpdate(val)
+                self._log.error("Failed to find node with id {}".format(vid))
+                continue
+
+            self._cache[k] = (value,disp)
+            n._doUpdate(VirtualValue(value,disp))
 
             # Call listener functions,
             for func in self._varListeners:
-                func(k,val.value.val,valueDisp)
+                func(k,value,disp)
 
     @property
     def root(self):
@@ -19,8 +19,8 @@ import jsonpickle
 
 class ZmqServer(rogue.interfaces.ZmqServer):
 
-    def __init__(self,*,root,addr,port):
-        rogue.interfaces.ZmqServer.__init__(self,addr,port)
+    def __init__(self,*,root,addr,port,workers=4):
+        rogue.interfaces.ZmqServer.__init__(self,addr,port,workers)
         self._root = root
 
     def encode(self,data,rawStr):
@@ -48,6 +48,18 @@ class ZmqServer(rogue.interfaces.ZmqServer):
             if path == "__structure__":
                 return self._root._structure
 
+            # Special case to get variable ids used in binary updates, one 'id path' per line
+            if path == "__varids__":
+                return self.encode(self._root._varIdStr,rawStr=rawStr)
+
+            # Batch get, values are returned in binary update format
+            if path == "__getmany__":
+                return pyrogue.updateToBinary(self._root._getManyEntries(*args,**kwargs))
+
+            # Batch set of display values
+            if path == "__setmany__":
+                return self.encode(self._root.setMany(*args,disp=True,**kwargs),rawStr=False)
+
             node = self._root.getNode(path)
 
             if node is None:
@@ -126,54 +126,11 @@ def connectPgp2bSim(pgpA, pgpB):
     pgpA.sb.setRecvCb(pgpB.sb.send)
     pgpB.sb.setRecvCb(pgpA.sb.send)
 
-class MemEmulate(rogue.interfaces.memory.Slave):
+class MemEmulate(rogue.interfaces.memory.Emulate):
+    """
+    Sparse memory space emulator. Transactions are served in C++ by
+    rogue.interfaces.memory.Emulate without holding the GIL.
+    """
 
     def __init__(self, *, minWidth=4, maxSize=0xFFFFFFFF):
-        rogue.interfaces.memory.Slave.__init__(self,4,4)
-        self._minWidth = minWidth
-        self._maxSize  = maxSize
-        self._data = {}
-        self._cb   = {}
-
-    def _checkRange(self, address, size):
-        return 0
-
-    def _doMaxAccess(self):
-        return(self._maxSize)
-
-    def _doMinAccess(self):
-        return(self._minWidth)
-
-    def _doTransaction(self,transaction):
-        address = transaction.address()
-        size    = transaction.size()
-        type    = transaction.type()
-
-        if (address % self._minWidth) != 0:
-            transaction.done(rogue.interfaces.memory.AddressError)
-            return
-        elif size > self._maxSize:
-            transaction.done(rogue.interfaces.memory.SizeError)
-            return
-
-        for i in range (0, size):
-            if not (address+i) in self._data:
-                self._data[address+i] = 0
-
-        ba = bytearray(size)
-
-        if type == rogue.interfaces.memory.Write or type == rogue.interfaces.memory.Post:
-            transaction.getData(ba,0)
-
-            for i in range(0, size):
-                self._data[address+i] = ba[i]
-
-            transaction.done(0)
-
-        else:
-            for i in range(0, size):
-                ba[i] = self._data[address+i]
-
-            transaction.setData(ba,0)
-            transaction.done(0)
-
+        rogue.interfaces.memory.Emulate.__init__(self,minWidth,maxSize)
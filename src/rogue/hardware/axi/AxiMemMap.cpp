@@ -25,6 +25,7 @@
 #include <cstring>
 #include <thread>
 #include <stdio.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -47,18 +48,72 @@ rha::AxiMemMapPtr rha::AxiMemMap::create (std::string path) {
 
 //! Creator
 rha::AxiMemMap::AxiMemMap(std::string path) : rim::Slave(4,0xFFFFFFFF) {
-   fd_ = ::open(path.c_str(), O_RDWR);
-   log_ = rogue::Logging::create("axi.AxiMemMap");
+   struct stat st;
+   void * ptr;
+
+   fd_      = ::open(path.c_str(), O_RDWR);
+   map_     = NULL;
+   mapSize_ = 0;
+   log_     = rogue::Logging::create("axi.AxiMemMap");
    if ( fd_ < 0 ) throw(rogue::GeneralError::open("AxiMemMap::AxiMemMap",path));
+
+   // Regular files are mapped and accessed directly
+   if ( ::fstat(fd_,&st) == 0 && S_ISREG(st.st_mode) ) {
+      if ( st.st_size == 0 || (ptr = ::mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)) == MAP_FAILED ) {
+         ::close(fd_);
+         throw(rogue::GeneralError::open("AxiMemMap::AxiMemMap",path));
+      }
+      map_     = (uint8_t *)ptr;
+      mapSize_ = st.st_size;
+      log_->info("Mapped %s, size=%" PRIu64,path.c_str(),mapSize_);
+   }
 }
 
 //! Destructor
 rha::AxiMemMap::~AxiMemMap() {
+   if ( map_ != NULL ) ::munmap(map_,mapSize_);
    ::close(fd_);
 }
 
-//! Post a transaction
-void rha::AxiMemMap::doTransaction(rim::TransactionPtr tran) {
+//! Return true if registers are accessed through a user space mapping
+bool rha::AxiMemMap::isMapped() {
+   return(map_ != NULL);
+}
+
+//! Service a transaction through the user space mapping
+uint32_t rha::AxiMemMap::mapTransaction(rim::TransactionPtr tran) {
+   rim::Transaction::iterator it;
+   volatile uint32_t * reg;
+   uint32_t count;
+   uint32_t words;
+   uint32_t data;
+   uint32_t x;
+
+   if ( (tran->address() % sizeof(uint32_t)) != 0 ) return(rim::AddressError);
+   if ( tran->address() > mapSize_ || tran->size() > (mapSize_ - tran->address()) ) return(rim::AddressError);
+
+   reg   = (volatile uint32_t *)(map_ + tran->address());
+   words = tran->size() / sizeof(uint32_t);
+   it    = tran->begin();
+
+   // Registers are accessed one 32-bit word at a time, the transaction buffer may not be aligned
+   if (tran->type() == rim::Write || tran->type() == rim::Post) {
+      for (x=0, count=0; x < words; x++, count += sizeof(uint32_t)) {
+         std::memcpy(&data,it+count,sizeof(uint32_t));
+         reg[x] = data;
+      }
+   }
+   else {
+      for (x=0, count=0; x < words; x++, count += sizeof(uint32_t)) {
+         data = reg[x];
+         std::memcpy(it+count,&data,sizeof(uint32_t));
+      }
+   }
+   return(0);
+}
+
+//! Service a transaction through the driver
+uint32_t rha::AxiMemMap::driverTransaction(rim::TransactionPtr tran) {
    rim::Transaction::iterator it;
 
    uint32_t count;
@@ -70,13 +125,10 @@ void rha::AxiMemMap::doTransaction(rim::TransactionPtr tran) {
    dataSize = sizeof(uint32_t);
    ptr = (uint8_t *)(&data);
 
-   if ( (tran->size() % dataSize) != 0 ) tran->done(rim::SizeError);
-
    count = 0;
    ret = 0;
+   data = 0;
 
-   rogue::GilRelease noGil;
-   rim::TransactionLockPtr lock = tran->lock();
    it = tran->begin();
 
    while ( (ret == 0) && (count != tran->size()) ) {
@@ -95,13 +147,33 @@ void rha::AxiMemMap::doTransaction(rim::TransactionPtr tran) {
    }
 
    log_->debug("Transaction id=0x%08x, addr 0x%08x. Size=%i, type=%i, data=0x%08x",tran->id(),tran->address(),tran->size(),tran->type(),data);
-   tran->done((ret==0)?0:1);
+   return((ret==0)?0:1);
+}
+
+//! Post a transaction
+void rha::AxiMemMap::doTransaction(rim::TransactionPtr tran) {
+   uint32_t error;
+
+   if ( (tran->size() % sizeof(uint32_t)) != 0 ) {
+      tran->done(rim::SizeError);
+      return;
+   }
+
+   rogue::GilRelease noGil;
+   rim::TransactionLock lock(tran);
+
+   if ( map_ != NULL ) error = mapTransaction(tran);
+   else error = driverTransaction(tran);
+
+   tran->done(error);
 }
 
 void rha::AxiMemMap::setup_python () {
 #ifndef NO_PYTHON
 
-   bp::class_<rha::AxiMemMap, rha::AxiMemMapPtr, bp::bases<rim::Slave>, boost::noncopyable >("AxiMemMap",bp::init<std::string>());
+   bp::class_<rha::AxiMemMap, rha::AxiMemMapPtr, bp::bases<rim::Slave>, boost::noncopyable >("AxiMemMap",bp::init<std::string>())
+      .def("isMapped", &rha::AxiMemMap::isMapped)
+   ;
 
    bp::implicitly_convertible<rha::AxiMemMapPtr, rim::SlavePtr>();
 #endif
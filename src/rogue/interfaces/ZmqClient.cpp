@@ -15,16 +15,20 @@
  * ----------------------------------------------------------------------------
 **/
 #include <rogue/interfaces/ZmqClient.h>
+#include <rogue/interfaces/ZmqJson.h>
 #include <rogue/GeneralError.h>
 #include <memory>
 #include <rogue/GilRelease.h>
 #include <rogue/ScopedGil.h>
 #include <rogue/GeneralError.h>
 #include <string>
+#include <cstring>
+#include <vector>
 #include <zmq.h>
 
 #ifndef NO_PYTHON
 #include <boost/python.hpp>
+#include <boost/python/stl_iterator.hpp>
 namespace bp = boost::python;
 #endif
 
@@ -45,6 +49,8 @@ void rogue::interfaces::ZmqClient::setup_python() {
       .def("setDisp",      &rogue::interfaces::ZmqClient::setDisp)
       .def("exec",         &rogue::interfaces::ZmqClient::exec)
       .def("valueDisp",    &rogue::interfaces::ZmqClient::valueDisp)
+      .def("getMany",      &rogue::interfaces::ZmqClient::getManyPy, (bp::arg("paths"), bp::arg("read")=true))
+      .def("setMany",      &rogue::interfaces::ZmqClient::setManyPy, (bp::arg("values"), bp::arg("write")=true))
    ;
 #endif
 }
@@ -93,6 +99,8 @@ rogue::interfaces::ZmqClient::ZmqClient (std::string addr, uint16_t port) {
 
    log_->info("Connected to Rogue server at ports %i:%i:",port,port+1);
 
+   idsValid_ = false;
+
    threadEn_ = true;
    thread_ = new std::thread(&rogue::interfaces::ZmqClient::runThread, this);
 }
@@ -134,6 +142,50 @@ std::string rogue::interfaces::ZmqClient::send(std::string value) {
 
 void rogue::interfaces::ZmqClient::doUpdate ( std::string data ) { }
 
+bool rogue::interfaces::ZmqClient::decodeUpdate(const std::string & data, std::vector<UpdateEntry> & entries) {
+   const char * ptr;
+   uint32_t count;
+   uint32_t len;
+   uint32_t x;
+   size_t   pos;
+   UpdateEntry ent;
+
+   entries.clear();
+   ptr = data.c_str();
+
+   if ( data.size() < 8 || data.compare(0,4,"RUP1") != 0 ) return(false);
+   std::memcpy(&count,ptr+4,4);
+   pos = 8;
+
+   for (x=0; x < count; x++) {
+      if ( (pos + 9) > data.size() ) return(false);
+      std::memcpy(&(ent.id),ptr+pos,4);
+      ent.type = (uint8_t)ptr[pos+4];
+      std::memcpy(&len,ptr+pos+5,4);
+      pos += 9;
+
+      if ( (pos + len + 4) > data.size() ) return(false);
+      ent.value.assign(ptr+pos,len);
+      pos += len;
+
+      std::memcpy(&len,ptr+pos,4);
+      pos += 4;
+
+      if ( len == 0xFFFFFFFF ) {
+         ent.disp.clear();
+         ent.dispValid = false;
+      }
+      else {
+         if ( (pos + len) > data.size() ) return(false);
+         ent.disp.assign(ptr+pos,len);
+         ent.dispValid = true;
+         pos += len;
+      }
+      entries.push_back(ent);
+   }
+   return(true);
+}
+
 #ifndef NO_PYTHON
 
 rogue::interfaces::ZmqClientWrap::ZmqClientWrap (std::string addr, uint16_t port) : rogue::interfaces::ZmqClient(addr,port) {}
@@ -144,7 +196,7 @@ void rogue::interfaces::ZmqClientWrap::doUpdate ( std::string data ) {
 
       if (bp::override f = this->get_override("_doUpdate")) {
          try {
-            f(data);
+            f(bp::object(bp::handle<>(PyBytes_FromStringAndSize(data.c_str(),data.size()))));
          } catch (...) {
             PyErr_Print();
          }
@@ -160,6 +212,8 @@ void rogue::interfaces::ZmqClientWrap::defDoUpdate ( std::string data ) {
 #endif
 
 void rogue::interfaces::ZmqClient::runThread() {
+   std::vector<UpdateEntry> entries;
+   std::vector<UpdateEntry>::iterator it;
    std::string data;
    std::string ret;
    zmq_msg_t msg;
@@ -173,6 +227,15 @@ void rogue::interfaces::ZmqClient::runThread() {
       if ( zmq_recvmsg(this->zmqSub_,&msg,0) > 0 ) {
          data = std::string((const char *)zmq_msg_data(&msg),zmq_msg_size(&msg));
          zmq_msg_close(&msg);
+
+         // Refresh the local cache
+         if ( decodeUpdate(data,entries) ) {
+            std::lock_guard<std::mutex> lock(cacheMtx_);
+            for (it=entries.begin(); it != entries.end(); ++it) {
+               if ( it->dispValid ) values_[it->id] = it->disp;
+               else values_.erase(it->id);
+            }
+         }
          this->doUpdate(data);
       }
    }
@@ -182,11 +245,11 @@ std::string rogue::interfaces::ZmqClient::sendWrapper(std::string path, std::str
    std::string snd;
    std::string ret;
 
-   snd  = "{\"attr\": \"" + attr + "\",";
-   snd += "\"path\": \"" + path + "\",";
+   snd  = "{\"attr\": " + rogue::interfaces::ZmqJson::quote(attr) + ",";
+   snd += "\"path\": " + rogue::interfaces::ZmqJson::quote(path) + ",";
 
    if (arg != "") 
-      snd += "\"args\": {\"py/tuple\": [\"" + arg + "\"]},";
+      snd += "\"args\": {\"py/tuple\": [" + rogue::interfaces::ZmqJson::quote(arg) + "]},";
 
    if ( rawStr ) snd += "\"rawStr\": true}";
    else snd += "\"rawStr\": false}";
@@ -194,19 +257,137 @@ std::string rogue::interfaces::ZmqClient::sendWrapper(std::string path, std::str
    return(send(snd));
 }
 
+// Lookup a display value in the local cache, loading the id map on first use
+bool rogue::interfaces::ZmqClient::cachedDisp(const std::string & path, std::string & disp) {
+   std::map<std::string, uint32_t>::iterator iit;
+   std::map<uint32_t, std::string>::iterator vit;
+   std::string resp;
+   std::string line;
+   size_t pos;
+   size_t end;
+   size_t sep;
+
+   if ( ! idsValid_ ) {
+      resp = sendWrapper("__varids__", "", "", true);
+
+      std::lock_guard<std::mutex> lock(cacheMtx_);
+      for (pos=0; pos < resp.size(); pos = end+1) {
+         if ( (end = resp.find('\n',pos)) == std::string::npos ) end = resp.size();
+         line = resp.substr(pos,end-pos);
+         if ( (sep = line.find(' ')) != std::string::npos ) 
+            ids_[line.substr(sep+1)] = std::stoul(line.substr(0,sep));
+      }
+      idsValid_ = true;
+   }
+
+   std::lock_guard<std::mutex> lock(cacheMtx_);
+   if ( (iit = ids_.find(path)) == ids_.end() ) return(false);
+   if ( (vit = values_.find(iit->second)) == values_.end() ) return(false);
+   disp = vit->second;
+   return(true);
+}
+
+// Drop a cached display value, the next update refreshes it
+void rogue::interfaces::ZmqClient::invalidate(const std::string & path) {
+   std::map<std::string, uint32_t>::iterator iit;
+
+   std::lock_guard<std::mutex> lock(cacheMtx_);
+   if ( (iit = ids_.find(path)) != ids_.end() ) values_.erase(iit->second);
+}
+
 std::string rogue::interfaces::ZmqClient::getDisp(std::string path) {
    return sendWrapper(path, "getDisp", "", true);
 }
 
 void rogue::interfaces::ZmqClient::setDisp(std::string path, std::string value) {
+   invalidate(path);
    sendWrapper(path, "setDisp", value, true);
+   invalidate(path);
 }
 
 std::string rogue::interfaces::ZmqClient::exec(std::string path, std::string arg) {
-   return sendWrapper(path, "call", arg, true);
+   std::string ret;
+
+   invalidate(path);
+   ret = sendWrapper(path, "call", arg, true);
+   invalidate(path);
+   return(ret);
 }
 
 std::string rogue::interfaces::ZmqClient::valueDisp(std::string path) {
+   std::string ret;
+
+   if ( cachedDisp(path,ret) ) return(ret);
    return sendWrapper(path, "valueDisp", "", true);
 }
 
+std::vector<std::string> rogue::interfaces::ZmqClient::getMany(std::vector<std::string> paths, bool read) {
+   std::vector<std::string>::iterator it;
+   std::vector<std::string> ret;
+   std::vector<UpdateEntry> entries;
+   std::vector<UpdateEntry>::iterator eit;
+   std::string snd;
+
+   snd = "{\"attr\": \"\", \"path\": \"__getmany__\", \"args\": {\"py/tuple\": [[";
+
+   for (it=paths.begin(); it != paths.end(); ++it) {
+      if ( it != paths.begin() ) snd += ", ";
+      snd += rogue::interfaces::ZmqJson::quote(*it);
+   }
+   snd += "]]}, \"kwargs\": {\"read\": ";
+   snd += (read ? "true" : "false");
+   snd += "}}";
+
+   if ( (! decodeUpdate(send(snd),entries)) || entries.size() != paths.size() ) 
+      throw(rogue::GeneralError("ZmqClient::getMany","Invalid response"));
+
+   for (eit=entries.begin(); eit != entries.end(); ++eit) ret.push_back(eit->disp);
+   return(ret);
+}
+
+void rogue::interfaces::ZmqClient::setMany(std::map<std::string, std::string> values, bool write) {
+   std::map<std::string, std::string>::iterator it;
+   std::string snd;
+
+   snd = "{\"attr\": \"\", \"path\": \"__setmany__\", \"args\": {\"py/tuple\": [{";
+
+   for (it=values.begin(); it != values.end(); ++it) {
+      if ( it != values.begin() ) snd += ", ";
+      snd += rogue::interfaces::ZmqJson::quote(it->first) + ": " + rogue::interfaces::ZmqJson::quote(it->second);
+   }
+   snd += "}]}, \"kwargs\": {\"write\": ";
+   snd += (write ? "true" : "false");
+   snd += "}}";
+
+   for (it=values.begin(); it != values.end(); ++it) invalidate(it->first);
+   send(snd);
+   for (it=values.begin(); it != values.end(); ++it) invalidate(it->first);
+}
+
+#ifndef NO_PYTHON
+
+bp::list rogue::interfaces::ZmqClient::getManyPy(bp::object paths, bool read) {
+   std::vector<std::string> vec;
+   std::vector<std::string>::iterator it;
+   bp::list ret;
+   bp::stl_input_iterator<std::string> pit(paths), end;
+
+   for (; pit != end; ++pit) vec.push_back(*pit);
+
+   vec = getMany(vec,read);
+   for (it=vec.begin(); it != vec.end(); ++it) ret.append(*it);
+   return(ret);
+}
+
+void rogue::interfaces::ZmqClient::setManyPy(bp::dict values, bool write) {
+   std::map<std::string, std::string> vals;
+   bp::list keys = values.keys();
+   uint32_t x;
+
+   for (x=0; x < bp::len(keys); x++) 
+      vals[bp::extract<std::string>(keys[x])] = bp::extract<std::string>(values[keys[x]]);
+
+   setMany(vals,write);
+}
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Rogue ZMQ JSON Helpers
+ * ----------------------------------------------------------------------------
+ * File       : ZmqJson.cpp
+ * Created    : 2019-05-02
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/ZmqJson.h>
+#include <string>
+#include <map>
+#include <stdint.h>
+#include <ctype.h>
+#include <stdio.h>
+
+// Skip a JSON string starting at pos, return position after closing quote
+static size_t jsonSkipString(const std::string & data, size_t pos) {
+   for (++pos; pos < data.size(); ++pos) {
+      if ( data[pos] == '\\' ) ++pos;
+      else if ( data[pos] == '"' ) return(pos+1);
+   }
+   return(std::string::npos);
+}
+
+// Skip whitespace
+static size_t jsonSkipSpace(const std::string & data, size_t pos) {
+   while ( pos < data.size() && isspace((uint8_t)data[pos]) ) ++pos;
+   return(pos);
+}
+
+// Read the four hex digits of a \u escape starting at pos
+static bool jsonHex(const std::string & data, size_t pos, uint32_t & value) {
+   size_t x;
+
+   if ( pos+4 > data.size() ) return(false);
+   value = 0;
+
+   for (x=pos; x < pos+4; x++) {
+      if ( ! isxdigit((uint8_t)data[x]) ) return(false);
+      value = (value << 4) | (isdigit((uint8_t)data[x]) ? (data[x] - '0') : ((tolower((uint8_t)data[x]) - 'a') + 10));
+   }
+   return(true);
+}
+
+//! Split a JSON object into its top level fields
+bool rogue::interfaces::ZmqJson::fields(const std::string & data, std::map<std::string, std::string> & fields) {
+   size_t pos;
+   size_t end;
+   int32_t depth;
+   std::string key;
+   std::string val;
+
+   pos = jsonSkipSpace(data,0);
+   if ( pos >= data.size() || data[pos] != '{' ) return(false);
+   pos = jsonSkipSpace(data,pos+1);
+
+   while ( pos < data.size() && data[pos] != '}' ) {
+
+      // Key
+      if ( data[pos] != '"' || (end = jsonSkipString(data,pos)) == std::string::npos ) return(false);
+      key = data.substr(pos+1,end-pos-2);
+      pos = jsonSkipSpace(data,end);
+      if ( pos >= data.size() || data[pos] != ':' ) return(false);
+      pos = jsonSkipSpace(data,pos+1);
+
+      // Value
+      val.clear();
+      depth = 0;
+      while ( pos < data.size() ) {
+         if ( data[pos] == '"' ) {
+            if ( (end = jsonSkipString(data,pos)) == std::string::npos ) return(false);
+            val.append(data,pos,end-pos);
+            pos = end;
+            continue;
+         }
+         if ( depth == 0 && (data[pos] == ',' || data[pos] == '}') ) break;
+         if ( data[pos] == '{' || data[pos] == '[' ) ++depth;
+         else if ( data[pos] == '}' || data[pos] == ']' ) --depth;
+         if ( ! isspace((uint8_t)data[pos]) ) val += data[pos];
+         ++pos;
+      }
+      fields[key] = val;
+
+      if ( pos < data.size() && data[pos] == ',' ) pos = jsonSkipSpace(data,pos+1);
+   }
+   return(pos < data.size());
+}
+
+//! Decode a JSON string literal
+bool rogue::interfaces::ZmqJson::decode(const std::string & raw, std::string & out) {
+   size_t   x;
+   uint32_t cp;
+   uint32_t lo;
+
+   if ( raw.size() < 2 || raw[0] != '"' || raw[raw.size()-1] != '"' ) return(false);
+   out.clear();
+
+   for (x=1; x < raw.size()-1; x++) {
+      if ( raw[x] != '\\' ) {
+         out += raw[x];
+         continue;
+      }
+      if ( ++x >= raw.size()-1 ) return(false);
+
+      switch (raw[x]) {
+         case 'b': out += '\b'; break;
+         case 'f': out += '\f'; break;
+         case 'n': out += '\n'; break;
+         case 'r': out += '\r'; break;
+         case 't': out += '\t'; break;
+         case 'u':
+            if ( x+4 >= raw.size()-1 || ! jsonHex(raw,x+1,cp) ) return(false);
+            x += 4;
+
+            // Surrogate pair
+            if ( cp >= 0xD800 && cp <= 0xDBFF && x+6 < raw.size()-1 && raw[x+1] == '\\' && raw[x+2] == 'u' ) {
+               if ( ! jsonHex(raw,x+3,lo) || lo < 0xDC00 || lo > 0xDFFF ) return(false);
+               cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+               x += 6;
+            }
+
+            // Encode as UTF-8
+            if ( cp < 0x80 ) out += (char)cp;
+            else if ( cp < 0x800 ) {
+               out += (char)(0xC0 | (cp >> 6));
+               out += (char)(0x80 | (cp & 0x3F));
+            }
+            else if ( cp < 0x10000 ) {
+               out += (char)(0xE0 | (cp >> 12));
+               out += (char)(0x80 | ((cp >> 6) & 0x3F));
+               out += (char)(0x80 | (cp & 0x3F));
+            }
+            else {
+               out += (char)(0xF0 | (cp >> 18));
+               out += (char)(0x80 | ((cp >> 12) & 0x3F));
+               out += (char)(0x80 | ((cp >> 6) & 0x3F));
+               out += (char)(0x80 | (cp & 0x3F));
+            }
+            break;
+         default: out += raw[x]; break;
+      }
+   }
+   return(true);
+}
+
+//! Encode a string as a JSON string literal
+std::string rogue::interfaces::ZmqJson::quote(const std::string & in) {
+   std::string ret;
+   char buf[8];
+   size_t x;
+
+   ret = "\"";
+   for (x=0; x < in.size(); x++) {
+      switch (in[x]) {
+         case '"':  ret += "\\\""; break;
+         case '\\': ret += "\\\\"; break;
+         case '\b': ret += "\\b";  break;
+         case '\f': ret += "\\f";  break;
+         case '\n': ret += "\\n";  break;
+         case '\r': ret += "\\r";  break;
+         case '\t': ret += "\\t";  break;
+         default:
+            if ( (uint8_t)in[x] < 0x20 ) {
+               snprintf(buf,8,"\\u%04x",(uint8_t)in[x]);
+               ret += buf;
+            }
+            else ret += in[x];
+            break;
+      }
+   }
+   ret += "\"";
+   return(ret);
+}
+
@@ -15,11 +15,16 @@
  * ----------------------------------------------------------------------------
 **/
 #include <rogue/interfaces/ZmqServer.h>
+#include <rogue/interfaces/ZmqJson.h>
 #include <rogue/GeneralError.h>
 #include <memory>
 #include <rogue/GilRelease.h>
 #include <rogue/ScopedGil.h>
 #include <string>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <inttypes.h>
 #include <zmq.h>
 
 #ifndef NO_PYTHON
@@ -27,8 +32,8 @@
 namespace bp = boost::python;
 #endif
 
-rogue::interfaces::ZmqServerPtr rogue::interfaces::ZmqServer::create(std::string addr, uint16_t port) {
-   rogue::interfaces::ZmqServerPtr ret = std::make_shared<rogue::interfaces::ZmqServer>(addr,port);
+rogue::interfaces::ZmqServerPtr rogue::interfaces::ZmqServer::create(std::string addr, uint16_t port, uint32_t workers) {
+   rogue::interfaces::ZmqServerPtr ret = std::make_shared<rogue::interfaces::ZmqServer>(addr,port,workers);
    return(ret);
 }
 
@@ -36,21 +41,29 @@ rogue::interfaces::ZmqServerPtr rogue::interfaces::ZmqServer::create(std::string
 void rogue::interfaces::ZmqServer::setup_python() {
 #ifndef NO_PYTHON
 
-   bp::class_<rogue::interfaces::ZmqServerWrap, rogue::interfaces::ZmqServerWrapPtr, boost::noncopyable>("ZmqServer",bp::init<std::string, uint16_t>())
-      .def("_doRequest", &rogue::interfaces::ZmqServer::doRequest, &rogue::interfaces::ZmqServerWrap::defDoRequest)
-      .def("_publish",   &rogue::interfaces::ZmqServer::publish)
+   bp::class_<rogue::interfaces::ZmqServerWrap, rogue::interfaces::ZmqServerWrapPtr, boost::noncopyable>("ZmqServer",bp::init<std::string, uint16_t, bp::optional<uint32_t> >())
+      .def("_doRequest",   &rogue::interfaces::ZmqServer::doRequest, &rogue::interfaces::ZmqServerWrap::defDoRequest)
+      .def("_publish",     &rogue::interfaces::ZmqServer::publish)
+      .def("_updateCache", &rogue::interfaces::ZmqServer::updateCachePy)
+      .def("_clearCache",  &rogue::interfaces::ZmqServer::clearCache)
+      .def("setTimeout",   &rogue::interfaces::ZmqServer::setTimeout)
    ;
 #endif
 }
 
-rogue::interfaces::ZmqServer::ZmqServer (std::string addr, uint16_t port) {
+rogue::interfaces::ZmqServer::ZmqServer (std::string addr, uint16_t port, uint32_t workers) {
    std::string temp;
+   uint32_t x;
+   int32_t opt;
 
    log_ = rogue::Logging::create("ZmqServer");
 
    this->zmqCtx_  = zmq_ctx_new();
    this->zmqPub_  = zmq_socket(this->zmqCtx_,ZMQ_PUB);
-   this->zmqRep_  = zmq_socket(this->zmqCtx_,ZMQ_REP);
+   this->zmqRep_  = zmq_socket(this->zmqCtx_,ZMQ_ROUTER);
+   this->zmqBack_ = zmq_socket(this->zmqCtx_,ZMQ_PULL);
+
+   timeout_ = 0;
 
    // Setup publish port
    temp = "tcp://";
@@ -70,19 +83,41 @@ rogue::interfaces::ZmqServer::ZmqServer (std::string addr, uint16_t port) {
    if ( zmq_bind(this->zmqRep_,temp.c_str()) < 0 ) 
       throw(rogue::GeneralError::network("ZmqServer::ZmqServer",addr,port+1));
 
-   log_->info("Started to Rogue server at ports %i:%i:",port,port+1);
+   // Setup worker response port, must be bound before workers connect
+   backAddr_ = "inproc://workers";
+   opt = 0;
+   zmq_setsockopt(this->zmqBack_, ZMQ_LINGER, &opt, sizeof(int32_t));
+
+   if ( zmq_bind(this->zmqBack_,backAddr_.c_str()) < 0 ) 
+      throw(rogue::GeneralError("ZmqServer::ZmqServer","Failed to bind worker port"));
+
+   log_->info("Started to Rogue server at ports %i:%i with %i workers",port,port+1,workers);
+
+   if ( workers == 0 ) workers = 1;
+   workersEn_ = true;
+   for (x=0; x < workers; x++) 
+      workers_.push_back(new std::thread(&rogue::interfaces::ZmqServer::runWorker, this));
 
    threadEn_ = true;
    thread_ = new std::thread(&rogue::interfaces::ZmqServer::runThread, this);
 }
 
 rogue::interfaces::ZmqServer::~ZmqServer() {
+   std::vector<std::thread *>::iterator it;
+
    rogue::GilRelease noGil;
+
+   // Stop workers
+   workersEn_ = false;
+   workQueue_.stop();
+   for (it=workers_.begin(); it != workers_.end(); ++it) (*it)->join();
+
+   // Broker closes its own sockets
    threadEn_ = false;
+   thread_->join();
+
    zmq_close(this->zmqPub_);
-   zmq_close(this->zmqRep_);
    zmq_term(this->zmqCtx_);
-   thread_->join();
 }
 
 void rogue::interfaces::ZmqServer::publish(std::string value) {
@@ -94,9 +129,50 @@ std::string rogue::interfaces::ZmqServer::doRequest ( std::string data ) {
    return("");
 }
 
+void rogue::interfaces::ZmqServer::setTimeout(uint32_t msecs) {
+   timeout_ = msecs;
+}
+
+void rogue::interfaces::ZmqServer::updateCache(std::string path, std::string json, std::string disp) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cacheMtx_);
+   CacheEntry & ent = cache_[path];
+   ent.json = json;
+   ent.disp = disp;
+}
+
+void rogue::interfaces::ZmqServer::clearCache() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cacheMtx_);
+   cache_.clear();
+}
+
 #ifndef NO_PYTHON
 
-rogue::interfaces::ZmqServerWrap::ZmqServerWrap (std::string addr, uint16_t port) : rogue::interfaces::ZmqServer(addr,port) {}
+// Only simple types are cached, others are encoded by python on request
+void rogue::interfaces::ZmqServer::updateCachePy(std::string path, bp::object value, std::string disp) {
+   std::string json;
+   PyObject * obj;
+   double     d;
+
+   obj = value.ptr();
+
+   if ( obj == Py_None ) json = "null";
+   else if ( PyBool_Check(obj) ) json = (obj == Py_True) ? "true" : "false";
+   else if ( PyLong_CheckExact(obj) ) json = bp::extract<std::string>(bp::str(value));
+   else if ( PyFloat_CheckExact(obj) ) {
+      d = PyFloat_AsDouble(obj);
+      if ( std::isnan(d) ) json = "NaN";
+      else if ( std::isinf(d) ) json = (d > 0) ? "Infinity" : "-Infinity";
+      else json = bp::extract<std::string>(bp::object(bp::handle<>(PyObject_Repr(obj))));
+   }
+   else if ( PyUnicode_CheckExact(obj) ) json = rogue::interfaces::ZmqJson::quote(bp::extract<std::string>(value));
+
+   updateCache(path,json,disp);
+}
+
+rogue::interfaces::ZmqServerWrap::ZmqServerWrap (std::string addr, uint16_t port, uint32_t workers) : 
+   rogue::interfaces::ZmqServer(addr,port,workers) {}
 
 std::string rogue::interfaces::ZmqServerWrap::doRequest ( std::string data ) {
    {
@@ -119,23 +195,211 @@ std::string rogue::interfaces::ZmqServerWrap::defDoRequest ( std::string data )
 
 #endif
 
-void rogue::interfaces::ZmqServer::runThread() {
-   std::string data;
+// Attempt to serve a request from the snapshot cache
+bool rogue::interfaces::ZmqServer::doCached(const std::string & data, std::string & ret) {
+   std::map<std::string, std::string> fields;
+   std::map<std::string, std::string>::iterator fit;
+   std::map<std::string, std::string> values;
+   std::map<std::string, CacheEntry>::iterator cit;
+   std::string path;
+   std::string attr;
+   bool rawStr;
+   bool isDisp;
+
+   if ( ! rogue::interfaces::ZmqJson::fields(data,fields) ) return(false);
+
+   if ( (fit = fields.find("path")) == fields.end() || ! rogue::interfaces::ZmqJson::decode(fit->second,path) ) return(false);
+   if ( (fit = fields.find("attr")) == fields.end() || ! rogue::interfaces::ZmqJson::decode(fit->second,attr) ) return(false);
+
+   // Requests which change a value drop its snapshot until the update worker refreshes it
+   if ( attr == "set" || attr == "setDisp" || attr == "post" || attr == "call" || attr == "__call__" ) {
+      std::lock_guard<std::mutex> lock(cacheMtx_);
+      cache_.erase(path);
+      return(false);
+   }
+
+   // Batch set, the values are the first positional argument
+   if ( path == "__setmany__" || attr == "setMany" ) {
+      if ( (fit = fields.find("args")) != fields.end() && rogue::interfaces::ZmqJson::fields(fit->second,values) &&
+           (fit = values.find("py/tuple")) != values.end() && fit->second.size() > 1 ) {
+         std::string args = fit->second.substr(1);
+
+         values.clear();
+         if ( rogue::interfaces::ZmqJson::fields(args,values) ) {
+            std::lock_guard<std::mutex> lock(cacheMtx_);
+            for (fit = values.begin(); fit != values.end(); ++fit) cache_.erase(fit->first);
+            return(false);
+         }
+      }
+
+      // Unknown argument layout, drop the full snapshot
+      std::lock_guard<std::mutex> lock(cacheMtx_);
+      cache_.clear();
+      return(false);
+   }
+
+   // No positional arguments allowed
+   if ( (fit = fields.find("args")) != fields.end() && 
+        fit->second != "{\"py/tuple\":[]}" && fit->second != "[]" ) return(false);
+
+   // Value requests never read hardware, get requests must pass read=False
+   if ( attr == "value" || attr == "valueDisp" ) {
+      if ( (fit = fields.find("kwargs")) != fields.end() && fit->second != "{}" ) return(false);
+   }
+   else if ( attr == "get" || attr == "getDisp" ) {
+      if ( (fit = fields.find("kwargs")) == fields.end() || fit->second != "{\"read\":false}" ) return(false);
+   }
+   else return(false);
+
+   isDisp = (attr == "valueDisp" || attr == "getDisp");
+   rawStr = ((fit = fields.find("rawStr")) != fields.end() && fit->second == "true");
+
+   std::lock_guard<std::mutex> lock(cacheMtx_);
+   if ( (cit = cache_.find(path)) == cache_.end() ) return(false);
+
+   if ( isDisp ) ret = rawStr ? cit->second.disp : rogue::interfaces::ZmqJson::quote(cit->second.disp);
+   else {
+      if ( cit->second.json.empty() ) return(false);
+      if ( ! (rawStr && rogue::interfaces::ZmqJson::decode(cit->second.json,ret)) ) ret = cit->second.json;
+   }
+   return(true);
+}
+
+// Worker thread
+void rogue::interfaces::ZmqServer::runWorker() {
+   std::pair<uint64_t, std::string> req;
    std::string ret;
+   void * sock;
+   int32_t opt;
+
+   log_->logThreadId();
+
+   sock = zmq_socket(this->zmqCtx_,ZMQ_PUSH);
+   opt = 0;
+   zmq_setsockopt(sock, ZMQ_LINGER, &opt, sizeof(int32_t));
+   zmq_connect(sock,backAddr_.c_str());
+
+   while(workersEn_) {
+      req = workQueue_.pop();
+      if ( ! workersEn_ ) break;
+
+      ret = this->doRequest(req.second);
+
+      zmq_send(sock,&(req.first),8,ZMQ_SNDMORE);
+      zmq_send(sock,ret.c_str(),ret.size(),0);
+   }
+   zmq_close(sock);
+}
+
+// Broker thread
+void rogue::interfaces::ZmqServer::runThread() {
+
+   // Pending request
+   struct Pending {
+      std::vector<std::string> env;
+      std::chrono::steady_clock::time_point deadline;
+   };
+
+   std::map<uint64_t, Pending> pending;
+   std::map<uint64_t, Pending>::iterator it;
+   std::vector<std::string> frames;
+   std::vector<std::string>::iterator fit;
+   std::chrono::steady_clock::time_point now;
+   zmq_pollitem_t items[2];
    zmq_msg_t msg;
+   uint64_t  more;
+   size_t    moreSize;
+   uint64_t  tag;
+   uint64_t  rtag;
+   std::string body;
+   std::string ret;
 
    log_->logThreadId();
 
-   while(threadEn_) {
-      zmq_msg_init(&msg);
+   items[0].socket = this->zmqRep_;
+   items[0].fd     = 0;
+   items[0].events = ZMQ_POLLIN;
+   items[1].socket = this->zmqBack_;
+   items[1].fd     = 0;
+   items[1].events = ZMQ_POLLIN;
+   tag = 0;
 
-      // Get the message
-      if ( zmq_recvmsg(this->zmqRep_,&msg,0) > 0 ) {
-         data = std::string((const char *)zmq_msg_data(&msg),zmq_msg_size(&msg));
-         ret = this->doRequest(data);
-         zmq_send(this->zmqRep_,ret.c_str(),ret.size(),0);
+   // Receive a multi-part message
+   auto recvFrames = [&](void * sock) {
+      frames.clear();
+      do {
+         zmq_msg_init(&msg);
+         if ( zmq_recvmsg(sock,&msg,0) < 0 ) {
+            zmq_msg_close(&msg);
+            break;
+         }
+         frames.push_back(std::string((const char *)zmq_msg_data(&msg),zmq_msg_size(&msg)));
          zmq_msg_close(&msg);
+         more = 0;
+         moreSize = 8;
+         zmq_getsockopt(sock, ZMQ_RCVMORE, &more, &moreSize);
+      } while (more);
+   };
+
+   // Send a reply with the client envelope
+   auto sendReply = [&](std::vector<std::string> & env, const std::string & data) {
+      for (fit=env.begin(); fit != env.end(); ++fit) 
+         zmq_send(this->zmqRep_,fit->c_str(),fit->size(),ZMQ_SNDMORE);
+      zmq_send(this->zmqRep_,data.c_str(),data.size(),0);
+   };
+
+   while(threadEn_) {
+      if ( zmq_poll(items,2,100) < 0 ) continue;
+
+      // New request
+      if ( items[0].revents & ZMQ_POLLIN ) {
+         recvFrames(this->zmqRep_);
+
+         if ( frames.size() > 1 ) {
+            body = frames.back();
+            frames.pop_back();
+
+            if ( doCached(body,ret) ) sendReply(frames,ret);
+            else {
+               ++tag;
+               Pending & p = pending[tag];
+               p.env = frames;
+               p.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_);
+               workQueue_.push(std::make_pair(tag,body));
+            }
+         }
+      }
+
+      // Worker response
+      if ( items[1].revents & ZMQ_POLLIN ) {
+         recvFrames(this->zmqBack_);
+
+         if ( frames.size() == 2 && frames[0].size() == 8 ) {
+            std::memcpy(&rtag,frames[0].c_str(),8);
+
+            if ( (it = pending.find(rtag)) != pending.end() ) {
+               sendReply(it->second.env,frames[1]);
+               pending.erase(it);
+            }
+            else log_->debug("Dropping late response for request %" PRIu64,rtag);
+         }
+      }
+
+      // Expire timed out requests
+      if ( timeout_ > 0 ) {
+         now = std::chrono::steady_clock::now();
+         it = pending.begin();
+         while ( it != pending.end() ) {
+            if ( now >= it->second.deadline ) {
+               log_->warning("Request %" PRIu64 " timed out",it->first);
+               sendReply(it->second.env,"null\n");
+               it = pending.erase(it);
+            }
+            else ++it;
+         }
       }
    }
-}
 
+   zmq_close(this->zmqRep_);
+   zmq_close(this->zmqBack_);
+}
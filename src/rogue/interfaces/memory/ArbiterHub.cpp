@@ -0,0 +1,391 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Arbiter Hub
+ * ----------------------------------------------------------------------------
+ * File       : ArbiterHub.cpp
+ * Created    : 2019-01-24
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which shares a Slave between several Masters.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/ArbiterHub.h>
+#include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GeneralError.h>
+#include <rogue/GilRelease.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <inttypes.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a hub, class creator
+rim::ArbiterHubPtr rim::ArbiterHub::create (uint64_t offset, uint32_t depth) {
+   rim::ArbiterHubPtr b = std::make_shared<rim::ArbiterHub>(offset,depth);
+   return(b);
+}
+
+//! Create a hub
+rim::ArbiterHub::ArbiterHub(uint64_t offset, uint32_t depth) : Hub(offset,0,0) {
+   depth_       = depth;
+   outstanding_ = 0;
+   rrPort_      = 0;
+   rrCredit_    = 1;
+
+   log_ = rogue::Logging::create("memory.ArbiterHub");
+
+   // Port 0 for directly attached masters
+   addPort(1,0);
+}
+
+//! Destroy a hub
+rim::ArbiterHub::~ArbiterHub() {
+   stopAsync();
+}
+
+void rim::ArbiterHub::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::ArbiterHub, rim::ArbiterHubPtr, bp::bases<rim::Hub>, boost::noncopyable>("ArbiterHub",bp::init<uint64_t,uint32_t>())
+       .def("setPort",        &rim::ArbiterHub::setPort)
+       .def("setDepth",       &rim::ArbiterHub::setDepth)
+       .def("getQueued",      &rim::ArbiterHub::getQueued)
+       .def("getOutstanding", &rim::ArbiterHub::getOutstanding)
+       .def("resetStats",     &rim::ArbiterHub::resetStats)
+       .def("getStats",       &rim::ArbiterHub::getStats)
+   ;
+
+   bp::implicitly_convertible<rim::ArbiterHubPtr, rim::HubPtr>();
+   bp::implicitly_convertible<rim::ArbiterHubPtr, rim::MasterPtr>();
+   bp::implicitly_convertible<rim::ArbiterHubPtr, rim::SlavePtr>();
+#endif
+}
+
+//! Add a port
+uint32_t rim::ArbiterHub::addPort(uint32_t weight, uint32_t limit) {
+   Port p;
+
+   p.weight      = std::max(weight,(uint32_t)1);
+   p.limit       = limit;
+   p.outstanding = 0;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(arbMtx_);
+
+   ports_.push_back(p);
+   clearStats();
+   return(ports_.size()-1);
+}
+
+//! Set the weight and outstanding limit of a port
+void rim::ArbiterHub::setPort(uint32_t port, uint32_t weight, uint32_t limit) {
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(arbMtx_);
+
+      if ( port >= ports_.size() )
+         throw(rogue::GeneralError::boundary("ArbiterHub::setPort",port,ports_.size()));
+
+      ports_[port].weight = std::max(weight,(uint32_t)1);
+      ports_[port].limit  = limit;
+   }
+   dispatch();
+}
+
+//! Set the max outstanding transactions
+void rim::ArbiterHub::setDepth(uint32_t depth) {
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(arbMtx_);
+      depth_ = depth;
+   }
+   dispatch();
+}
+
+//! Get the number of queued transactions for a port
+uint32_t rim::ArbiterHub::getQueued(uint32_t port) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(arbMtx_);
+
+   if ( port >= ports_.size() ) return(0);
+   return(ports_[port].queue.size());
+}
+
+//! Get the number of outstanding transactions
+uint32_t rim::ArbiterHub::getOutstanding() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(arbMtx_);
+   return(outstanding_);
+}
+
+//! Reset port statistics
+void rim::ArbiterHub::resetStats() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(arbMtx_);
+   clearStats();
+}
+
+//! Clear port statistics, arbMtx_ must be held
+void rim::ArbiterHub::clearStats() {
+   std::vector<Port>::iterator it;
+
+   for (it = ports_.begin(); it != ports_.end(); ++it) {
+      it->count    = 0;
+      it->bytes    = 0;
+      it->errors   = 0;
+      it->waitSum  = 0;
+      it->waitMax  = 0;
+      it->maxDepth = 0;
+   }
+   statsTime_ = std::chrono::steady_clock::now();
+}
+
+//! Queue a transaction for a port
+void rim::ArbiterHub::queueTransaction(rim::TransactionPtr tran, uint32_t port) {
+
+   // Adjust address
+   tran->address_ |= getOffset();
+
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(arbMtx_);
+      Port & p = ports_[port];
+
+      p.queue.push_back(std::make_pair(tran,std::chrono::steady_clock::now()));
+      p.maxDepth = std::max(p.maxDepth,(uint64_t)p.queue.size());
+   }
+   dispatch();
+}
+
+//! Post a transaction. Master will call this method with the access attributes.
+void rim::ArbiterHub::doTransaction(rim::TransactionPtr tran) {
+   queueTransaction(tran,0);
+}
+
+//! Forward queued transactions while slots are free
+void rim::ArbiterHub::dispatch() {
+   std::chrono::steady_clock::time_point queued;
+   rim::TransactionPtr tran;
+   uint32_t port;
+   uint32_t x;
+
+   while (1) {
+      {
+         std::lock_guard<std::mutex> lock(arbMtx_);
+
+         if ( depth_ != 0 && outstanding_ >= depth_ ) return;
+
+         // Current port keeps its turn while it has weight left, otherwise move on
+         for (x=0; x <= ports_.size(); x++) {
+            Port & p = ports_[rrPort_];
+
+            if ( rrCredit_ != 0 && (! p.queue.empty()) && (p.limit == 0 || p.outstanding < p.limit) ) break;
+
+            rrPort_   = (rrPort_ + 1) % ports_.size();
+            rrCredit_ = ports_[rrPort_].weight;
+         }
+         if ( x > ports_.size() ) return;
+
+         port = rrPort_;
+         Port & p = ports_[port];
+
+         tran   = p.queue.front().first;
+         queued = p.queue.front().second;
+         p.queue.pop_front();
+
+         --rrCredit_;
+         ++p.outstanding;
+         ++outstanding_;
+      }
+
+      forward(tran,queued,port);
+   }
+}
+
+//! Forward a transaction
+void rim::ArbiterHub::forward(rim::TransactionPtr tran, std::chrono::steady_clock::time_point queued, uint32_t port) {
+   std::shared_ptr<std::vector<uint8_t> > buff;
+   rim::TransactionPtr sub;
+   uint64_t wait;
+
+   wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queued).count();
+
+   {
+      rim::TransactionLock lock(tran);
+
+      // Expired while queued, release the slot
+      if ( tran->expired() ) {
+         log_->debug("Dropping expired transaction id=%i at 0x%" PRIx64,tran->id_,tran->address_);
+         {
+            std::lock_guard<std::mutex> lock(arbMtx_);
+            --ports_[port].outstanding;
+            --outstanding_;
+         }
+         return;
+      }
+
+      buff = std::make_shared<std::vector<uint8_t> >(tran->size_,0);
+      if ( tran->type_ == rim::Write || tran->type_ == rim::Post )
+         std::memcpy(buff->data(),tran->begin(),tran->size_);
+
+      sub = allocTransaction();
+      sub->iter_     = buff->data();
+      sub->size_     = tran->size_;
+      sub->address_  = tran->address_;
+      sub->type_     = tran->type_;
+      sub->priority_ = tran->priority_;
+      sub->setDeadline(tran->deadline());
+   }
+
+   asyncTransaction(sub,[this,buff,tran,port,wait](uint32_t id, uint32_t error) {
+
+      {
+         rim::TransactionLock lock(tran);
+
+         if ( ! tran->expired() ) {
+            if ( error == 0 && (tran->type_ == rim::Read || tran->type_ == rim::Verify) )
+               std::memcpy(tran->begin(),buff->data(),tran->size_);
+            tran->done(error);
+         }
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(arbMtx_);
+         Port & p = ports_[port];
+
+         --p.outstanding;
+         --outstanding_;
+         ++p.count;
+         p.bytes += buff->size();
+         if ( error != 0 ) ++p.errors;
+         p.waitSum += wait;
+         p.waitMax  = std::max(p.waitMax,wait);
+      }
+
+      dispatch();
+   });
+}
+
+#ifndef NO_PYTHON
+
+//! Get port statistics
+boost::python::dict rim::ArbiterHub::getStats() {
+   std::vector<uint32_t> depth;
+   std::vector<Port> ports;
+   double elapsed;
+   bp::dict ret;
+   uint32_t x;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(arbMtx_);
+
+      // Copy the counters, not the queued transactions
+      for (x=0; x < ports_.size(); x++) {
+         Port p;
+         p.weight      = ports_[x].weight;
+         p.limit       = ports_[x].limit;
+         p.outstanding = ports_[x].outstanding;
+         p.count       = ports_[x].count;
+         p.bytes       = ports_[x].bytes;
+         p.errors      = ports_[x].errors;
+         p.waitSum     = ports_[x].waitSum;
+         p.waitMax     = ports_[x].waitMax;
+         p.maxDepth    = ports_[x].maxDepth;
+         ports.push_back(p);
+         depth.push_back(ports_[x].queue.size());
+      }
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsTime_).count();
+   }
+
+   for (x=0; x < ports.size(); x++) {
+      bp::dict d;
+      d["weight"]      = ports[x].weight;
+      d["limit"]       = ports[x].limit;
+      d["queued"]      = depth[x];
+      d["outstanding"] = ports[x].outstanding;
+      d["count"]       = ports[x].count;
+      d["bytes"]       = ports[x].bytes;
+      d["errors"]      = ports[x].errors;
+      d["maxDepth"]    = ports[x].maxDepth;
+      d["rate"]        = (elapsed > 0.0) ? ((double)ports[x].count / elapsed) : 0.0;
+      d["bandwidth"]   = (elapsed > 0.0) ? ((double)ports[x].bytes / elapsed) : 0.0;
+      d["waitAvg"]     = (ports[x].count == 0) ? 0.0 : ((double)ports[x].waitSum / (double)ports[x].count) / 1e6;
+      d["waitMax"]     = (double)ports[x].waitMax / 1e6;
+      ret[x] = d;
+   }
+   return(ret);
+}
+
+#endif
+
+//! Create a port, class creator
+rim::ArbiterPortPtr rim::ArbiterPort::create (rim::ArbiterHubPtr hub, uint32_t weight, uint32_t limit) {
+   rim::ArbiterPortPtr p = std::make_shared<rim::ArbiterPort>(hub,weight,limit);
+   return(p);
+}
+
+//! Create a port
+rim::ArbiterPort::ArbiterPort(rim::ArbiterHubPtr hub, uint32_t weight, uint32_t limit) : Slave(0,0) {
+   hub_  = hub;
+   port_ = hub_->addPort(weight,limit);
+}
+
+//! Destroy a port
+rim::ArbiterPort::~ArbiterPort() { }
+
+void rim::ArbiterPort::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::ArbiterPort, rim::ArbiterPortPtr, bp::bases<rim::Slave>, boost::noncopyable>("ArbiterPort",bp::init<rim::ArbiterHubPtr,uint32_t,uint32_t>())
+       .def("getPort", &rim::ArbiterPort::getPort)
+   ;
+
+   bp::implicitly_convertible<rim::ArbiterPortPtr, rim::SlavePtr>();
+#endif
+}
+
+//! Get the port index
+uint32_t rim::ArbiterPort::getPort() {
+   return(port_);
+}
+
+//! Return id of the ArbiterHub
+uint32_t rim::ArbiterPort::doSlaveId() {
+   return(hub_->doSlaveId());
+}
+
+//! Return min access size of the ArbiterHub
+uint32_t rim::ArbiterPort::doMinAccess() {
+   return(hub_->doMinAccess());
+}
+
+//! Return max access size of the ArbiterHub
+uint32_t rim::ArbiterPort::doMaxAccess() {
+   return(hub_->doMaxAccess());
+}
+
+//! Return address of the ArbiterHub
+uint64_t rim::ArbiterPort::doAddress() {
+   return(hub_->doAddress());
+}
+
+//! Queue the transaction on this port
+void rim::ArbiterPort::doTransaction(rim::TransactionPtr transaction) {
+   hub_->queueTransaction(transaction,port_);
+}
+
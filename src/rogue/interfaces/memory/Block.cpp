@@ -0,0 +1,513 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Block
+ * ----------------------------------------------------------------------------
+ * File       : Block.cpp
+ * Created    : 2019-01-15
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface master which holds the data for a block of variables.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/Block.h>
+#include <rogue/GeneralError.h>
+#include <cstring>
+#include <memory>
+#include <inttypes.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a Block object
+rim::BlockPtr rim::Block::create (uint64_t offset, uint32_t size) {
+   rim::BlockPtr b = std::make_shared<rim::Block>(offset,size);
+   return(b);
+}
+
+//! Setup class for use in python
+void rim::Block::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::Block, rim::BlockPtr, bp::bases<rim::Master>, boost::noncopyable> cls("Block",bp::init<uint64_t,uint32_t>());
+
+   cls.def("_getOffset",      &rim::Block::getOffset)
+      .def("_getSize",        &rim::Block::getSize)
+      .def("_addVariable",    &rim::Block::addVariablePy)
+      .def("_checkOverlap",   &rim::Block::checkOverlap)
+      .def("_getOverlapEn",   &rim::Block::getOverlapEn)
+      .def("_getVerifyEn",    &rim::Block::getVerifyEn)
+      .def("_setValue",       &rim::Block::setValuePy)
+      .def("_getValue",       &rim::Block::getValuePy)
+      .def("_applyStaged",    &rim::Block::applyStaged)
+      .def("_stale",          &rim::Block::stale)
+      .def("_verifyMismatch", &rim::Block::verifyMismatch)
+      .def("_shadowUpdate",   &rim::Block::shadowUpdate)
+      .def("_shadowClear",    &rim::Block::shadowClear)
+      .def("_shadowMatch",    &rim::Block::shadowMatch)
+      .def("_blockData",      &rim::Block::blockDataPy)
+      .def("_verifyData",     &rim::Block::verifyDataPy)
+      .def("_verifyMask",     &rim::Block::verifyMaskPy)
+      .def("_pollApply",      &rim::Block::pollApply)
+   ;
+
+   // Field type constants
+   cls.attr("Bytes") = rim::Block::Bytes;
+   cls.attr("UInt")  = rim::Block::UInt;
+   cls.attr("Int")   = rim::Block::Int;
+   cls.attr("Bool")  = rim::Block::Bool;
+   cls.attr("Float") = rim::Block::Float;
+
+   bp::implicitly_convertible<rim::BlockPtr, rim::MasterPtr>();
+#endif
+}
+
+//! Create a Block object
+rim::Block::Block(uint64_t offset, uint32_t size) : Master() {
+   offset_ = offset;
+   size_   = size;
+
+   bData_.resize(size,0);
+   sData_.resize(size,0);
+   sDataMask_.resize(size,0);
+   vData_.resize(size,0);
+   vDataMask_.resize(size,0);
+   hData_.resize(size,0);
+   hValid_ = false;
+   excMask_.resize(size,0);
+   oleMask_.resize(size,0);
+   pData_.resize(size,0);
+   pLast_.resize(size,0);
+   pValid_ = false;
+   wrSeq_  = 0;
+   pSeq_   = 0;
+}
+
+//! Destroy the Block object
+rim::Block::~Block() { }
+
+//! Get the block offset
+uint64_t rim::Block::getOffset() {
+   return(offset_);
+}
+
+//! Get the block size
+uint32_t rim::Block::getSize() {
+   return(size_);
+}
+
+//! Check a field index
+rim::Block::Field & rim::Block::field(uint32_t idx) {
+   if ( idx >= fields_.size() )
+      throw(rogue::GeneralError::boundary("Block::field",idx,fields_.size()));
+   return(fields_[idx]);
+}
+
+//! Add a variable field to the block
+uint32_t rim::Block::addVariable(std::vector<uint32_t> offset, std::vector<uint32_t> size,
+                                 bool overlapEn, bool verify, uint32_t type) {
+   Field f;
+   uint32_t x;
+
+   if ( offset.size() != size.size() )
+      throw(rogue::GeneralError::create("Block::addVariable",
+               "Bit offset count %i does not match bit size count %i",(int)offset.size(),(int)size.size()));
+
+   if ( type > rim::Block::Float )
+      throw(rogue::GeneralError::create("Block::addVariable","Invalid field type %i",type));
+
+   f.bits = 0;
+   for (x=0; x < offset.size(); x++) {
+      if ( (offset[x] + size[x]) > (size_*8) )
+         throw(rogue::GeneralError::boundary("Block::addVariable",(offset[x] + size[x]),(size_*8)));
+      f.bits += size[x];
+   }
+
+   if ( (type == rim::Block::UInt || type == rim::Block::Int) && (f.bits == 0 || f.bits > 64) )
+      throw(rogue::GeneralError::create("Block::addVariable","Invalid integer bit size %i",f.bits));
+
+   if ( type == rim::Block::Bool && f.bits != 1 )
+      throw(rogue::GeneralError::create("Block::addVariable","Invalid bool bit size %i",f.bits));
+
+   if ( type == rim::Block::Float && f.bits != 32 && f.bits != 64 )
+      throw(rogue::GeneralError::create("Block::addVariable","Invalid float bit size %i",f.bits));
+
+   // Update variable masks
+   for (x=0; x < offset.size(); x++) {
+      if ( overlapEn ) rim::Master::setBits(oleMask_.data(),offset[x],size[x]);
+      else rim::Master::setBits(excMask_.data(),offset[x],size[x]);
+
+      if ( verify ) rim::Master::setBits(vDataMask_.data(),offset[x],size[x]);
+   }
+
+   f.offset = offset;
+   f.size   = size;
+   f.type   = type;
+
+   fields_.push_back(f);
+   return(fields_.size()-1);
+}
+
+//! Check for overlap between exclusive and overlap enabled variables
+bool rim::Block::checkOverlap() {
+   for (uint32_t x=0; x < size_; x++)
+      if ( (oleMask_[x] & excMask_[x]) != 0 ) return(true);
+   return(false);
+}
+
+//! Get the overlap enable state of the block
+bool rim::Block::getOverlapEn() {
+   return(size_ == 0 || !rim::Master::anyBits(excMask_.data(),0,size_*8));
+}
+
+//! Get the verify enable state of the block
+bool rim::Block::getVerifyEn() {
+   return(size_ != 0 && rim::Master::anyBits(vDataMask_.data(),0,size_*8));
+}
+
+//! Stage a field value from a packed little endian bit array
+void rim::Block::setBytes(uint32_t idx, const uint8_t *data) {
+   Field & f = field(idx);
+   uint32_t srcBit = 0;
+
+   for (uint32_t x=0; x < f.offset.size(); x++) {
+      rim::Master::copyBits(sData_.data(),f.offset[x],data,srcBit,f.size[x]);
+      rim::Master::setBits(sDataMask_.data(),f.offset[x],f.size[x]);
+      srcBit += f.size[x];
+   }
+}
+
+//! Get a field value as a packed little endian bit array
+void rim::Block::getBytes(uint32_t idx, uint8_t *data) {
+   Field & f = field(idx);
+   uint32_t dstBit = 0;
+
+   // Unused upper bits in the last byte read as zero
+   memset(data,0,(f.bits+7)/8);
+
+   for (uint32_t x=0; x < f.offset.size(); x++) {
+      if ( rim::Master::anyBits(sDataMask_.data(),f.offset[x],f.size[x]) )
+         rim::Master::copyBits(data,dstBit,sData_.data(),f.offset[x],f.size[x]);
+      else
+         rim::Master::copyBits(data,dstBit,bData_.data(),f.offset[x],f.size[x]);
+      dstBit += f.size[x];
+   }
+}
+
+//! Stage an unsigned integer field value
+void rim::Block::setUInt(uint32_t idx, uint64_t value) {
+   uint32_t bits = field(idx).bits;
+   uint8_t  data[8];
+
+   if ( bits > 64 )
+      throw(rogue::GeneralError::boundary("Block::setUInt",bits,64));
+
+   if ( bits < 64 && (value >> bits) != 0 )
+      throw(rogue::GeneralError::create("Block::setUInt","Value 0x%" PRIx64 " does not fit in %i bits",value,bits));
+
+   // Little endian host
+   memcpy(data,&value,8);
+   setBytes(idx,data);
+}
+
+//! Get an unsigned integer field value
+uint64_t rim::Block::getUInt(uint32_t idx) {
+   uint8_t  data[8];
+   uint64_t value;
+
+   if ( field(idx).bits > 64 )
+      throw(rogue::GeneralError::boundary("Block::getUInt",field(idx).bits,64));
+
+   getBytes(idx,data);
+   memset(data+(field(idx).bits+7)/8,0,8-(field(idx).bits+7)/8);
+   memcpy(&value,data,8);
+   return(value);
+}
+
+//! Stage a signed integer field value
+void rim::Block::setInt(uint32_t idx, int64_t value) {
+   uint32_t bits = field(idx).bits;
+
+   if ( bits > 64 )
+      throw(rogue::GeneralError::boundary("Block::setInt",bits,64));
+
+   if ( bits < 64 && (value < -(1LL << (bits-1)) || value >= (1LL << (bits-1))) )
+      throw(rogue::GeneralError::create("Block::setInt","Value %" PRIi64 " does not fit in %i bits",value,bits));
+
+   // Upper bits of a negative value are dropped
+   if ( bits < 64 ) setUInt(idx,(uint64_t)value & ((1ULL << bits) - 1));
+   else setUInt(idx,(uint64_t)value);
+}
+
+//! Get a signed integer field value, sign extended from the field size
+int64_t rim::Block::getInt(uint32_t idx) {
+   uint32_t bits  = field(idx).bits;
+   uint64_t value = getUInt(idx);
+
+   if ( bits < 64 && ((value >> (bits-1)) & 0x1) ) value |= (0xFFFFFFFFFFFFFFFFULL << bits);
+   return((int64_t)value);
+}
+
+//! Stage a floating point field value
+void rim::Block::setFloat(uint32_t idx, double value) {
+   uint8_t data[8];
+   float   fv;
+
+   if ( field(idx).bits == 32 ) {
+      fv = (float)value;
+      memcpy(data,&fv,4);
+   }
+   else if ( field(idx).bits == 64 ) memcpy(data,&value,8);
+   else throw(rogue::GeneralError::create("Block::setFloat","Invalid float bit size %i",field(idx).bits));
+
+   setBytes(idx,data);
+}
+
+//! Get a floating point field value
+double rim::Block::getFloat(uint32_t idx) {
+   uint8_t data[8];
+   double  value;
+   float   fv;
+
+   if ( field(idx).bits == 32 ) {
+      getBytes(idx,data);
+      memcpy(&fv,data,4);
+      value = fv;
+   }
+   else if ( field(idx).bits == 64 ) {
+      getBytes(idx,data);
+      memcpy(&value,data,8);
+   }
+   else throw(rogue::GeneralError::create("Block::getFloat","Invalid float bit size %i",field(idx).bits));
+
+   return(value);
+}
+
+//! Merge staged data into the block data
+void rim::Block::applyStaged(bool clear) {
+   uint32_t x;
+   uint64_t b;
+   uint64_t s;
+   uint64_t m;
+
+   // Poll reads issued before this point are stale
+   ++wrSeq_;
+
+   // Word at a time, then the remaining bytes
+   for (x=0; (x+8) <= size_; x += 8) {
+      memcpy(&m,&(sDataMask_[x]),8);
+      if ( m == 0 ) continue;
+      memcpy(&b,&(bData_[x]),8);
+      memcpy(&s,&(sData_[x]),8);
+      b = (b & ~m) | (s & m);
+      memcpy(&(bData_[x]),&b,8);
+   }
+
+   for (; x < size_; x++)
+      bData_[x] = (bData_[x] & ~sDataMask_[x]) | (sData_[x] & sDataMask_[x]);
+
+   if ( clear ) {
+      memset(sData_.data(),0,size_);
+      memset(sDataMask_.data(),0,size_);
+   }
+}
+
+//! Check for staged data
+bool rim::Block::stale() {
+   return(size_ != 0 && rim::Master::anyBits(sDataMask_.data(),0,size_*8));
+}
+
+//! Compare the verify data to the block data under the verify mask
+bool rim::Block::verifyMismatch() {
+   uint32_t x;
+   uint64_t b;
+   uint64_t v;
+   uint64_t m;
+
+   for (x=0; (x+8) <= size_; x += 8) {
+      memcpy(&m,&(vDataMask_[x]),8);
+      memcpy(&b,&(bData_[x]),8);
+      memcpy(&v,&(vData_[x]),8);
+      if ( ((b ^ v) & m) != 0 ) return(true);
+   }
+
+   for (; x < size_; x++)
+      if ( ((bData_[x] ^ vData_[x]) & vDataMask_[x]) != 0 ) return(true);
+
+   return(false);
+}
+
+//! Copy the block data into the hardware shadow
+void rim::Block::shadowUpdate() {
+   memcpy(hData_.data(),bData_.data(),size_);
+   hValid_ = true;
+}
+
+//! Invalidate the hardware shadow
+void rim::Block::shadowClear() {
+   hValid_ = false;
+}
+
+//! Compare the block data, with staged data applied, to the hardware shadow
+bool rim::Block::shadowMatch() {
+   uint32_t x;
+   uint8_t  b;
+
+   if ( ! hValid_ ) return(false);
+
+   for (x=0; x < size_; x++) {
+      b = (bData_[x] & ~sDataMask_[x]) | (sData_[x] & sDataMask_[x]);
+      if ( ((b ^ hData_[x]) & (excMask_[x] | oleMask_[x])) != 0 ) return(false);
+   }
+
+   return(true);
+}
+
+//! Get a pointer to the block data
+uint8_t * rim::Block::blockData() {
+   return(bData_.data());
+}
+
+//! Get a pointer to the verify data
+uint8_t * rim::Block::verifyData() {
+   return(vData_.data());
+}
+
+//! Get a pointer to the poll data
+uint8_t * rim::Block::pollData() {
+   return(pData_.data());
+}
+
+//! Start a poll read
+void rim::Block::pollStart() {
+   pSeq_.store(wrSeq_.load());
+}
+
+//! Compare the poll data to the previous poll
+bool rim::Block::pollCompare() {
+   bool changed = (! pValid_) || (memcmp(pData_.data(),pLast_.data(),size_) != 0);
+
+   if ( changed ) memcpy(pLast_.data(),pData_.data(),size_);
+   pValid_ = true;
+   return(changed);
+}
+
+//! Copy the poll data into the block data
+bool rim::Block::pollApply() {
+   uint32_t x;
+
+   // A write was started after the poll read was issued
+   if ( pSeq_ != wrSeq_ ) return(false);
+
+   memcpy(bData_.data(),pData_.data(),size_);
+
+   // Hardware differs from the shadow, the next write can not be skipped
+   for (x=0; x < size_ && hValid_; x++)
+      if ( ((pData_[x] ^ hData_[x]) & (excMask_[x] | oleMask_[x])) != 0 ) hValid_ = false;
+
+   return(true);
+}
+
+#ifndef NO_PYTHON
+
+//! Stage a field value, python version
+void rim::Block::setValuePy(uint32_t idx, boost::python::object value) {
+   Py_buffer valueBuf;
+   uint32_t  type = field(idx).type;
+   uint32_t  bytes;
+
+   switch (type) {
+      case rim::Block::UInt :
+         setUInt(idx,bp::extract<uint64_t>(value));
+         break;
+
+      case rim::Block::Int :
+         setInt(idx,bp::extract<int64_t>(value));
+         break;
+
+      case rim::Block::Bool :
+         setUInt(idx,bp::extract<bool>(value) ? 1 : 0);
+         break;
+
+      case rim::Block::Float :
+         setFloat(idx,bp::extract<double>(value));
+         break;
+
+      default :
+         if ( PyObject_GetBuffer(value.ptr(),&valueBuf,PyBUF_SIMPLE) < 0 )
+            throw(rogue::GeneralError("Block::setValuePy","Python Buffer Error"));
+
+         bytes = (field(idx).bits+7)/8;
+
+         if ( (uint32_t)valueBuf.len < bytes ) {
+            PyBuffer_Release(&valueBuf);
+            throw(rogue::GeneralError::boundary("Block::setValuePy",bytes,valueBuf.len));
+         }
+
+         setBytes(idx,(uint8_t *)valueBuf.buf);
+         PyBuffer_Release(&valueBuf);
+         break;
+   }
+}
+
+//! Get a field value, python version
+boost::python::object rim::Block::getValuePy(uint32_t idx) {
+   PyObject * ba;
+   uint32_t   type = field(idx).type;
+
+   switch (type) {
+      case rim::Block::UInt  : return(bp::object(getUInt(idx)));
+      case rim::Block::Int   : return(bp::object(getInt(idx)));
+      case rim::Block::Bool  : return(bp::object(getUInt(idx) != 0));
+      case rim::Block::Float : return(bp::object(getFloat(idx)));
+
+      default :
+         if ( (ba = PyByteArray_FromStringAndSize(NULL,(field(idx).bits+7)/8)) == NULL )
+            throw(rogue::GeneralError("Block::getValuePy","Python Buffer Error"));
+
+         bp::object ret = bp::object(bp::handle<>(ba));
+         getBytes(idx,(uint8_t *)PyByteArray_AsString(ba));
+         return(ret);
+   }
+}
+
+//! Add a variable field to the block, python version
+uint32_t rim::Block::addVariablePy(boost::python::object offset, boost::python::object size,
+                                   bool overlapEn, bool verify, uint32_t type) {
+   std::vector<uint32_t> offVec;
+   std::vector<uint32_t> sizeVec;
+   uint32_t x;
+
+   for (x=0; x < bp::len(offset); x++) offVec.push_back(bp::extract<uint32_t>(offset[x]));
+   for (x=0; x < bp::len(size); x++) sizeVec.push_back(bp::extract<uint32_t>(size[x]));
+
+   return(addVariable(offVec,sizeVec,overlapEn,verify,type));
+}
+
+//! Get a writable memoryview of the block data
+boost::python::object rim::Block::blockDataPy() {
+   return(bp::object(bp::handle<>(PyMemoryView_FromMemory((char *)bData_.data(),size_,PyBUF_WRITE))));
+}
+
+//! Get a writable memoryview of the verify data
+boost::python::object rim::Block::verifyDataPy() {
+   return(bp::object(bp::handle<>(PyMemoryView_FromMemory((char *)vData_.data(),size_,PyBUF_WRITE))));
+}
+
+//! Get a memoryview of the verify mask
+boost::python::object rim::Block::verifyMaskPy() {
+   return(bp::object(bp::handle<>(PyMemoryView_FromMemory((char *)vDataMask_.data(),size_,PyBUF_READ))));
+}
+
+#endif
+
@@ -0,0 +1,283 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Cache Hub
+ * ----------------------------------------------------------------------------
+ * File       : CacheHub.cpp
+ * Created    : 2018-03-14
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which serves reads of registered address ranges 
+ * from a local shadow copy.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/CacheHub.h>
+#include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GeneralError.h>
+#include <rogue/GilRelease.h>
+#include <memory>
+#include <cstring>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a hub, class creator
+rim::CacheHubPtr rim::CacheHub::create (uint64_t offset, uint32_t staleness) {
+   rim::CacheHubPtr b = std::make_shared<rim::CacheHub>(offset,staleness);
+   return(b);
+}
+
+//! Create a hub
+rim::CacheHub::CacheHub(uint64_t offset, uint32_t staleness) : Hub(offset,0,0) { 
+   cache_ = std::make_shared<Cache>();
+   cache_->staleness = std::chrono::microseconds(staleness);
+   cache_->hits      = 0;
+   cache_->misses    = 0;
+
+   log_ = rogue::Logging::create("memory.CacheHub");
+}
+
+//! Destroy a hub
+rim::CacheHub::~CacheHub() { }
+
+void rim::CacheHub::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::CacheHub, rim::CacheHubPtr, bp::bases<rim::Hub>, boost::noncopyable>("CacheHub",bp::init<uint64_t,uint32_t>())
+       .def("addRange",        &rim::CacheHub::addRange)
+       .def("setStaleness",    &rim::CacheHub::setStaleness)
+       .def("invalidate",      &rim::CacheHub::invalidateAll)
+       .def("invalidateRange", &rim::CacheHub::invalidateRange)
+       .def("getHits",         &rim::CacheHub::getHits)
+       .def("getMisses",       &rim::CacheHub::getMisses)
+   ;
+
+   bp::implicitly_convertible<rim::CacheHubPtr, rim::HubPtr>();
+   bp::implicitly_convertible<rim::CacheHubPtr, rim::MasterPtr>();
+   bp::implicitly_convertible<rim::CacheHubPtr, rim::SlavePtr>();
+#endif
+}
+
+//! Register an address range for caching
+void rim::CacheHub::addRange(uint64_t address, uint32_t size) {
+   std::map<uint64_t, Range>::iterator it;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cache_->mtx);
+
+   if ( size == 0 ) throw(rogue::GeneralError("CacheHub::addRange","Invalid range size"));
+
+   // Ranges may not overlap
+   it = cache_->ranges.upper_bound(address + size - 1);
+   if ( it != cache_->ranges.begin() ) {
+      --it;
+      if ( it->first + it->second.size > address )
+         throw(rogue::GeneralError::boundary("CacheHub::addRange",address,it->first + it->second.size));
+   }
+
+   Range & r = cache_->ranges[address];
+   r.size = size;
+   r.gen  = 0;
+   r.data.assign(size,0);
+   r.stamp.assign(size,std::chrono::steady_clock::time_point());
+}
+
+//! Set the staleness bound
+void rim::CacheHub::setStaleness(uint32_t staleness) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cache_->mtx);
+   cache_->staleness = std::chrono::microseconds(staleness);
+}
+
+//! Invalidate the full shadow copy
+void rim::CacheHub::invalidateAll() {
+   std::map<uint64_t, Range>::iterator it;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cache_->mtx);
+
+   for (it = cache_->ranges.begin(); it != cache_->ranges.end(); ++it) {
+      it->second.gen++;
+      it->second.stamp.assign(it->second.size,std::chrono::steady_clock::time_point());
+   }
+}
+
+//! Invalidate part of the shadow copy
+void rim::CacheHub::invalidateRange(uint64_t address, uint32_t size) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cache_->mtx);
+   invalidate(cache_,address,size);
+}
+
+//! Get hit count
+uint64_t rim::CacheHub::getHits() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cache_->mtx);
+   return cache_->hits;
+}
+
+//! Get miss count
+uint64_t rim::CacheHub::getMisses() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(cache_->mtx);
+   return cache_->misses;
+}
+
+//! Find the range containing an address span, cache lock must be held
+rim::CacheHub::Range * rim::CacheHub::findRange(std::shared_ptr<Cache> cache, uint64_t address, uint32_t size, uint64_t & start) {
+   std::map<uint64_t, Range>::iterator it;
+
+   if ( cache->ranges.empty() ) return NULL;
+
+   it = cache->ranges.upper_bound(address);
+   if ( it == cache->ranges.begin() ) return NULL;
+   --it;
+
+   if ( (address + size) > (it->first + it->second.size) ) return NULL;
+
+   start = it->first;
+   return &(it->second);
+}
+
+//! Invalidate overlapping bytes, cache lock must be held
+void rim::CacheHub::invalidate(std::shared_ptr<Cache> cache, uint64_t address, uint32_t size) {
+   std::map<uint64_t, Range>::iterator it;
+   uint64_t lo;
+   uint64_t hi;
+   uint64_t x;
+
+   if ( cache->ranges.empty() ) return;
+
+   // Start from the last range at or before the address
+   it = cache->ranges.upper_bound(address);
+   if ( it != cache->ranges.begin() ) --it;
+
+   for (; it != cache->ranges.end() && it->first < (address + size); ++it) {
+      lo = std::max(address, it->first);
+      hi = std::min(address + size, it->first + it->second.size);
+      if ( lo >= hi ) continue;
+
+      it->second.gen++;
+      for (x = lo; x < hi; x++) it->second.stamp[x - it->first] = std::chrono::steady_clock::time_point();
+   }
+}
+
+//! Post a transaction. Master will call this method with the access attributes.
+void rim::CacheHub::doTransaction(rim::TransactionPtr tran) {
+   std::chrono::steady_clock::time_point now;
+   std::shared_ptr<Cache> cache = cache_;
+   rim::TransactionPtr sub;
+   Range * range;
+   uint64_t start;
+   uint64_t address;
+   uint32_t size;
+   uint32_t gen;
+   uint32_t x;
+   bool hit;
+
+   gen = 0;
+   rogue::GilRelease noGil;
+
+   address = tran->address();
+   size    = tran->size();
+
+   if ( tran->type() == rim::Write || tran->type() == rim::Post ) {
+      {
+         std::lock_guard<std::mutex> lock(cache->mtx);
+         invalidate(cache,address,size);
+      }
+      rim::Hub::doTransaction(tran);
+      return;
+   }
+
+   if ( tran->type() != rim::Read ) {
+      rim::Hub::doTransaction(tran);
+      return;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(cache->mtx);
+
+      if ( cache->staleness.count() == 0 ) range = NULL;
+      else range = findRange(cache,address,size,start);
+
+      if ( range != NULL ) {
+         now = std::chrono::steady_clock::now();
+         hit = true;
+
+         for (x = 0; x < size && hit; x++) 
+            if ( (now - range->stamp[address - start + x]) > cache->staleness ) hit = false;
+
+         if ( hit ) {
+            rim::TransactionLock tLock(tran);
+
+            if ( ! tran->expired() ) {
+               std::memcpy(tran->begin(), range->data.data() + (address - start), size);
+               tran->done(0);
+            }
+            cache->hits++;
+            return;
+         }
+         cache->misses++;
+         gen = range->gen;
+      }
+   }
+
+   // Outside of a cached range
+   if ( range == NULL ) {
+      rim::Hub::doTransaction(tran);
+      return;
+   }
+
+   // Refill the shadow copy from a downstream read, within the deadline of the original
+   std::shared_ptr<std::vector<uint8_t> > buff = std::make_shared<std::vector<uint8_t> >(size,0);
+
+   {
+      rim::TransactionLock tLock(tran);
+
+      sub = allocTransaction();
+      sub->iter_     = buff->data();
+      sub->size_     = size;
+      sub->address_  = address | getOffset();
+      sub->type_     = rim::Read;
+      sub->priority_ = tran->priority_;
+      sub->setDeadline(tran->deadline());
+   }
+
+   asyncTransaction(sub,
+      [cache,buff,tran,address,start,size,gen](uint32_t id, uint32_t error) {
+         std::map<uint64_t, Range>::iterator it;
+         std::chrono::steady_clock::time_point now;
+         uint32_t x;
+
+         if ( error == 0 ) {
+            std::lock_guard<std::mutex> lock(cache->mtx);
+
+            // Skip update if the range was invalidated while the read was in flight
+            if ( (it = cache->ranges.find(start)) != cache->ranges.end() && it->second.gen == gen ) {
+               now = std::chrono::steady_clock::now();
+               std::memcpy(it->second.data.data() + (address - start), buff->data(), size);
+               for (x = 0; x < size; x++) it->second.stamp[address - start + x] = now;
+            }
+         }
+
+         rim::TransactionLock tLock(tran);
+         if ( tran->expired() ) return;
+
+         if ( error == 0 ) std::memcpy(tran->begin(), buff->data(), size);
+         tran->done(error);
+      });
+}
+
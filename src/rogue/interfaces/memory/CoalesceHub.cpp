@@ -0,0 +1,281 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Coalescing Hub
+ * ----------------------------------------------------------------------------
+ * File       : CoalesceHub.cpp
+ * Created    : 2018-03-12
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which merges adjacent transactions of the same type
+ * into larger downstream transactions.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/CoalesceHub.h>
+#include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GilRelease.h>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#include <inttypes.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a hub, class creator
+rim::CoalesceHubPtr rim::CoalesceHub::create (uint64_t offset, uint32_t window, uint32_t gap) {
+   rim::CoalesceHubPtr b = std::make_shared<rim::CoalesceHub>(offset,window,gap);
+   return(b);
+}
+
+//! Create a hub
+rim::CoalesceHub::CoalesceHub(uint64_t offset, uint32_t window, uint32_t gap) : Hub(offset,0,0) { 
+   window_    = window;
+   gap_       = gap;
+   pendBytes_ = 0;
+
+   log_ = rogue::Logging::create("memory.CoalesceHub");
+
+   threadEn_ = true;
+   thread_   = new std::thread(&rim::CoalesceHub::runThread, this);
+}
+
+//! Destroy a hub
+rim::CoalesceHub::~CoalesceHub() { 
+   rogue::GilRelease noGil;
+
+   {
+      std::lock_guard<std::mutex> lock(coalMtx_);
+      threadEn_ = false;
+      coalCond_.notify_all();
+   }
+   thread_->join();
+   delete thread_;
+}
+
+void rim::CoalesceHub::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::CoalesceHub, rim::CoalesceHubPtr, bp::bases<rim::Hub>, boost::noncopyable>("CoalesceHub",bp::init<uint64_t,uint32_t,uint32_t>())
+       .def("setWindow", &rim::CoalesceHub::setWindow)
+       .def("setGap",    &rim::CoalesceHub::setGap)
+       .def("flush",     &rim::CoalesceHub::flush)
+   ;
+
+   bp::implicitly_convertible<rim::CoalesceHubPtr, rim::HubPtr>();
+   bp::implicitly_convertible<rim::CoalesceHubPtr, rim::MasterPtr>();
+   bp::implicitly_convertible<rim::CoalesceHubPtr, rim::SlavePtr>();
+#endif
+}
+
+//! Set the collection window
+void rim::CoalesceHub::setWindow(uint32_t window) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(coalMtx_);
+   window_ = window;
+   coalCond_.notify_all();
+}
+
+//! Set the max gap between merged reads
+void rim::CoalesceHub::setGap(uint32_t gap) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(coalMtx_);
+   gap_ = gap;
+}
+
+//! Merge and forward all pending transactions
+void rim::CoalesceHub::flush() {
+   std::vector<rim::TransactionPtr> trans;
+
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(coalMtx_);
+      trans.swap(pend_);
+      pendBytes_ = 0;
+   }
+   if ( ! trans.empty() ) issue(trans);
+}
+
+//! Post a transaction. Master will call this method with the access attributes.
+void rim::CoalesceHub::doTransaction(rim::TransactionPtr tran) {
+   std::vector<rim::TransactionPtr> trans;
+   uint32_t max;
+
+   // Adjust address
+   tran->address_ |= getOffset();
+
+   rogue::GilRelease noGil;
+   max = reqMaxAccess();
+
+   {
+      std::lock_guard<std::mutex> lock(coalMtx_);
+
+      if ( pend_.empty() ) 
+         flushTime_ = std::chrono::steady_clock::now() + std::chrono::microseconds(window_);
+
+      pend_.push_back(tran);
+      pendBytes_ += tran->size_;
+
+      // Enough data to fill a full size transaction, flush now
+      if ( pendBytes_ >= max ) {
+         trans.swap(pend_);
+         pendBytes_ = 0;
+      }
+      else if ( pend_.size() == 1 ) coalCond_.notify_all();
+   }
+
+   if ( ! trans.empty() ) issue(trans);
+}
+
+//! Flush thread
+void rim::CoalesceHub::runThread() {
+   std::vector<rim::TransactionPtr> trans;
+
+   log_->logThreadId();
+
+   std::unique_lock<std::mutex> lock(coalMtx_);
+
+   while ( threadEn_ ) {
+      if ( pend_.empty() || window_ == 0 ) coalCond_.wait(lock);
+      else if ( std::chrono::steady_clock::now() < flushTime_ ) coalCond_.wait_until(lock,flushTime_);
+      else {
+         trans.swap(pend_);
+         pendBytes_ = 0;
+
+         lock.unlock();
+         issue(trans);
+         trans.clear();
+         lock.lock();
+      }
+   }
+}
+
+//! Merge and forward a list of transactions
+void rim::CoalesceHub::issue(std::vector<rim::TransactionPtr> & trans) {
+   std::vector<rim::TransactionPtr>::iterator first;
+   std::vector<rim::TransactionPtr>::iterator next;
+   std::vector<rim::TransactionPtr>::iterator it;
+   uint64_t start;
+   uint64_t stop;
+   uint64_t nStop;
+   uint64_t span;
+   uint32_t type;
+   uint32_t min;
+   uint32_t max;
+   uint32_t gap;
+   bool     wr;
+
+   min = reqMinAccess();
+   max = reqMaxAccess();
+   if ( min == 0 ) min = 1;
+
+   {
+      std::lock_guard<std::mutex> lock(coalMtx_);
+      gap = gap_;
+   }
+
+   // Submission order is kept, a transaction is only merged into the group before it
+   for (first = trans.begin(); first != trans.end(); first = next) {
+      type  = (*first)->type_;
+      wr    = (type == rim::Write || type == rim::Post);
+      start = (*first)->address_;
+      stop  = start + (*first)->size_;
+
+      for (next = first + 1; next != trans.end(); ++next) {
+         if ( (*next)->type_ != type ) break;
+
+         // Writes must start where the group ends, reads may skip a small gap
+         if ( (*next)->address_ < stop ) break;
+         if ( (*next)->address_ > (stop + (wr ? 0 : gap)) ) break;
+
+         nStop = (*next)->address_ + (*next)->size_;
+         span  = wr ? (nStop - start) : (((nStop - start + min - 1) / min) * min);
+         if ( span > max ) break;
+
+         stop = nStop;
+      }
+
+      // Single transaction is forwarded unchanged
+      if ( (next - first) == 1 ) getSlave()->doTransaction(*first);
+
+      // Writes are never padded, an unaligned group is forwarded unmerged
+      else if ( wr && ((stop - start) % min) != 0 ) {
+         log_->debug("Unaligned write group at 0x%" PRIx64 ", forwarding unmerged",start);
+         for (it = first; it != next; ++it) getSlave()->doTransaction(*it);
+      }
+
+      else send(first, next, start, wr ? (stop - start) : (((stop - start + min - 1) / min) * min), type);
+   }
+}
+
+//! Forward a merged transaction
+void rim::CoalesceHub::send(std::vector<rim::TransactionPtr>::iterator first,
+                            std::vector<rim::TransactionPtr>::iterator last,
+                            uint64_t address, uint32_t size, uint32_t type) {
+
+   std::vector<rim::TransactionPtr>::iterator it;
+   std::chrono::steady_clock::time_point deadline;
+   rim::TransactionPtr tran;
+   bool expired = false;
+
+   std::shared_ptr<std::vector<uint8_t> > buff = std::make_shared<std::vector<uint8_t> >(size,0);
+   std::shared_ptr<std::vector<rim::TransactionPtr> > subs = std::make_shared<std::vector<rim::TransactionPtr> >(first,last);
+
+   // Gather write data, an expired write would leave a hole so the group is forwarded unmerged
+   if ( type == rim::Write || type == rim::Post ) {
+      for (it = subs->begin(); it != subs->end() && (! expired); ++it) {
+         rim::TransactionLock lock(*it);
+
+         if ( (*it)->expired() ) expired = true;
+         else std::memcpy(buff->data() + ((*it)->address_ - address), (*it)->begin(), (*it)->size_);
+      }
+
+      if ( expired ) {
+         log_->debug("Expired write in group at 0x%" PRIx64 ", forwarding unmerged",address);
+         for (it = subs->begin(); it != subs->end(); ++it) getSlave()->doTransaction(*it);
+         return;
+      }
+   }
+
+   log_->debug("Merged %i transactions into type=%i address=0x%" PRIx64 " size=%i",(uint32_t)subs->size(),type,address,size);
+
+   // Merged transaction lives as long as the latest member
+   tran = allocTransaction();
+   tran->iter_    = buff->data();
+   tran->size_    = size;
+   tran->address_ = address;
+   tran->type_    = type;
+
+   deadline = subs->front()->deadline();
+   for (it = subs->begin(); it != subs->end(); ++it) deadline = std::max(deadline,(*it)->deadline());
+   tran->setDeadline(deadline);
+
+   asyncTransaction(tran, [buff,subs,address,type](uint32_t id, uint32_t error) {
+      std::vector<rim::TransactionPtr>::iterator sIt;
+
+      // Scatter data and result
+      for (sIt = subs->begin(); sIt != subs->end(); ++sIt) {
+         rim::TransactionLock lock(*sIt);
+
+         if ( (*sIt)->expired() ) continue;
+
+         if ( error == 0 && (type == rim::Read || type == rim::Verify) )
+            std::memcpy((*sIt)->begin(), buff->data() + ((*sIt)->address() - address), (*sIt)->size());
+
+         (*sIt)->done(error);
+      }
+   });
+}
+
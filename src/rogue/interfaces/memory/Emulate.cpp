@@ -0,0 +1,224 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Emulator
+ * ----------------------------------------------------------------------------
+ * File       : Emulate.cpp
+ * Created    : 2018-03-20
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface slave which emulates a sparse memory space.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/Emulate.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/GilRelease.h>
+#include <cstring>
+#include <algorithm>
+#include <inttypes.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create an Emulate object, point to slave
+rim::EmulatePtr rim::Emulate::create (uint32_t min, uint32_t max) {
+   rim::EmulatePtr b = std::make_shared<rim::Emulate>(min,max);
+   return(b);
+}
+
+//! Create an Emulate object
+rim::Emulate::Emulate(uint32_t min, uint32_t max) : Slave(min,max) { 
+   latency_   = std::chrono::microseconds(0);
+   errorRate_ = 0;
+   errorCode_ = 0;
+   rng_       = 0x9E3779B97F4A7C15ULL;
+   thread_    = NULL;
+   threadEn_  = false;
+
+   log_ = rogue::Logging::create("memory.Emulate");
+}
+
+//! Destroy the Emulate object
+rim::Emulate::~Emulate() { 
+   if ( thread_ != NULL ) {
+      {
+         std::lock_guard<std::mutex> lock(emuMtx_);
+         threadEn_ = false;
+         cond_.notify_all();
+      }
+      thread_->join();
+      delete thread_;
+   }
+}
+
+void rim::Emulate::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::Emulate, rim::EmulatePtr, bp::bases<rim::Slave>, boost::noncopyable>("Emulate",bp::init<uint32_t,uint32_t>())
+       .def("setLatency",   &rim::Emulate::setLatency)
+       .def("setErrorRate", &rim::Emulate::setErrorRate)
+       .def("getPageCount", &rim::Emulate::getPageCount)
+       .def("clear",        &rim::Emulate::clear)
+   ;
+
+   bp::implicitly_convertible<rim::EmulatePtr, rim::SlavePtr>();
+#endif
+}
+
+//! Set the transaction completion latency
+void rim::Emulate::setLatency(uint32_t latency) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(emuMtx_);
+   latency_ = std::chrono::microseconds(latency);
+}
+
+//! Set the transaction error rate
+void rim::Emulate::setErrorRate(double rate, uint32_t error) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(emuMtx_);
+
+   // Rate is held as a fraction of 2^32
+   rate = std::min(std::max(rate,0.0),1.0);
+   errorRate_ = (rate >= 1.0) ? 0xFFFFFFFF : (uint32_t)(rate * 4294967296.0);
+   errorCode_ = error;
+}
+
+//! Get the number of allocated pages
+uint32_t rim::Emulate::getPageCount() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(emuMtx_);
+   return(pages_.size());
+}
+
+//! Release all memory
+void rim::Emulate::clear() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(emuMtx_);
+   pages_.clear();
+}
+
+//! Copy between memory and a buffer, emuMtx_ must be held
+void rim::Emulate::access(uint64_t address, uint32_t size, uint8_t *data, bool write) {
+   std::unordered_map<uint64_t, std::unique_ptr<uint8_t[]> >::iterator it;
+   uint32_t offset;
+   uint32_t len;
+
+   while ( size > 0 ) {
+      offset = address % PageSize;
+      len    = std::min(size, PageSize - offset);
+      it     = pages_.find(address / PageSize);
+
+      if ( write ) {
+         if ( it == pages_.end() ) 
+            it = pages_.emplace(address / PageSize, std::unique_ptr<uint8_t[]>(new uint8_t[PageSize]())).first;
+         std::memcpy(it->second.get() + offset, data, len);
+      }
+
+      // Unwritten memory reads as zero
+      else if ( it == pages_.end() ) std::memset(data, 0, len);
+      else std::memcpy(data, it->second.get() + offset, len);
+
+      address += len;
+      data    += len;
+      size    -= len;
+   }
+}
+
+//! Service a transaction, transaction lock must be held
+void rim::Emulate::service(rim::TransactionPtr & tran, uint32_t error) {
+   if ( tran->expired() ) return;
+
+   if ( error == 0 ) {
+      std::lock_guard<std::mutex> lock(emuMtx_);
+      access(tran->address(), tran->size(), tran->begin(), 
+             (tran->type() == rim::Write || tran->type() == rim::Post));
+   }
+
+   log_->debug("Transaction id=%i, addr 0x%" PRIx64 ". Size=%i, type=%i, error=0x%x",
+               tran->id(),tran->address(),tran->size(),tran->type(),error);
+   tran->done(error);
+}
+
+//! Service a transaction from the memory Master
+void rim::Emulate::doTransaction(rim::TransactionPtr tran) {
+   std::chrono::microseconds latency;
+   uint32_t error;
+
+   if ( (tran->address() % min()) != 0 ) {
+      tran->done(rim::AddressError);
+      return;
+   }
+
+   if ( tran->size() > max() ) {
+      tran->done(rim::SizeError);
+      return;
+   }
+
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(emuMtx_);
+      latency = latency_;
+      error   = 0;
+
+      // Error injection, xorshift random value
+      if ( errorRate_ != 0 ) {
+         rng_ ^= rng_ << 13;
+         rng_ ^= rng_ >> 7;
+         rng_ ^= rng_ << 17;
+         if ( (uint32_t)(rng_ >> 32) < errorRate_ ) error = errorCode_;
+      }
+
+      // Completed by the worker thread
+      if ( latency.count() != 0 ) {
+         if ( thread_ == NULL ) {
+            threadEn_ = true;
+            thread_   = new std::thread(&rim::Emulate::runThread, this);
+         }
+         queue_.push_back({tran, std::chrono::steady_clock::now() + latency, error});
+         cond_.notify_all();
+         return;
+      }
+   }
+
+   rim::TransactionLock lock(tran);
+   service(tran,error);
+}
+
+//! Completion thread
+void rim::Emulate::runThread() {
+   Pending pend;
+
+   log_->logThreadId();
+
+   while (1) {
+      {
+         std::unique_lock<std::mutex> lock(emuMtx_);
+
+         while ( threadEn_ && (queue_.empty() || std::chrono::steady_clock::now() < queue_.front().due) ) {
+            if ( queue_.empty() ) cond_.wait(lock);
+            else cond_.wait_until(lock,queue_.front().due);
+         }
+
+         if ( ! threadEn_ ) break;
+
+         pend = std::move(queue_.front());
+         queue_.pop_front();
+      }
+
+      rim::TransactionLock lock(pend.tran);
+      service(pend.tran,pend.error);
+   }
+}
+
@@ -26,6 +26,7 @@
 #include <rogue/GilRelease.h>
 #include <rogue/ScopedGil.h>
 #include <memory>
+#include <typeinfo>
 
 namespace rim = rogue::interfaces::memory;
 
@@ -44,6 +45,13 @@ rim::HubPtr rim::Hub::create (uint64_t offset, uint32_t min, uint32_t max) {
 rim::Hub::Hub(uint64_t offset, uint32_t min, uint32_t max) : Master (), Slave(min,max) { 
    offset_ = offset;
    root_   = (min != 0 && max != 0);
+
+   flatOffset_ = 0;
+   flatEpoch_  = 0;
+   infoMin_    = 0;
+   infoMax_    = 0;
+   infoAddr_   = 0;
+   infoEpoch_  = 0;
 }
 
 //! Destroy a block
@@ -65,32 +73,100 @@ uint32_t rim::Hub::doSlaveId() {
    else return(reqSlaveId());
 }
 
+//! Refresh cached query results
+void rim::Hub::refreshInfo() {
+   uint64_t epoch = slaveEpoch_.load();
+   uint32_t min;
+   uint32_t max;
+   uint64_t addr;
+
+   {
+      std::lock_guard<std::mutex> lock(flatMtx_);
+      if ( infoEpoch_ == epoch ) return;
+   }
+
+   // Queries may call into python, no lock held
+   if ( root_ ) {
+      min  = rim::Slave::doMinAccess();
+      max  = rim::Slave::doMaxAccess();
+      addr = 0;
+   } else {
+      min  = reqMinAccess();
+      max  = reqMaxAccess();
+      addr = reqAddress() | offset_;
+   }
+
+   std::lock_guard<std::mutex> lock(flatMtx_);
+   infoMin_   = min;
+   infoMax_   = max;
+   infoAddr_  = addr;
+   infoEpoch_ = epoch;
+}
+
 //! Return min access size to requesting master
 uint32_t rim::Hub::doMinAccess() {
-   if ( root_ ) return(rim::Slave::doMinAccess());
-   else return(reqMinAccess());
+   refreshInfo();
+   return(infoMin_);
 }
 
 //! Return max access size to requesting master
 uint32_t rim::Hub::doMaxAccess() {
-   if ( root_ ) return(rim::Slave::doMaxAccess());
-   else return(reqMaxAccess());
+   refreshInfo();
+   return(infoMax_);
 }
 
 //! Return address
 uint64_t rim::Hub::doAddress() {
-   if ( root_ ) return(0);
-   else return(reqAddress() | offset_);
+   refreshInfo();
+   return(infoAddr_);
+}
+
+//! Return true if this Hub only applies its offset
+bool rim::Hub::passThrough() {
+   return(typeid(*this) == typeid(rim::Hub));
+}
+
+//! Resolve the downstream path
+void rim::Hub::flatten(rim::SlavePtr & slave, uint64_t & offset) {
+   rim::HubPtr hub;
+
+   offset = offset_;
+   slave  = getSlave();
+
+   while ( (hub = std::dynamic_pointer_cast<rim::Hub>(slave)) && hub->passThrough() ) {
+      offset |= hub->offset_;
+      slave   = hub->getSlave();
+   }
 }
 
 //! Post a transaction. Master will call this method with the access attributes.
 void rim::Hub::doTransaction(rim::TransactionPtr tran) {
+   uint64_t epoch = slaveEpoch_.load();
+   rim::SlavePtr slave;
+   uint64_t offset;
+
+   {
+      std::lock_guard<std::mutex> lock(flatMtx_);
+      if ( flatEpoch_ == epoch ) {
+         slave  = flatSlave_;
+         offset = flatOffset_;
+      }
+   }
+
+   if ( ! slave ) {
+      flatten(slave,offset);
+
+      std::lock_guard<std::mutex> lock(flatMtx_);
+      flatSlave_  = slave;
+      flatOffset_ = offset;
+      flatEpoch_  = epoch;
+   }
 
    // Adjust address
-   tran->address_ |= offset_;
+   tran->address_ |= offset;
 
    // Forward transaction
-   getSlave()->doTransaction(tran);
+   slave->doTransaction(tran);
 }
 
 void rim::Hub::setup_python() {
@@ -111,10 +187,36 @@ void rim::Hub::setup_python() {
 #ifndef NO_PYTHON
 
 //! Constructor
-rim::HubWrap::HubWrap(uint64_t offset, uint32_t min, uint32_t max) : rim::Hub(offset,min,max) {}
+rim::HubWrap::HubWrap(uint64_t offset, uint32_t min, uint32_t max) : rim::Hub(offset,min,max) {
+   override_ = 0;
+}
+
+//! Check for a python _doTransaction override, done once
+bool rim::HubWrap::overridden() {
+   int state = override_.load();
+
+   if ( state == 0 ) {
+      rogue::ScopedGil gil;
+      state = (this->get_override("_doTransaction")) ? 2 : 1;
+      override_ = state;
+   }
+   return(state == 2);
+}
+
+//! Return true if this Hub only applies its offset
+bool rim::HubWrap::passThrough() {
+   return(typeid(*this) == typeid(rim::HubWrap) && (! overridden()));
+}
 
 //! Post a transaction. Master will call this method with the access attributes.
 void rim::HubWrap::doTransaction(rim::TransactionPtr transaction) {
+
+   // No python override, skip the GIL
+   if ( ! overridden() ) {
+      rim::Hub::doTransaction(transaction);
+      return;
+   }
+
    {
       rogue::ScopedGil gil;
 
@@ -21,19 +21,31 @@
 #include <rogue/interfaces/memory/Slave.h>
 #include <rogue/interfaces/memory/Constants.h>
 #include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionStats.h>
 #include <rogue/GeneralError.h>
 #include <memory>
 #include <rogue/GilRelease.h>
 #include <rogue/ScopedGil.h>
+#include <algorithm>
+#include <cstring>
 #include <stdlib.h>
+#include <unordered_map>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace rim = rogue::interfaces::memory;
 
 #ifndef NO_PYTHON
 #include <boost/python.hpp>
+#include <boost/python/stl_iterator.hpp>
 namespace bp  = boost::python;
 #endif
 
+// Init tree change counter
+std::atomic<uint64_t> rim::Master::slaveEpoch_(1);
+
 //! Create a master container
 rim::MasterPtr rim::Master::create () {
    rim::MasterPtr m = std::make_shared<rim::Master>();
@@ -52,36 +64,91 @@ void rim::Master::setup_python() {
       .def("_getError",           &rim::Master::getError)
       .def("_setError",           &rim::Master::setError)
       .def("_setTimeout",         &rim::Master::setTimeout)
+      .def("_getTimeout",         &rim::Master::getTimeout)
+      .def("_setPriority",        &rim::Master::setPriority)
+      .def("_getPriority",        &rim::Master::getPriority)
       .def("_reqTransaction",     &rim::Master::reqTransactionPy)
+      .def("_reqTransactionAsync",&rim::Master::reqTransactionAsyncPy)
       .def("_waitTransaction",    &rim::Master::waitTransaction)
-      .def("_copyBits",           &rim::Master::copyBits)
+      .def("_reqTransactions",    &rim::Master::reqTransactionsPy)
+      .def("_waitTransactions",   &rim::Master::waitTransactionsPy)
+      .def("_copyBits",           (void (*)(bp::object, uint32_t, bp::object, uint32_t, uint32_t))(&rim::Master::copyBits))
       .staticmethod("_copyBits")
-      .def("_setBits",            &rim::Master::setBits)
+      .def("_setBits",            (void (*)(bp::object, uint32_t, uint32_t))(&rim::Master::setBits))
       .staticmethod("_setBits")
-      .def("_anyBits",            &rim::Master::anyBits)
+      .def("_anyBits",            (bool (*)(bp::object, uint32_t, uint32_t))(&rim::Master::anyBits))
       .staticmethod("_anyBits")
+      .def("_copyBitsRef",        (void (*)(bp::object, uint32_t, bp::object, uint32_t, uint32_t))(&rim::Master::copyBitsRef))
+      .staticmethod("_copyBitsRef")
+      .def("_setBitsRef",         (void (*)(bp::object, uint32_t, uint32_t))(&rim::Master::setBitsRef))
+      .staticmethod("_setBitsRef")
+      .def("_anyBitsRef",         (bool (*)(bp::object, uint32_t, uint32_t))(&rim::Master::anyBitsRef))
+      .staticmethod("_anyBitsRef")
    ;
 #endif
 }
 
 //! Create object
 rim::Master::Master() {
-   error_   = 0;
-   slave_   = rim::Slave::create(4,4); // Empty placeholder
+   error_    = 0;
+   priority_ = rim::PriorityNormal;
+   slave_    = rim::Slave::create(4,4); // Empty placeholder
 
    rogue::defaultTimeout(sumTime_);
 
    log_ = rogue::Logging::create("memory.Master");
+
+   asyncScan_   = std::chrono::steady_clock::time_point::max();
+   asyncThread_ = NULL;
+   asyncEn_     = false;
+
+   statsSlaveEpoch_ = 0;
+   statsEpoch_      = 0;
+
+   tranList_.reserve(PoolSize);
+   tranPool_.reserve(PoolSize);
 } 
 
 //! Destroy object
-rim::Master::~Master() { }
+rim::Master::~Master() { 
+   stopAsync();
+}
+
+//! Stop the asynchronous completion thread
+void rim::Master::stopAsync() {
+   std::map<uint32_t, AsyncEntry> pend;
+
+   rogue::GilRelease noGil;
+
+   {
+      std::unique_lock<std::mutex> lock(asyncMtx_);
+      asyncEn_ = false;
+      asyncCond_.notify_all();
+   }
+
+   if ( asyncThread_ != NULL ) {
+      asyncThread_->join();
+      delete asyncThread_;
+      asyncThread_ = NULL;
+   }
+
+   // Detach any transactions still in flight
+   {
+      std::unique_lock<std::mutex> lock(asyncMtx_);
+      pend.swap(asyncMap_);
+      asyncDone_.clear();
+   }
+
+   for (std::map<uint32_t, AsyncEntry>::iterator it = pend.begin(); it != pend.end(); ++it)
+      it->second.tran->setNotify(NULL);
+}
 
 //! Set slave
 void rim::Master::setSlave ( rim::SlavePtr slave ) {
    rogue::GilRelease noGil;
    std::lock_guard<std::mutex> lock(mastMtx_);
    slave_ = slave;
+   slaveEpoch_++;
 }
 
 //! Get slave
@@ -133,9 +200,26 @@ void rim::Master::setTimeout(uint64_t timeout) {
    }
 }
 
+//! Get the timeout value
+uint64_t rim::Master::getTimeout() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(mastMtx_);
+   return((uint64_t)sumTime_.tv_sec * 1000000 + sumTime_.tv_usec);
+}
+
+//! Set the priority of issued transactions
+void rim::Master::setPriority(uint32_t priority) {
+   priority_ = priority;
+}
+
+//! Get the priority of issued transactions
+uint32_t rim::Master::getPriority() {
+   return(priority_);
+}
+
 //! Post a transaction, called locally, forwarded to slave
 uint32_t rim::Master::reqTransaction(uint64_t address, uint32_t size, void *data, uint32_t type) {
-   rim::TransactionPtr tran = rim::Transaction::create(sumTime_);
+   rim::TransactionPtr tran = allocTransaction();
 
    tran->iter_    = (uint8_t *)data;
    tran->size_    = size;
@@ -145,11 +229,138 @@ uint32_t rim::Master::reqTransaction(uint64_t address, uint32_t size, void *data
    return(intTransaction(tran));
 }
 
+//! Post a transaction with its own timeout, called locally, forwarded to slave
+uint32_t rim::Master::reqTransactionTimeout(uint64_t address, uint32_t size, void *data, uint32_t type, uint64_t timeout) {
+   rim::TransactionPtr tran = allocTransaction();
+
+   tran->iter_    = (uint8_t *)data;
+   tran->size_    = size;
+   tran->address_ = address;
+   tran->type_    = type;
+
+   if ( timeout != 0 ) tran->setDeadline(tran->startTime_ + std::chrono::microseconds(timeout));
+
+   return(intTransaction(tran));
+}
+
+//! Post a transaction with a completion callback, called locally, forwarded to slave
+uint32_t rim::Master::reqTransactionAsync(uint64_t address, uint32_t size, void *data, uint32_t type, AsyncCallback callback) {
+   rim::TransactionPtr tran = allocTransaction();
+
+   tran->iter_    = (uint8_t *)data;
+   tran->size_    = size;
+   tran->address_ = address;
+   tran->type_    = type;
+
+   return(asyncTransaction(tran,callback));
+}
+
+//! Post a transaction and return a future for the result, called locally, forwarded to slave
+std::future<uint32_t> rim::Master::reqTransactionFuture(uint64_t address, uint32_t size, void *data, uint32_t type) {
+   std::shared_ptr<std::promise<uint32_t> > prom = std::make_shared<std::promise<uint32_t> >();
+   std::future<uint32_t> ret = prom->get_future();
+
+   reqTransactionAsync(address,size,data,type,[prom](uint32_t id, uint32_t error) { prom->set_value(error); });
+   return ret;
+}
+
+//! Post a list of transactions, called locally, forwarded to slave
+void rim::Master::reqTransactions(const std::vector<Request> & reqs, std::vector<uint32_t> & ids) {
+   std::vector<rim::TransactionPtr> trans;
+   rim::TransactionPtr tran;
+   uint32_t x;
+
+   trans.reserve(reqs.size());
+   ids.resize(reqs.size());
+
+   for (x=0; x < reqs.size(); x++) {
+      tran = allocTransaction();
+      tran->iter_    = (uint8_t *)reqs[x].data;
+      tran->size_    = reqs[x].size;
+      tran->address_ = reqs[x].address;
+      tran->type_    = reqs[x].type;
+      ids[x] = tran->id_;
+      trans.push_back(tran);
+   }
+
+   bulkTransaction(trans);
+}
+
 #ifndef NO_PYTHON
 
+//! Post a list of transactions, called locally, forwarded to slave, python version
+bp::list rim::Master::reqTransactionsPy(bp::object reqs) {
+   std::vector<rim::TransactionPtr> trans;
+   std::vector<rim::TransactionPtr>::iterator it;
+   bp::stl_input_iterator<bp::object> rIt(reqs);
+   bp::stl_input_iterator<bp::object> rEnd;
+   bp::list ret;
+
+   try {
+      for (; rIt != rEnd; ++rIt) {
+         bp::object r = *rIt;
+         trans.push_back(pyTransaction(bp::extract<uint64_t>(r[0]), r[1], bp::extract<uint32_t>(r[2]),
+                                       bp::extract<uint32_t>(r[3]), bp::extract<uint32_t>(r[4])));
+      }
+   } catch (...) {
+
+      // Release buffers held by the transactions which were not started
+      for (it = trans.begin(); it != trans.end(); ++it) {
+         PyBuffer_Release(&((*it)->pyBuf_));
+         (*it)->pyValid_ = false;
+         (*it)->iter_    = NULL;
+      }
+      throw;
+   }
+
+   for (it = trans.begin(); it != trans.end(); ++it) ret.append((*it)->id_);
+
+   bulkTransaction(trans);
+   return ret;
+}
+
+//! Wait for a list of transactions, python version
+bp::list rim::Master::waitTransactionsPy(bp::object ids) {
+   std::vector<uint32_t> idList;
+   std::vector<uint32_t> errors;
+   std::vector<uint32_t>::iterator it;
+   bp::list ret;
+
+   idList.assign(bp::stl_input_iterator<uint32_t>(ids), bp::stl_input_iterator<uint32_t>());
+
+   waitTransactions(idList,errors);
+
+   for (it = errors.begin(); it != errors.end(); ++it) ret.append(*it);
+   return ret;
+}
+
 //! Post a transaction, called locally, forwarded to slave, python version
 uint32_t rim::Master::reqTransactionPy(uint64_t address, boost::python::object p, uint32_t size, uint32_t offset, uint32_t type) {
-   rim::TransactionPtr tran = rim::Transaction::create(sumTime_);
+   return(intTransaction(pyTransaction(address,p,size,offset,type)));
+}
+
+//! Post a transaction with a completion callback, python version
+uint32_t rim::Master::reqTransactionAsyncPy(uint64_t address, boost::python::object p, uint32_t size, 
+                                            uint32_t offset, uint32_t type, boost::python::object callback) {
+
+   rim::TransactionPtr tran = pyTransaction(address,p,size,offset,type);
+
+   // Python object must only be released with the GIL held
+   std::shared_ptr<bp::object> cb(new bp::object(callback), [](bp::object *o) { rogue::ScopedGil gil; delete o; });
+
+   return(asyncTransaction(tran,[cb](uint32_t id, uint32_t error) {
+      rogue::ScopedGil gil;
+      try {
+         (*cb)(id,error);
+      } catch (...) {
+         PyErr_Print();
+      }
+   }));
+}
+
+//! Setup a transaction with a python buffer
+rim::TransactionPtr rim::Master::pyTransaction(uint64_t address, boost::python::object p, uint32_t size, uint32_t offset, uint32_t type) {
+   rim::TransactionPtr tran = allocTransaction();
 
    if ( PyObject_GetBuffer(p.ptr(),&(tran->pyBuf_),PyBUF_SIMPLE) < 0 )
       throw(rogue::GeneralError("Master::reqTransactionPy","Python Buffer Error"));
@@ -167,33 +378,261 @@ uint32_t rim::Master::reqTransactionPy(uint64_t address, boost::python::object p
    tran->type_    = type;
    tran->address_ = address;
 
-   return(intTransaction(tran));
+   return(tran);
 }
 
 #endif
 
+//! Forward a list of transactions, taking the Master lock once
+void rim::Master::bulkTransaction(std::vector<rim::TransactionPtr> & trans) {
+   std::vector<rim::TransactionPtr>::iterator it;
+   rim::SlavePtr slave;
+   bool stats;
+
+   if ( trans.empty() ) return;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(mastMtx_);
+      slave = slave_;
+      tranList_.insert(tranList_.end(),trans.begin(),trans.end());
+      for (it = trans.begin(), stats = true; it != trans.end() && stats; ++it) stats = attachStats(*it);
+   }
+
+   // Cached statistics object is stale, refresh it once and attach it to the whole list
+   if ( ! stats ) {
+      updateStats(slave,trans.front());
+      for (it = trans.begin() + 1; it != trans.end(); ++it) (*it)->stats_ = trans.front()->stats_;
+   }
+
+   log_->debug("Request %i bulk transactions",(uint32_t)trans.size());
+
+   for (it = trans.begin(); it != trans.end(); ++it) {
+      slave->doTransaction(*it);
+   }
+}
+
+//! Get a transaction from the free list or create a new one
+rim::TransactionPtr rim::Master::allocTransaction() {
+   rim::TransactionPtr tran;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(mastMtx_);
+
+      if ( ! tranPool_.empty() ) {
+         tran = std::move(tranPool_.back());
+         tranPool_.pop_back();
+      }
+   }
+
+   if ( tran ) tran->reset(sumTime_);
+   else tran = rim::Transaction::create(sumTime_);
+
+   tran->priority_ = priority_;
+   return(tran);
+}
+
+//! Return a completed transaction to the free list if no other references remain
+void rim::Master::freeTransaction(rim::TransactionPtr & tran) {
+
+   // A Slave or Python object may still hold a reference
+   if ( tran.use_count() != 1 ) return;
+
+   std::lock_guard<std::mutex> lock(mastMtx_);
+   if ( tranPool_.size() < PoolSize ) tranPool_.push_back(std::move(tran));
+}
+
+//! Attach the slave statistics object to a transaction if enabled, mastMtx_ must be held
+bool rim::Master::attachStats(rim::TransactionPtr & tran) {
+
+   // Cached lookup is stale after a slave or registry change
+   if ( statsSlaveEpoch_ != slaveEpoch_ || statsEpoch_ != rim::TransactionStats::epoch() ) return(false);
+
+   if ( stats_ && stats_->getEnable() ) tran->stats_ = stats_;
+   return(true);
+}
+
+//! Refresh the cached statistics object and attach it to a transaction
+void rim::Master::updateStats(rim::SlavePtr & slave, rim::TransactionPtr & tran) {
+   rim::TransactionStatsPtr stats;
+   uint64_t slaveEpoch;
+   uint64_t epoch;
+
+   // Sample epochs before the lookup so a racing change forces another refresh
+   slaveEpoch = slaveEpoch_;
+   epoch      = rim::TransactionStats::epoch();
+   stats      = rim::TransactionStats::find(slave->doSlaveId());
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(mastMtx_);
+
+   if ( slave == slave_ ) {
+      stats_           = stats;
+      statsSlaveEpoch_ = slaveEpoch;
+      statsEpoch_      = epoch;
+   }
+   if ( stats && stats->getEnable() ) tran->stats_ = stats;
+}
+
+//! Record a completed transaction into its statistics object
+void rim::Master::recordStats(rim::TransactionPtr & tran, uint32_t error) {
+   if ( ! tran->stats_ ) return;
+
+   tran->stats_->record(tran->type_, tran->size_, error,
+         std::chrono::duration_cast<std::chrono::microseconds>(tran->doneTime_ - tran->startTime_).count());
+   tran->stats_.reset();
+}
+
 uint32_t rim::Master::intTransaction(rim::TransactionPtr tran) {
-   TransactionMap::iterator it;
-   struct timeval currTime;
    rim::SlavePtr slave;
+   bool stats;
 
    {
       rogue::GilRelease noGil;
       std::lock_guard<std::mutex> lock(mastMtx_);
       slave = slave_;
-      tranMap_[tran->id_] = tran;
+      tranList_.push_back(tran);
+      stats = attachStats(tran);
    }
+   if ( ! stats ) updateStats(slave,tran);
 
    
    log_->debug("Request transaction type=%i id=%i",tran->type_,tran->id_);
    slave->doTransaction(tran);
-   tran->refreshTimer(tran);
    return(tran->id_);
 }
 
+//! Forward an asynchronous transaction
+uint32_t rim::Master::asyncTransaction(rim::TransactionPtr tran, AsyncCallback cb) {
+   std::chrono::steady_clock::time_point dl;
+   rim::SlavePtr slave;
+   uint32_t id = tran->id_;
+   bool stats;
+
+   {
+      rogue::GilRelease noGil;
+      {
+         std::lock_guard<std::mutex> lock(mastMtx_);
+         slave = slave_;
+         stats = attachStats(tran);
+      }
+
+      dl = tran->deadline();
+
+      std::lock_guard<std::mutex> lock(asyncMtx_);
+
+      if ( asyncThread_ == NULL ) {
+         asyncEn_ = true;
+         asyncThread_ = new std::thread(&rim::Master::runAsync, this);
+      }
+
+      asyncMap_[id].tran = tran;
+      asyncMap_[id].cb   = cb;
+
+      // Completion is queued for the async thread
+      tran->setNotify([this](uint32_t tid) {
+         std::lock_guard<std::mutex> lock(asyncMtx_);
+         asyncDone_.push_back(tid);
+         asyncCond_.notify_all();
+      });
+
+      if ( dl < asyncScan_ ) {
+         asyncScan_ = dl;
+         asyncCond_.notify_all();
+      }
+   }
+
+   if ( ! stats ) updateStats(slave,tran);
+
+   log_->debug("Request async transaction type=%i id=%i",tran->type_,id);
+   slave->doTransaction(tran);
+   return(id);
+}
+
+//! Asynchronous completion thread
+void rim::Master::runAsync() {
+   std::chrono::steady_clock::time_point now;
+   std::chrono::steady_clock::time_point next;
+   std::vector<rim::TransactionPtr> scan;
+   std::vector<rim::TransactionPtr>::iterator sIt;
+   std::vector<AsyncEntry> ready;
+   std::vector<AsyncEntry>::iterator rIt;
+   std::map<uint32_t, AsyncEntry>::iterator it;
+   std::vector<uint32_t> ids;
+   std::vector<uint32_t>::iterator iIt;
+   uint32_t error;
+
+   log_->logThreadId();
+
+   while(1) {
+      ids.clear();
+      scan.clear();
+      ready.clear();
+
+      {
+         std::unique_lock<std::mutex> lock(asyncMtx_);
+
+         while ( asyncEn_ && asyncDone_.empty() && std::chrono::steady_clock::now() < asyncScan_ ) 
+            asyncCond_.wait_until(lock,asyncScan_);
+
+         if ( ! asyncEn_ ) break;
+
+         ids.swap(asyncDone_);
+         for (iIt = ids.begin(); iIt != ids.end(); ++iIt) {
+            if ( (it = asyncMap_.find(*iIt)) != asyncMap_.end() ) {
+               ready.push_back(it->second);
+               asyncMap_.erase(it);
+            }
+         }
+
+         // Deadline check is due, copy the pending list
+         if ( std::chrono::steady_clock::now() >= asyncScan_ ) {
+            asyncScan_ = std::chrono::steady_clock::time_point::max();
+            for (it = asyncMap_.begin(); it != asyncMap_.end(); ++it) scan.push_back(it->second.tran);
+         }
+      }
+
+      // Deadlines are checked outside of the async lock
+      if ( ! scan.empty() ) {
+         ids.clear();
+         now  = std::chrono::steady_clock::now();
+         next = std::chrono::steady_clock::time_point::max();
+
+         for (sIt = scan.begin(); sIt != scan.end(); ++sIt) {
+            if ( (*sIt)->deadline() <= now && (*sIt)->expire() ) ids.push_back((*sIt)->id_);
+            else if ( (*sIt)->deadline() < next ) next = (*sIt)->deadline();
+         }
+
+         std::lock_guard<std::mutex> lock(asyncMtx_);
+         for (iIt = ids.begin(); iIt != ids.end(); ++iIt) {
+            if ( (it = asyncMap_.find(*iIt)) != asyncMap_.end() ) {
+               ready.push_back(it->second);
+               asyncMap_.erase(it);
+            }
+         }
+         if ( next < asyncScan_ ) asyncScan_ = next;
+      }
+
+      // Execute callbacks in completion order
+      for (rIt = ready.begin(); rIt != ready.end(); ++rIt) {
+         rIt->tran->setNotify(NULL);
+         error = rIt->tran->wait();
+         recordStats(rIt->tran,error);
+         log_->debug("Async transaction complete id=%i error=0x%x",rIt->tran->id_,error);
+         try {
+            rIt->cb(rIt->tran->id_,error);
+         } catch (std::exception &e) {
+            log_->error("Async callback error for id=%i: %s",rIt->tran->id_,e.what());
+         }
+         freeTransaction(rIt->tran);
+      }
+   }
+}
+
 // Wait for transaction. Timeout in seconds
 void rim::Master::waitTransaction(uint32_t id) {
-   TransactionMap::iterator it;
+   std::vector<rim::TransactionPtr>::iterator it;
    rim::TransactionPtr tran;
    uint32_t error;
 
@@ -202,70 +641,236 @@ void rim::Master::waitTransaction(uint32_t id) {
 
       {  // Lock the vector
          std::unique_lock<std::mutex> lock(mastMtx_);
-         if ( id != 0 ) it = tranMap_.find(id);
-         else it = tranMap_.begin();
+         if ( id != 0 ) {
+            for (it = tranList_.begin(); it != tranList_.end(); ++it) 
+               if ( (*it)->id_ == id ) break;
+         }
+         else it = tranList_.begin();
 
-         if ( it != tranMap_.end() ) {
-            tran = it->second;
-            tranMap_.erase(it);
+         if ( it != tranList_.end() ) {
+            tran = std::move(*it);
+            if ( (it + 1) != tranList_.end() ) *it = std::move(tranList_.back());
+            tranList_.pop_back();
          }
          else break;
       }
 
       // Outside of lock
       if ( (error = tran->wait()) != 0 ) error_ = error;
+      recordStats(tran,error);
+      freeTransaction(tran);
+
+      if ( id != 0 ) break;
    }
 }
 
-#ifndef NO_PYTHON
+// Wait for a list of transactions
+void rim::Master::waitTransactions(const std::vector<uint32_t> & ids, std::vector<uint32_t> & errors) {
+   std::unordered_map<uint32_t, uint32_t> pos;
+   std::unordered_map<uint32_t, uint32_t>::iterator pIt;
+   std::vector<rim::TransactionPtr> trans(ids.size());
+   uint32_t x;
+   uint32_t y;
 
-//! Copy bits from src to dst with lsbs and size
-void rim::Master::copyBits(boost::python::object dst, uint32_t dstLsb, boost::python::object src, uint32_t srcLsb, uint32_t size) {
+   errors.assign(ids.size(),0);
 
-   Py_buffer srcBuf;
-   Py_buffer dstBuf;
-   uint32_t  srcBit;
-   uint32_t  srcByte;
-   uint8_t * srcData;
-   uint32_t  dstBit;
-   uint32_t  dstByte;
-   uint8_t * dstData;
-   uint32_t  rem;
-   uint32_t  bytes;
-
-   if ( PyObject_GetBuffer(dst.ptr(),&dstBuf,PyBUF_SIMPLE) < 0 )
-      throw(rogue::GeneralError("Master::copyBits","Python Buffer Error"));
-
-   if ( (dstLsb + size) > (dstBuf.len*8) ) {
-      PyBuffer_Release(&dstBuf);
-      throw(rogue::GeneralError::boundary("Master::copyBits",(dstLsb + size),(dstBuf.len*8)));
+   pos.reserve(ids.size());
+   for (x=0; x < ids.size(); x++) pos[ids[x]] = x;
+
+   rogue::GilRelease noGil;
+
+   {  // Extract the requested transactions in a single pass
+      std::lock_guard<std::mutex> lock(mastMtx_);
+
+      for (x=0, y=0; x < tranList_.size(); x++) {
+         if ( (pIt = pos.find(tranList_[x]->id_)) != pos.end() ) trans[pIt->second] = std::move(tranList_[x]);
+         else {
+            if ( x != y ) tranList_[y] = std::move(tranList_[x]);
+            ++y;
+         }
+      }
+      tranList_.resize(y);
    }
 
-   if ( PyObject_GetBuffer(src.ptr(),&srcBuf,PyBUF_SIMPLE) < 0 ) {
-      PyBuffer_Release(&dstBuf);
-      throw(rogue::GeneralError("Master::copyBits","Python Buffer Error"));
+   // Outside of lock
+   for (x=0; x < trans.size(); x++) {
+      if ( trans[x] ) {
+         if ( (errors[x] = trans[x]->wait()) != 0 ) error_ = errors[x];
+         recordStats(trans[x],errors[x]);
+         freeTransaction(trans[x]);
+      }
    }
+}
 
-   if ( (srcLsb + size) > (srcBuf.len*8) ) {
-      PyBuffer_Release(&srcBuf);
-      PyBuffer_Release(&dstBuf);
-      throw(rogue::GeneralError::boundary("Master::copyBits",(srcLsb + size),(srcBuf.len*8)));
+// Convert between host order and the little endian order of the byte arrays
+static inline uint64_t leWord(uint64_t value) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+   return(__builtin_bswap64(value));
+#else
+   return(value);
+#endif
+}
+
+// Load up to 56 bits starting at a bit offset
+static inline uint64_t loadBits(const uint8_t *data, uint32_t lsb, uint32_t size) {
+   uint64_t value = 0;
+   uint32_t bit   = lsb % 8;
+
+   std::memcpy(&value, data + (lsb / 8), (bit + size + 7) / 8);
+   return((leWord(value) >> bit) & ((1ULL << size) - 1));
+}
+
+// Store up to 56 bits starting at a bit offset, surrounding bits are preserved
+static inline void storeBits(uint8_t *data, uint32_t lsb, uint32_t size, uint64_t value) {
+   uint64_t word  = 0;
+   uint32_t bit   = lsb % 8;
+   uint32_t bytes = (bit + size + 7) / 8;
+   uint64_t mask  = ((1ULL << size) - 1) << bit;
+
+   std::memcpy(&word, data + (lsb / 8), bytes);
+   word = leWord((leWord(word) & ~mask) | ((value << bit) & mask));
+   std::memcpy(data + (lsb / 8), &word, bytes);
+}
+
+//! Copy bits between two byte arrays
+void rim::Master::copyBits(uint8_t *dst, uint32_t dstLsb, const uint8_t *src, uint32_t srcLsb, uint32_t size) {
+   const uint8_t * sPtr;
+   uint8_t * dPtr;
+   uint64_t lo;
+   uint64_t hi;
+   uint32_t shift;
+   uint32_t bytes;
+   uint32_t num;
+
+   // Up to the destination byte boundary
+   if ( (num = std::min(size, (8 - (dstLsb % 8)) % 8)) != 0 ) {
+      storeBits(dst, dstLsb, num, loadBits(src, srcLsb, num));
+      dstLsb += num;
+      srcLsb += num;
+      size   -= num;
+   }
+
+   dPtr  = dst + (dstLsb / 8);
+   sPtr  = src + (srcLsb / 8);
+   shift = srcLsb % 8;
+
+   // Matching alignment, whole bytes are copied directly
+   if ( shift == 0 ) {
+      bytes = size / 8;
+      std::memcpy(dPtr, sPtr, bytes);
+      dPtr += bytes;
+      sPtr += bytes;
+      size -= bytes * 8;
+   }
+   else {
+#ifdef __SSE2__
+      // 128 bits per step, each 64 bit lane is joined with the low bits of the next word.
+      // The loads extend 24 bytes past sPtr, which is within the source range while size >= 192.
+      __m128i cnt  = _mm_cvtsi32_si128(shift);
+      __m128i rcnt = _mm_cvtsi32_si128(64 - shift);
+
+      for (; size >= 192; size -= 128, dPtr += 16, sPtr += 16) {
+         __m128i a = _mm_loadu_si128((const __m128i *)sPtr);
+         __m128i b = _mm_loadu_si128((const __m128i *)(sPtr + 8));
+         _mm_storeu_si128((__m128i *)dPtr, _mm_or_si128(_mm_srl_epi64(a,cnt), _mm_sll_epi64(b,rcnt)));
+      }
+#endif
+
+      // 64 bits per step, the loads extend 16 bytes past sPtr which is within the source range while size >= 128
+      for (; size >= 128; size -= 64, dPtr += 8, sPtr += 8) {
+         std::memcpy(&lo, sPtr, 8);
+         std::memcpy(&hi, sPtr + 8, 8);
+         lo = leWord((leWord(lo) >> shift) | (leWord(hi) << (64 - shift)));
+         std::memcpy(dPtr, &lo, 8);
+      }
+   }
+
+   dstLsb = (dPtr - dst) * 8;
+   srcLsb = (sPtr - src) * 8 + shift;
+
+   // Remaining bits, up to 56 per step
+   while ( size > 0 ) {
+      num = std::min(size, (uint32_t)56);
+      storeBits(dst, dstLsb, num, loadBits(src, srcLsb, num));
+      dstLsb += num;
+      srcLsb += num;
+      size   -= num;
+   }
+}
+
+//! Set a range of bits in a byte array
+void rim::Master::setBits(uint8_t *dst, uint32_t lsb, uint32_t size) {
+   uint32_t bytes;
+   uint32_t num;
+
+   // Up to the byte boundary
+   if ( (num = std::min(size, (8 - (lsb % 8)) % 8)) != 0 ) {
+      dst[lsb / 8] |= ((1 << num) - 1) << (lsb % 8);
+      lsb  += num;
+      size -= num;
+   }
+
+   bytes = size / 8;
+   std::memset(dst + (lsb / 8), 0xFF, bytes);
+   lsb  += bytes * 8;
+   size -= bytes * 8;
+
+   // Remaining bits, lsb is byte aligned
+   if ( size > 0 ) dst[lsb / 8] |= (1 << size) - 1;
+}
+
+//! Return true if any bits in a range of a byte array are set
+bool rim::Master::anyBits(const uint8_t *src, uint32_t lsb, uint32_t size) {
+   const uint8_t * ptr;
+   uint64_t word;
+   uint32_t bytes;
+   uint32_t num;
+
+   // Up to the byte boundary
+   if ( (num = std::min(size, (8 - (lsb % 8)) % 8)) != 0 ) {
+      if ( ((src[lsb / 8] >> (lsb % 8)) & ((1 << num) - 1)) != 0 ) return true;
+      lsb  += num;
+      size -= num;
+   }
+
+   ptr   = src + (lsb / 8);
+   bytes = size / 8;
+   size -= bytes * 8;
+
+   // 64 bits per step
+   for (; bytes >= 8; bytes -= 8, ptr += 8) {
+      std::memcpy(&word, ptr, 8);
+      if ( word != 0 ) return true;
    }
 
+   for (; bytes > 0; bytes--, ptr++) 
+      if ( *ptr != 0 ) return true;
+
+   // Remaining bits, ptr is byte aligned
+   return ( size > 0 && (*ptr & ((1 << size) - 1)) != 0 );
+}
+
+//! Reference bit copy, one bit per step
+void rim::Master::copyBitsRef(uint8_t *dst, uint32_t dstLsb, const uint8_t *src, uint32_t srcLsb, uint32_t size) {
+   uint32_t srcBit;
+   uint32_t srcByte;
+   uint32_t dstBit;
+   uint32_t dstByte;
+   uint32_t rem;
+   uint32_t bytes;
+
    srcByte = srcLsb / 8;
    srcBit  = srcLsb % 8;
-   srcData = (uint8_t *)srcBuf.buf;
    dstByte = dstLsb / 8;
    dstBit  = dstLsb % 8;
-   dstData = (uint8_t *)dstBuf.buf;
    rem = size;
 
-   do {
+   while (rem != 0) {
       bytes = rem / 8;
 
       // Aligned
       if ( (srcBit == 0) && (dstBit == 0) && (bytes > 0) ) {
-         std::memcpy(&(dstData[dstByte]),&(srcData[srcByte]),bytes);
+         std::memcpy(&(dst[dstByte]),&(src[srcByte]),bytes);
          dstByte += bytes;
          srcByte += bytes;
          rem -= (bytes * 8);
@@ -273,109 +878,166 @@ void rim::Master::copyBits(boost::python::object dst, uint32_t dstLsb, boost::py
 
       // Not aligned
       else {
-         dstData[dstByte] |= ((srcData[srcByte] >> srcBit) & 0x1) << dstBit;
+         dst[dstByte] |= ((src[srcByte] >> srcBit) & 0x1) << dstBit;
          srcByte += (++srcBit / 8);
          dstByte += (++dstBit / 8);
          srcBit %= 8;
          dstBit %= 8;
          rem -= 1;
       }
-   } while (rem != 0);
-
-   PyBuffer_Release(&srcBuf);
-   PyBuffer_Release(&dstBuf);
+   }
 }
 
-//! Set all bits in dest with lbs and size
-void rim::Master::setBits(boost::python::object dst, uint32_t lsb, uint32_t size) {
-   Py_buffer dstBuf;
-   uint32_t  dstBit;
-   uint32_t  dstByte;
-   uint8_t * dstData;
-   uint32_t  rem;
-   uint32_t  bytes;
-
-   if ( PyObject_GetBuffer(dst.ptr(),&dstBuf,PyBUF_SIMPLE) < 0 )
-      throw(rogue::GeneralError("Master::setBits","Python Buffer Error"));
-
-   if ( (lsb + size) > (dstBuf.len*8) ) {
-      PyBuffer_Release(&dstBuf);
-      throw(rogue::GeneralError::boundary("Master::setBits",(lsb + size),(dstBuf.len*8)));
-   }
+//! Reference bit set, one bit per step
+void rim::Master::setBitsRef(uint8_t *dst, uint32_t lsb, uint32_t size) {
+   uint32_t dstBit;
+   uint32_t dstByte;
+   uint32_t rem;
+   uint32_t bytes;
 
    dstByte = lsb / 8;
    dstBit  = lsb % 8;
-   dstData = (uint8_t *)dstBuf.buf;
    rem = size;
 
-   do {
+   while (rem != 0) {
       bytes = rem / 8;
 
       // Aligned
       if ( (dstBit == 0) && (bytes > 0) ) {
-         memset(&(dstData[dstByte]),0xFF,bytes);
+         std::memset(&(dst[dstByte]),0xFF,bytes);
          dstByte += bytes;
          rem -= (bytes * 8);
       }
 
       // Not aligned
       else {
-         dstData[dstByte] |= (0x1 << dstBit);
+         dst[dstByte] |= (0x1 << dstBit);
          dstByte += (++dstBit / 8);
          dstBit %= 8;
          rem -= 1;
       }
-   } while (rem != 0);
-
-   PyBuffer_Release(&dstBuf);
+   }
 }
 
-//! Return true if any bits are set in range
-bool rim::Master::anyBits(boost::python::object dst, uint32_t lsb, uint32_t size) {
-   Py_buffer dstBuf;
-   uint32_t  dstBit;
-   uint32_t  dstByte;
-   uint8_t * dstData;
-   uint32_t  rem;
-   uint32_t  bytes;
-   bool      ret;
-
-   if ( PyObject_GetBuffer(dst.ptr(),&dstBuf,PyBUF_SIMPLE) < 0 )
-      throw(rogue::GeneralError("Master::anyBits","Python Buffer Error"));
-
-   if ( (lsb + size) > (dstBuf.len*8) ) {
-      PyBuffer_Release(&dstBuf);
-      throw(rogue::GeneralError::boundary("Master::anyBits",(lsb + size),(dstBuf.len*8)));
-   }
+//! Reference bit check, one bit or byte per step
+bool rim::Master::anyBitsRef(const uint8_t *src, uint32_t lsb, uint32_t size) {
+   uint32_t dstBit;
+   uint32_t dstByte;
+   uint32_t rem;
+   uint32_t bytes;
+   bool     ret;
 
    dstByte = lsb / 8;
    dstBit  = lsb % 8;
-   dstData = (uint8_t *)dstBuf.buf;
    rem = size;
    ret = false;
 
-   do {
+   while (ret == false && rem != 0) {
       bytes = rem / 8;
 
       // Aligned
       if ( (dstBit == 0) && (bytes > 0) ) {
-         if (dstData[dstByte] != 0) ret = true;
+         if (src[dstByte] != 0) ret = true;
          dstByte += 1;
          rem -= 8;
       }
 
       // Not aligned
       else {
-         if ( (dstData[dstByte] & (0x1 << dstBit)) != 0) ret = true;
+         if ( (src[dstByte] & (0x1 << dstBit)) != 0) ret = true;
          dstByte += (++dstBit / 8);
          dstBit %= 8;
          rem -= 1;
       }
-   } while (ret == false && rem != 0);
+   }
+   return ret;
+}
+
+#ifndef NO_PYTHON
+
+// Get a Python byte array buffer which holds a bit range, released on error
+static void getBitsBuffer(const char * name, bp::object obj, Py_buffer * buf, uint32_t lsb, uint32_t size) {
+   if ( PyObject_GetBuffer(obj.ptr(),buf,PyBUF_SIMPLE) < 0 )
+      throw(rogue::GeneralError(name,"Python Buffer Error"));
+
+   if ( (lsb + size) > (buf->len*8) ) {
+      PyBuffer_Release(buf);
+      throw(rogue::GeneralError::boundary(name,(lsb + size),(buf->len*8)));
+   }
+}
+
+// Run a bit copy on two Python byte arrays
+static void pyCopyBits(const char * name, void (*func)(uint8_t *, uint32_t, const uint8_t *, uint32_t, uint32_t),
+                       bp::object dst, uint32_t dstLsb, bp::object src, uint32_t srcLsb, uint32_t size) {
+   Py_buffer srcBuf;
+   Py_buffer dstBuf;
+
+   getBitsBuffer(name,dst,&dstBuf,dstLsb,size);
+
+   try {
+      getBitsBuffer(name,src,&srcBuf,srcLsb,size);
+   } catch (...) {
+      PyBuffer_Release(&dstBuf);
+      throw;
+   }
+
+   func((uint8_t *)dstBuf.buf, dstLsb, (const uint8_t *)srcBuf.buf, srcLsb, size);
+
+   PyBuffer_Release(&srcBuf);
+   PyBuffer_Release(&dstBuf);
+}
 
+// Run a bit set on a Python byte array
+static void pySetBits(const char * name, void (*func)(uint8_t *, uint32_t, uint32_t),
+                      bp::object dst, uint32_t lsb, uint32_t size) {
+   Py_buffer dstBuf;
+
+   getBitsBuffer(name,dst,&dstBuf,lsb,size);
+   func((uint8_t *)dstBuf.buf, lsb, size);
    PyBuffer_Release(&dstBuf);
+}
+
+// Run a bit check on a Python byte array
+static bool pyAnyBits(const char * name, bool (*func)(const uint8_t *, uint32_t, uint32_t),
+                      bp::object src, uint32_t lsb, uint32_t size) {
+   Py_buffer srcBuf;
+   bool      ret;
+
+   getBitsBuffer(name,src,&srcBuf,lsb,size);
+   ret = func((const uint8_t *)srcBuf.buf, lsb, size);
+   PyBuffer_Release(&srcBuf);
    return ret;
 }
 
+//! Copy bits from src to dst with lsbs and size
+void rim::Master::copyBits(boost::python::object dst, uint32_t dstLsb, boost::python::object src, uint32_t srcLsb, uint32_t size) {
+   pyCopyBits("Master::copyBits",&rim::Master::copyBits,dst,dstLsb,src,srcLsb,size);
+}
+
+//! Set all bits in dest with lbs and size
+void rim::Master::setBits(boost::python::object dst, uint32_t lsb, uint32_t size) {
+   pySetBits("Master::setBits",&rim::Master::setBits,dst,lsb,size);
+}
+
+//! Return true if any bits are set in range
+bool rim::Master::anyBits(boost::python::object src, uint32_t lsb, uint32_t size) {
+   return pyAnyBits("Master::anyBits",&rim::Master::anyBits,src,lsb,size);
+}
+
+//! Reference copy of bits from src to dst with lsbs and size
+void rim::Master::copyBitsRef(boost::python::object dst, uint32_t dstLsb, boost::python::object src, uint32_t srcLsb, uint32_t size) {
+   pyCopyBits("Master::copyBitsRef",&rim::Master::copyBitsRef,dst,dstLsb,src,srcLsb,size);
+}
+
+//! Reference set of all bits in dest with lbs and size
+void rim::Master::setBitsRef(boost::python::object dst, uint32_t lsb, uint32_t size) {
+   pySetBits("Master::setBitsRef",&rim::Master::setBitsRef,dst,lsb,size);
+}
+
+//! Reference check for any bits set in range
+bool rim::Master::anyBitsRef(boost::python::object src, uint32_t lsb, uint32_t size) {
+   return pyAnyBits("Master::anyBitsRef",&rim::Master::anyBitsRef,src,lsb,size);
+}
+
 #endif
 
@@ -0,0 +1,460 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Poller
+ * ----------------------------------------------------------------------------
+ * File       : Poller.cpp
+ * Created    : 2019-01-15
+ * ----------------------------------------------------------------------------
+ * Description:
+ * Periodic poll scheduler for memory Blocks.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/Poller.h>
+#include <rogue/interfaces/memory/Master.h>
+#include <rogue/interfaces/memory/Slave.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GeneralError.h>
+#include <rogue/GilRelease.h>
+#include <rogue/ScopedGil.h>
+#include <algorithm>
+#include <cmath>
+#include <inttypes.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a Poller object
+rim::PollerPtr rim::Poller::create (uint32_t tick) {
+   rim::PollerPtr p = std::make_shared<rim::Poller>(tick);
+   return(p);
+}
+
+//! Setup class for use in python
+void rim::Poller::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::Poller, rim::PollerPtr, boost::noncopyable>("Poller",bp::init<uint32_t>())
+       .def("start",       &rim::Poller::start)
+       .def("stop",        &rim::Poller::stop)
+       .def("addBlock",    &rim::Poller::addBlock)
+       .def("removeBlock", &rim::Poller::removeBlock)
+       .def("setEnable",   &rim::Poller::setEnable)
+       .def("getInterval", &rim::Poller::getInterval)
+       .def("getCount",    &rim::Poller::getCount)
+       .def("resetStats",  &rim::Poller::resetStats)
+       .def("setCallback", &rim::Poller::setCallback)
+       .def("getStats",    &rim::Poller::getStats)
+   ;
+#endif
+}
+
+//! Create a Poller object
+rim::Poller::Poller(uint32_t tick) {
+   if ( tick == 0 ) throw(rogue::GeneralError("Poller::Poller","Tick must be non-zero"));
+
+   tickTime_  = std::chrono::microseconds(tick);
+   startTime_ = std::chrono::steady_clock::now();
+   tick_      = 0;
+   gen_       = 0;
+   batches_   = 0;
+   maxBatch_  = 0;
+   lateTicks_ = 0;
+   thread_    = NULL;
+   threadEn_  = false;
+
+#ifndef NO_PYTHON
+   callbackEn_ = false;
+#endif
+
+   log_ = rogue::Logging::create("memory.Poller");
+}
+
+//! Destroy the Poller object
+rim::Poller::~Poller() {
+   stop();
+}
+
+//! Start the poll thread
+void rim::Poller::start() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(pollMtx_);
+
+   if ( thread_ != NULL ) return;
+
+   threadEn_  = true;
+   startTime_ = std::chrono::steady_clock::now() - tickTime_ * tick_;
+   thread_    = new std::thread(&rim::Poller::runThread, this);
+}
+
+//! Stop the poll thread
+void rim::Poller::stop() {
+   rogue::GilRelease noGil;
+   std::thread * thread;
+
+   {
+      std::lock_guard<std::mutex> lock(pollMtx_);
+      thread    = thread_;
+      thread_   = NULL;
+      threadEn_ = false;
+      cond_.notify_all();
+   }
+
+   if ( thread != NULL ) {
+      thread->join();
+      delete thread;
+   }
+}
+
+//! Place an entry in the wheel, pollMtx_ must be held
+void rim::Poller::schedule(Entry & entry) {
+   Ref ref;
+
+   ref.block = entry.block.get();
+   ref.gen   = entry.gen;
+   wheel_[entry.due % Slots].push_back(ref);
+}
+
+//! Add a block to the poll schedule or update its interval
+void rim::Poller::addBlock(rim::BlockPtr block, double interval) {
+   std::map<rim::Block *, Entry>::iterator it;
+   uint64_t ticks;
+
+   if ( interval <= 0.0 ) {
+      removeBlock(block);
+      return;
+   }
+
+   ticks = (uint64_t)std::llround((interval * 1e6) / (double)tickTime_.count());
+   if ( ticks == 0 ) ticks = 1;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(pollMtx_);
+
+   if ( (it = entries_.find(block.get())) == entries_.end() ) {
+      Entry entry;
+      entry.block     = block;
+      entry.enable    = true;
+      entry.polls     = 0;
+      entry.changes   = 0;
+      entry.errors    = 0;
+      entry.jitterSum = 0;
+      entry.jitterMax = 0;
+      it = entries_.insert(std::make_pair(block.get(),entry)).first;
+   }
+
+   // New and updated entries are polled on the next tick
+   it->second.interval = ticks;
+   it->second.due      = tick_ + 1;
+   it->second.gen      = ++gen_;
+   schedule(it->second);
+   cond_.notify_all();
+}
+
+//! Remove a block from the poll schedule
+void rim::Poller::removeBlock(rim::BlockPtr block) {
+   std::map<rim::Block *, Entry>::iterator it;
+   rim::BlockPtr old;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(pollMtx_);
+
+      // Stale wheel references are dropped as the wheel turns
+      if ( (it = entries_.find(block.get())) != entries_.end() ) {
+         old = it->second.block;
+         entries_.erase(it);
+      }
+   }
+
+   // Released with the GIL held
+}
+
+//! Enable or disable polling of a block without changing its schedule
+void rim::Poller::setEnable(rim::BlockPtr block, bool enable) {
+   std::map<rim::Block *, Entry>::iterator it;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(pollMtx_);
+
+   if ( (it = entries_.find(block.get())) != entries_.end() ) it->second.enable = enable;
+}
+
+//! Get the poll interval of a block
+double rim::Poller::getInterval(rim::BlockPtr block) {
+   std::map<rim::Block *, Entry>::iterator it;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(pollMtx_);
+
+   if ( (it = entries_.find(block.get())) == entries_.end() ) return(0.0);
+   return((double)(it->second.interval * tickTime_.count()) / 1e6);
+}
+
+//! Get the number of polled blocks
+uint32_t rim::Poller::getCount() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(pollMtx_);
+   return(entries_.size());
+}
+
+//! Reset poll statistics
+void rim::Poller::resetStats() {
+   std::map<rim::Block *, Entry>::iterator it;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(pollMtx_);
+
+   for (it = entries_.begin(); it != entries_.end(); ++it) {
+      it->second.polls     = 0;
+      it->second.changes   = 0;
+      it->second.errors    = 0;
+      it->second.jitterSum = 0;
+      it->second.jitterMax = 0;
+   }
+   batches_   = 0;
+   maxBatch_  = 0;
+   lateTicks_ = 0;
+}
+
+//! Read a batch of blocks and report changes
+void rim::Poller::poll(std::vector<Poll> & batch) {
+   std::map<rim::Slave *, std::vector<uint32_t> > groups;
+   std::map<rim::Slave *, std::vector<uint32_t> >::iterator gIt;
+   std::map<rim::Slave *, rim::MasterPtr>::iterator mIt;
+   std::vector<rim::Master::Request> reqs;
+   std::vector<uint32_t> ids;
+   std::vector<uint32_t> errors;
+   rim::Master::Request req;
+   rim::SlavePtr slave;
+   rim::MasterPtr master;
+   uint64_t timeout;
+   bool notify;
+   uint32_t x;
+
+   // Group the reads by slave, masters are only accessed from the poll thread
+   for (x=0; x < batch.size(); x++) {
+      slave = batch[x].block->getSlave();
+
+      if ( (mIt = masters_.find(slave.get())) == masters_.end() ) {
+         master = rim::Master::create();
+         master->setSlave(slave);
+         master->setPriority(rim::PriorityLow);
+         masters_[slave.get()] = master;
+      }
+      groups[slave.get()].push_back(x);
+   }
+
+   // Issue each group as a single bulk request, with the longest timeout of its blocks
+   std::vector<std::vector<uint32_t> > groupIds;
+   for (gIt = groups.begin(); gIt != groups.end(); ++gIt) {
+      reqs.clear();
+      timeout = 0;
+      for (x=0; x < gIt->second.size(); x++) {
+         Poll & p = batch[gIt->second[x]];
+         p.block->pollStart();
+         timeout = std::max(timeout,p.block->getTimeout());
+         req.address = p.block->getOffset();
+         req.size    = p.block->getSize();
+         req.data    = p.block->pollData();
+         req.type    = rim::Read;
+         reqs.push_back(req);
+      }
+      masters_[gIt->first]->setTimeout(timeout);
+      masters_[gIt->first]->reqTransactions(reqs,ids);
+      groupIds.push_back(ids);
+   }
+
+   // Wait for each group and compare against the previous poll
+   notify = false;
+   x = 0;
+   for (gIt = groups.begin(); gIt != groups.end(); ++gIt, ++x) {
+      masters_[gIt->first]->waitTransactions(groupIds[x],errors);
+
+      for (uint32_t y=0; y < gIt->second.size(); y++) {
+         Poll & p = batch[gIt->second[y]];
+         p.error  = errors[y];
+         p.notify = (p.error != 0) || p.block->pollCompare();
+         notify |= p.notify;
+      }
+   }
+
+   if ( ! notify ) return;
+
+#ifndef NO_PYTHON
+   if ( callbackEn_ ) {
+      rogue::ScopedGil gil;
+      bp::list updates;
+
+      for (x=0; x < batch.size(); x++)
+         if ( batch[x].notify ) updates.append(bp::make_tuple(batch[x].block,batch[x].error));
+
+      try {
+         if ( ! callback_.is_none() ) callback_(updates);
+      } catch (...) {
+         PyErr_Print();
+      }
+      return;
+   }
+#endif
+
+   for (x=0; x < batch.size(); x++) {
+      if ( batch[x].notify && batch[x].error == 0 ) batch[x].block->pollApply();
+      else if ( batch[x].error != 0 )
+         log_->warning("Poll error 0x%x for block at offset 0x%" PRIx64, batch[x].error, batch[x].block->getOffset());
+   }
+}
+
+//! Poll thread
+void rim::Poller::runThread() {
+   std::map<rim::Block *, Entry>::iterator it;
+   std::chrono::steady_clock::time_point next;
+   std::chrono::steady_clock::time_point now;
+   std::vector<Poll> batch;
+   std::vector<Ref> refs;
+   uint64_t late;
+   uint32_t x;
+
+   log_->logThreadId();
+
+   std::unique_lock<std::mutex> lock(pollMtx_);
+
+   while ( threadEn_ ) {
+
+      // Idle until a block is added, without turning the wheel
+      if ( entries_.empty() ) {
+         cond_.wait(lock, [this]{ return (! threadEn_) || (! entries_.empty()); });
+         startTime_ = std::chrono::steady_clock::now() - tickTime_ * tick_;
+         continue;
+      }
+
+      next = startTime_ + tickTime_ * (tick_ + 1);
+      if ( cond_.wait_until(lock,next) != std::cv_status::timeout ) continue;
+
+      // Turn the wheel through all elapsed ticks
+      now  = std::chrono::steady_clock::now();
+      late = 0;
+      batch.clear();
+
+      while ( (startTime_ + tickTime_ * (tick_ + 1)) <= now ) {
+         ++tick_;
+         ++late;
+
+         refs.clear();
+         refs.swap(wheel_[tick_ % Slots]);
+
+         for (x=0; x < refs.size(); x++) {
+            if ( (it = entries_.find(refs[x].block)) == entries_.end() || it->second.gen != refs[x].gen ) continue;
+            Entry & entry = it->second;
+
+            if ( entry.due <= tick_ ) {
+               if ( entry.enable ) {
+                  batch.emplace_back();
+                  Poll & p = batch.back();
+                  p.block  = entry.block;
+                  p.gen    = entry.gen;
+                  p.jitter = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 now - (startTime_ + tickTime_ * entry.due)).count();
+                  p.error  = 0;
+                  p.notify = false;
+               }
+               entry.due = std::max(entry.due + entry.interval, tick_ + 1);
+            }
+            schedule(entry);
+         }
+      }
+      if ( late > 1 ) lateTicks_ += (late - 1);
+      if ( batch.empty() ) continue;
+
+      ++batches_;
+      maxBatch_ = std::max(maxBatch_,(uint64_t)batch.size());
+
+      lock.unlock();
+      poll(batch);
+      lock.lock();
+
+      // Update statistics, skipping entries which were removed or rescheduled
+      for (x=0; x < batch.size(); x++) {
+         if ( (it = entries_.find(batch[x].block.get())) == entries_.end() || it->second.gen != batch[x].gen ) continue;
+         Entry & entry = it->second;
+
+         ++entry.polls;
+         if ( batch[x].error != 0 ) ++entry.errors;
+         else if ( batch[x].notify ) ++entry.changes;
+         entry.jitterSum += batch[x].jitter;
+         entry.jitterMax  = std::max(entry.jitterMax,batch[x].jitter);
+      }
+
+      // A block removed during the poll may be released here, with the GIL held
+      lock.unlock();
+      {
+#ifndef NO_PYTHON
+         rogue::ScopedGil gil;
+#endif
+         batch.clear();
+      }
+      lock.lock();
+   }
+}
+
+#ifndef NO_PYTHON
+
+//! Set the update callback
+void rim::Poller::setCallback(boost::python::object callback) {
+   callback_   = callback;
+   callbackEn_ = (! callback.is_none());
+}
+
+//! Get poll statistics
+boost::python::dict rim::Poller::getStats() {
+   std::map<rim::Block *, Entry>::iterator it;
+   std::vector<Entry> copy;
+   bp::dict ret;
+   bp::list blocks;
+   uint64_t batches;
+   uint64_t maxBatch;
+   uint64_t lateTicks;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(pollMtx_);
+
+      for (it = entries_.begin(); it != entries_.end(); ++it) copy.push_back(it->second);
+      batches   = batches_;
+      maxBatch  = maxBatch_;
+      lateTicks = lateTicks_;
+   }
+
+   for (uint32_t x=0; x < copy.size(); x++) {
+      bp::dict d;
+      d["block"]     = copy[x].block;
+      d["interval"]  = (double)(copy[x].interval * tickTime_.count()) / 1e6;
+      d["enable"]    = copy[x].enable;
+      d["polls"]     = copy[x].polls;
+      d["changes"]   = copy[x].changes;
+      d["errors"]    = copy[x].errors;
+      d["jitterAvg"] = (copy[x].polls == 0) ? 0.0 : ((double)copy[x].jitterSum / (double)copy[x].polls) / 1e6;
+      d["jitterMax"] = (double)copy[x].jitterMax / 1e6;
+      blocks.append(d);
+   }
+
+   ret["tick"]      = (double)tickTime_.count() / 1e6;
+   ret["batches"]   = batches;
+   ret["maxBatch"]  = maxBatch;
+   ret["lateTicks"] = lateTicks;
+   ret["blocks"]    = blocks;
+   return(ret);
+}
+
+#endif
+
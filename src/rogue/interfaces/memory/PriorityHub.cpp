@@ -0,0 +1,301 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Priority Hub
+ * ----------------------------------------------------------------------------
+ * File       : PriorityHub.cpp
+ * Created    : 2019-01-22
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which schedules transactions by priority.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/PriorityHub.h>
+#include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GilRelease.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <inttypes.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a hub, class creator
+rim::PriorityHubPtr rim::PriorityHub::create (uint64_t offset, uint32_t depth) {
+   rim::PriorityHubPtr b = std::make_shared<rim::PriorityHub>(offset,depth);
+   return(b);
+}
+
+//! Create a hub
+rim::PriorityHub::PriorityHub(uint64_t offset, uint32_t depth) : Hub(offset,0,0) {
+   depth_       = depth;
+   outstanding_ = 0;
+   starve_      = std::chrono::microseconds(100000);
+
+   std::memset(laneStats_,0,sizeof(laneStats_));
+
+   log_ = rogue::Logging::create("memory.PriorityHub");
+}
+
+//! Destroy a hub
+rim::PriorityHub::~PriorityHub() {
+   stopAsync();
+}
+
+void rim::PriorityHub::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::PriorityHub, rim::PriorityHubPtr, bp::bases<rim::Hub>, boost::noncopyable>("PriorityHub",bp::init<uint64_t,uint32_t>())
+       .def("setDepth",       &rim::PriorityHub::setDepth)
+       .def("getDepth",       &rim::PriorityHub::getDepth)
+       .def("setStarvation",  &rim::PriorityHub::setStarvation)
+       .def("getQueued",      &rim::PriorityHub::getQueued)
+       .def("getOutstanding", &rim::PriorityHub::getOutstanding)
+       .def("resetStats",     &rim::PriorityHub::resetStats)
+       .def("getStats",       &rim::PriorityHub::getStats)
+   ;
+
+   bp::implicitly_convertible<rim::PriorityHubPtr, rim::HubPtr>();
+   bp::implicitly_convertible<rim::PriorityHubPtr, rim::MasterPtr>();
+   bp::implicitly_convertible<rim::PriorityHubPtr, rim::SlavePtr>();
+#endif
+}
+
+//! Set the max outstanding transactions
+void rim::PriorityHub::setDepth(uint32_t depth) {
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(prioMtx_);
+      depth_ = depth;
+   }
+   dispatch();
+}
+
+//! Get the max outstanding transactions
+uint32_t rim::PriorityHub::getDepth() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(prioMtx_);
+   return(depth_);
+}
+
+//! Set the starvation limit
+void rim::PriorityHub::setStarvation(uint32_t limit) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(prioMtx_);
+   starve_ = std::chrono::microseconds(limit);
+}
+
+//! Get the number of queued transactions in a lane
+uint32_t rim::PriorityHub::getQueued(uint32_t priority) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(prioMtx_);
+   return(lanes_[std::min(priority,Lanes-1)].size());
+}
+
+//! Get the number of outstanding transactions
+uint32_t rim::PriorityHub::getOutstanding() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(prioMtx_);
+   return(outstanding_);
+}
+
+//! Reset lane statistics
+void rim::PriorityHub::resetStats() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(prioMtx_);
+   std::memset(laneStats_,0,sizeof(laneStats_));
+}
+
+//! Post a transaction. Master will call this method with the access attributes.
+void rim::PriorityHub::doTransaction(rim::TransactionPtr tran) {
+   uint32_t lane;
+   Queued q;
+
+   // Adjust address
+   tran->address_ |= getOffset();
+
+   lane     = std::min(tran->priority_,Lanes-1);
+   q.tran   = tran;
+   q.queued = std::chrono::steady_clock::now();
+
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(prioMtx_);
+      lanes_[lane].push_back(q);
+      laneStats_[lane].maxDepth = std::max(laneStats_[lane].maxDepth,(uint64_t)lanes_[lane].size());
+   }
+   dispatch();
+}
+
+//! Forward queued transactions while slots are free
+void rim::PriorityHub::dispatch() {
+   std::chrono::steady_clock::time_point now;
+   uint32_t lane;
+   uint32_t x;
+   Queued q;
+
+   while (1) {
+      {
+         std::lock_guard<std::mutex> lock(prioMtx_);
+
+         if ( depth_ != 0 && outstanding_ >= depth_ ) return;
+
+         now  = std::chrono::steady_clock::now();
+         lane = Lanes;
+
+         // Oldest starving transaction in a lower lane goes first
+         if ( starve_.count() != 0 ) {
+            for (x=1; x < Lanes; x++) {
+               if ( (! lanes_[x].empty()) && (now - lanes_[x].front().queued) >= starve_ &&
+                    (lane == Lanes || lanes_[x].front().queued < lanes_[lane].front().queued) ) lane = x;
+            }
+
+            // Count transactions which bypassed higher priority work
+            for (x=0; lane != Lanes && x < lane; x++) {
+               if ( ! lanes_[x].empty() ) {
+                  ++laneStats_[lane].promoted;
+                  break;
+               }
+            }
+         }
+
+         // Otherwise highest priority lane
+         if ( lane == Lanes ) {
+            for (x=0; x < Lanes; x++) {
+               if ( ! lanes_[x].empty() ) {
+                  lane = x;
+                  break;
+               }
+            }
+         }
+         if ( lane == Lanes ) return;
+
+         q = lanes_[lane].front();
+         lanes_[lane].pop_front();
+         ++outstanding_;
+      }
+
+      forward(q,lane);
+   }
+}
+
+//! Forward a transaction
+void rim::PriorityHub::forward(Queued & q, uint32_t lane) {
+   std::shared_ptr<std::vector<uint8_t> > buff;
+   std::chrono::steady_clock::time_point queued;
+   std::chrono::steady_clock::time_point sent;
+   rim::TransactionPtr tran;
+   rim::TransactionPtr sub;
+   uint64_t wait;
+
+   tran   = q.tran;
+   queued = q.queued;
+   sent   = std::chrono::steady_clock::now();
+   wait   = std::chrono::duration_cast<std::chrono::microseconds>(sent - queued).count();
+
+   {
+      rim::TransactionLock lock(tran);
+
+      // Expired while queued, release the slot
+      if ( tran->expired() ) {
+         log_->debug("Dropping expired transaction id=%i at 0x%" PRIx64,tran->id_,tran->address_);
+         {
+            std::lock_guard<std::mutex> lock(prioMtx_);
+            --outstanding_;
+         }
+         return;
+      }
+
+      buff = std::make_shared<std::vector<uint8_t> >(tran->size_,0);
+      if ( tran->type_ == rim::Write || tran->type_ == rim::Post )
+         std::memcpy(buff->data(),tran->begin(),tran->size_);
+
+      sub = allocTransaction();
+      sub->iter_     = buff->data();
+      sub->size_     = tran->size_;
+      sub->address_  = tran->address_;
+      sub->type_     = tran->type_;
+      sub->priority_ = tran->priority_;
+      sub->setDeadline(tran->deadline());
+   }
+
+   asyncTransaction(sub,[this,buff,tran,lane,queued,wait](uint32_t id, uint32_t error) {
+      uint64_t lat;
+
+      {
+         rim::TransactionLock lock(tran);
+
+         if ( ! tran->expired() ) {
+            if ( error == 0 && (tran->type_ == rim::Read || tran->type_ == rim::Verify) )
+               std::memcpy(tran->begin(),buff->data(),tran->size_);
+            tran->done(error);
+         }
+      }
+
+      lat = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queued).count();
+
+      {
+         std::lock_guard<std::mutex> lock(prioMtx_);
+         LaneStats & s = laneStats_[lane];
+
+         --outstanding_;
+         ++s.count;
+         if ( error != 0 ) ++s.errors;
+         s.waitSum += wait;
+         s.waitMax  = std::max(s.waitMax,wait);
+         s.latSum  += lat;
+         s.latMax   = std::max(s.latMax,lat);
+      }
+
+      dispatch();
+   });
+}
+
+#ifndef NO_PYTHON
+
+//! Get lane statistics
+boost::python::dict rim::PriorityHub::getStats() {
+   LaneStats stats[Lanes];
+   uint32_t  depth[Lanes];
+   bp::dict ret;
+   uint32_t x;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(prioMtx_);
+      std::memcpy(stats,laneStats_,sizeof(stats));
+      for (x=0; x < Lanes; x++) depth[x] = lanes_[x].size();
+   }
+
+   for (x=0; x < Lanes; x++) {
+      bp::dict d;
+      d["count"]      = stats[x].count;
+      d["errors"]     = stats[x].errors;
+      d["promoted"]   = stats[x].promoted;
+      d["queued"]     = depth[x];
+      d["maxDepth"]   = stats[x].maxDepth;
+      d["waitAvg"]    = (stats[x].count == 0) ? 0.0 : ((double)stats[x].waitSum / (double)stats[x].count) / 1e6;
+      d["waitMax"]    = (double)stats[x].waitMax / 1e6;
+      d["latencyAvg"] = (stats[x].count == 0) ? 0.0 : ((double)stats[x].latSum / (double)stats[x].count) / 1e6;
+      d["latencyMax"] = (double)stats[x].latMax / 1e6;
+      ret[x] = d;
+   }
+   return(ret);
+}
+
+#endif
+
@@ -21,6 +21,7 @@
 #include <rogue/interfaces/memory/Master.h>
 #include <rogue/interfaces/memory/Constants.h>
 #include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
 #include <rogue/GeneralError.h>
 #include <memory>
 #include <rogue/GilRelease.h>
@@ -50,6 +51,11 @@ rim::Slave::Slave(uint32_t min, uint32_t max) {
    min_ = min;
    max_ = max;
 
+   tranCount_   = 0;
+   wheelTick_   = 0;
+   wheelThread_ = NULL;
+   wheelEn_     = false;
+
    classMtx_.lock();
    if ( classIdx_ == 0 ) classIdx_ = 1;
    id_ = classIdx_;
@@ -58,43 +64,191 @@ rim::Slave::Slave(uint32_t min, uint32_t max) {
 } 
 
 //! Destroy object
-rim::Slave::~Slave() { }
+rim::Slave::~Slave() { 
+   stopWheel();
+}
+
+//! Stop the timer wheel thread
+void rim::Slave::stopWheel() {
+   rogue::GilRelease noGil;
+
+   {
+      std::lock_guard<std::mutex> lock(slaveMtx_);
+      wheelEn_ = false;
+      wheelCond_.notify_all();
+   }
+
+   if ( wheelThread_ != NULL ) {
+      wheelThread_->join();
+      delete wheelThread_;
+      wheelThread_ = NULL;
+   }
+}
 
 //! Register a master.
 void rim::Slave::addTransaction(rim::TransactionPtr tran) {
    rogue::GilRelease noGil;
    std::lock_guard<std::mutex> lock(slaveMtx_);
-   tranMap_[tran->id()] = tran;
+
+   // Table and timer wheel are created on first use
+   if ( tranTable_.empty() ) {
+      tranTable_.resize(TableSize);
+      wheel_.resize(WheelSize);
+      wheelBase_   = std::chrono::steady_clock::now();
+      wheelTick_   = 0;
+      wheelEn_     = true;
+      wheelThread_ = new std::thread(&rim::Slave::runWheel, this);
+   }
+
+   rim::TransactionPtr & slot = tranTable_[tran->id_ & (TableSize-1)];
+
+   // Already tracked
+   if ( findTransaction(tran->id_) ) {
+      if ( slot && slot->id_ == tran->id_ ) slot = tran;
+      else tranOver_[tran->id_] = tran;
+   }
+   else {
+
+      if ( ! slot ) slot = tran;
+      else tranOver_[tran->id_] = tran;
+      ++tranCount_;
+   }
+
+   schedule(tran->id_, tran->deadline());
+   wheelCond_.notify_all();
 }
 
 //! Get transaction with index, called by sub classes
 rim::TransactionPtr rim::Slave::getTransaction(uint32_t index) {
    rim::TransactionPtr ret;
-   TransactionMap::iterator it;
 
    rogue::GilRelease noGil;
    std::lock_guard<std::mutex> lock(slaveMtx_);
 
-   if ( (it = tranMap_.find(index)) != tranMap_.end() ) {
-      ret = it->second;
+   if ( tranTable_.empty() ) return ret;
 
-      // Remove from list
-      tranMap_.erase(it);
+   if ( (ret = findTransaction(index)) ) removeTransaction(ret);
+   return ret;
+}
 
-      // Cleanup the list, update timers
-      it = tranMap_.begin();
-      while ( it != tranMap_.end() ) {
-         if ( it->second->expired() ) {
-            tranMap_.erase(it); // Iterator no longer valid
-            it = tranMap_.begin();
-         }
-         else {
-            it->second->refreshTimer(ret);
-            ++it;
+//! Get number of tracked transactions, called by sub classes
+uint32_t rim::Slave::tranCount() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(slaveMtx_);
+   return tranCount_;
+}
+
+//! Find a tracked transaction, slaveMtx_ must be held
+rim::TransactionPtr rim::Slave::findTransaction(uint32_t id) {
+   TransactionMap::iterator it;
+   rim::TransactionPtr & slot = tranTable_[id & (TableSize-1)];
+
+   if ( slot && slot->id_ == id ) return slot;
+
+   if ( (! tranOver_.empty()) && (it = tranOver_.find(id)) != tranOver_.end() ) return it->second;
+
+   return rim::TransactionPtr();
+}
+
+//! Remove a tracked transaction, slaveMtx_ must be held
+bool rim::Slave::removeTransaction(rim::TransactionPtr tran) {
+   TransactionMap::iterator it;
+   rim::TransactionPtr & slot = tranTable_[tran->id_ & (TableSize-1)];
+
+   if ( slot == tran ) {
+      slot.reset();
+      --tranCount_;
+      return true;
+   }
+
+   if ( (it = tranOver_.find(tran->id_)) != tranOver_.end() && it->second == tran ) {
+      tranOver_.erase(it);
+      --tranCount_;
+      return true;
+   }
+   return false;
+}
+
+//! Schedule a timer wheel entry, slaveMtx_ must be held
+void rim::Slave::schedule(uint32_t id, std::chrono::steady_clock::time_point time) {
+   WheelEntry entry;
+
+   entry.id = id;
+
+   if ( time <= wheelBase_ ) entry.tick = 0;
+   else entry.tick = (time - wheelBase_) / std::chrono::microseconds(WheelTick);
+
+   if ( entry.tick <= wheelTick_ ) entry.tick = wheelTick_ + 1;
+
+   wheel_[entry.tick % WheelSize].push_back(entry);
+}
+
+//! Timer wheel thread
+void rim::Slave::runWheel() {
+   std::vector<rim::TransactionPtr> expired;
+   std::vector<rim::TransactionPtr>::iterator it;
+   std::vector<WheelEntry> keep;
+   std::vector<WheelEntry> late;
+   std::vector<WheelEntry>::iterator wIt;
+   std::chrono::steady_clock::time_point now;
+   rim::TransactionPtr tran;
+   uint64_t nowTick;
+   uint64_t tick;
+   uint32_t x;
+
+   std::unique_lock<std::mutex> lock(slaveMtx_);
+
+   while ( wheelEn_ ) {
+
+      if ( tranCount_ == 0 ) wheelCond_.wait(lock);
+      else wheelCond_.wait_until(lock, wheelBase_ + std::chrono::microseconds(WheelTick) * (wheelTick_ + 1));
+
+      if ( ! wheelEn_ ) break;
+
+      now     = std::chrono::steady_clock::now();
+      nowTick = (now - wheelBase_) / std::chrono::microseconds(WheelTick);
+
+      // Collect due entries, a single pass over the wheel covers any gap
+      expired.clear();
+      late.clear();
+      for (tick = wheelTick_ + 1, x = 0; tick <= nowTick && x < WheelSize; ++tick, ++x) {
+         std::vector<WheelEntry> & slot = wheel_[tick % WheelSize];
+
+         keep.clear();
+         for (wIt = slot.begin(); wIt != slot.end(); ++wIt) {
+            if ( wIt->tick > nowTick ) keep.push_back(*wIt);
+            else if ( (tran = findTransaction(wIt->id)) ) {
+
+               // Deadlines are fixed, an entry is at most one tick early
+               if ( now >= tran->deadline() || tran->done_ ) {
+                  removeTransaction(tran);
+                  expired.push_back(tran);
+               }
+               else late.push_back(*wIt);
+            }
          }
+         slot.swap(keep);
       }
+      if ( nowTick > wheelTick_ ) wheelTick_ = nowTick;
+
+      for (wIt = late.begin(); wIt != late.end(); ++wIt) {
+         if ( (tran = findTransaction(wIt->id)) ) schedule(wIt->id, tran->deadline());
+      }
+
+      if ( expired.empty() ) continue;
+
+      lock.unlock();
+      for (it = expired.begin(); it != expired.end(); ++it) expireTransaction(*it);
+      expired.clear();
+      tran.reset();
+      lock.lock();
    }
-   return ret;
+}
+
+//! Called when a tracked transaction has timed out
+void rim::Slave::expireTransaction(rim::TransactionPtr tran) {
+   rim::TransactionLock lock(tran);
+   tran->done(rim::TimeoutError);
 }
 
 //! Get min size from slave
@@ -27,6 +27,8 @@
 #include <memory>
 #include <string.h>
 #include <inttypes.h>
+#include <chrono>
+#include <algorithm>
 #include <rogue/GilRelease.h>
 #include <rogue/Logging.h>
 #include <zmq.h>
@@ -84,93 +86,169 @@ rim::TcpClient::TcpClient (std::string addr, uint16_t port) : rim::Slave(4,0xFFF
    if ( zmq_connect(this->zmqReq_,this->reqAddr_.c_str()) < 0 ) 
       throw(rogue::GeneralError::network("TcpClient::TcpClient",addr,port));
 
-   // Start rx thread
+   window_ = 256;
+
+   // Start rx and send threads
    threadEn_ = true;
    this->thread_ = new std::thread(&rim::TcpClient::runThread, this);
+   this->sendThread_ = new std::thread(&rim::TcpClient::runSendThread, this);
 }
 
 //! Destructor
 rim::TcpClient::~TcpClient() {
+  stopWheel();
   this->close();
 }
 
 void rim::TcpClient::close() {
-   threadEn_ = false;
+   {
+      std::lock_guard<std::mutex> lock(bridgeMtx_);
+      threadEn_ = false;
+   }
+   sendCond_.notify_all();
+   winCond_.notify_all();
+   sendThread_->join();
    zmq_close(this->zmqResp_);
    zmq_close(this->zmqReq_);
    zmq_term(this->zmqCtx_);
    thread_->join();
 }  
 
+//! Set the transaction window
+void rim::TcpClient::setWindow(uint32_t window) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(bridgeMtx_);
+   window_ = (window == 0) ? 1 : window;
+   winCond_.notify_all();
+}
+
 //! Post a transaction
 void rim::TcpClient::doTransaction(rim::TransactionPtr tran) {
-   uint32_t  x;
-   uint32_t  msgCnt;
-   zmq_msg_t msg[5];
+   rogue::GilRelease noGil;
+   std::unique_lock<std::mutex> lock(bridgeMtx_);
+
+   // Wait for space in the window, a response or an expired transaction frees a slot
+   while ( threadEn_ && (sendQueue_.size() + tranCount()) >= window_ ) {
+      winCond_.wait_until(lock,tran->deadline());
+
+      if ( tran->expired() ) {
+         lock.unlock();
+         bridgeLog_->warning("Transaction expired waiting for window. Id=%" PRIu32,tran->id());
+         rim::TransactionLock tlock(tran);
+         tran->done(rim::TimeoutError);
+         return;
+      }
+   }
+
+   sendQueue_.push_back(tran);
+   sendCond_.notify_one();
+}
+
+//! Free the window slot of a timed out transaction
+void rim::TcpClient::expireTransaction(rim::TransactionPtr tran) {
+   rim::Slave::expireTransaction(tran);
+   std::lock_guard<std::mutex> lock(bridgeMtx_);
+   winCond_.notify_all();
+}
+
+//! Send thread
+void rim::TcpClient::runSendThread() {
+   std::deque<rim::TransactionPtr> pend;
+   std::deque<rim::TransactionPtr>::iterator it;
+   std::vector<uint8_t> buff;
+   zmq_msg_t msg;
+   uint32_t  cnt;
+   uint32_t  pos;
    uint32_t  id;
    uint64_t  addr;
    uint32_t  size;
    uint32_t  type;
+   uint32_t  tout;
 
-   rogue::GilRelease noGil;
-   std::lock_guard<std::mutex> block(bridgeMtx_);
-   rim::TransactionLockPtr lock = tran->lock();
-
-   // ID message
-   id = tran->id();
-   zmq_msg_init_size(&(msg[0]),4);
-   std::memcpy(zmq_msg_data(&(msg[0])), &id, 4);
-
-   // Addr message
-   addr = tran->address();
-   zmq_msg_init_size(&(msg[1]),8);
-   std::memcpy(zmq_msg_data(&(msg[1])), &addr, 8);
-
-   // Size message
-   size = tran->size();
-   zmq_msg_init_size(&(msg[2]),4);
-   std::memcpy(zmq_msg_data(&(msg[2])), &size, 4);
-
-   // Type message
-   type = tran->type();
-   zmq_msg_init_size(&(msg[3]),4);
-   std::memcpy(zmq_msg_data(&(msg[3])), &type, 4);
-
-   // Write transaction
-   if ( type == rim::Write || type == rim::Post ) {
-      msgCnt = 5;
-      zmq_msg_init_size(&(msg[4]),size);
-      std::memcpy(zmq_msg_data(&(msg[4])), tran->begin(), size);
-   }
+   bridgeLog_->logThreadId();
+
+   while(threadEn_) {
+      {
+         std::unique_lock<std::mutex> lock(bridgeMtx_);
+         while ( threadEn_ && sendQueue_.empty() ) sendCond_.wait(lock);
+         pend.swap(sendQueue_);
+      }
+      if ( pend.empty() ) continue;
+
+      // Pack all pending transactions into a single request
+      buff.clear();
+      cnt = 0;
+
+      for (it=pend.begin(); it != pend.end(); ++it) {
+         rim::TransactionLock lock(*it);
+
+         if ( (*it)->expired() ) {
+            bridgeLog_->warning("Transaction expired before send. Id=%" PRIu32,(*it)->id());
+            (*it)->done(rim::TimeoutError);
+            it->reset();
+            continue;
+         }
 
-   // Read transaction
-   else msgCnt = 4;
+         id   = (*it)->id();
+         addr = (*it)->address();
+         size = (*it)->size();
+         type = (*it)->type();
 
-   bridgeLog_->debug("Requested transaction id=%" PRIu32 ", addr=0x%" PRIx64
-                     ", size=%" PRIu32 ", type=%" PRIu32 ", cnt=%" PRIu32
-                     ", port: %s" ,id,addr,size,type,msgCnt,this->reqAddr_.c_str());
+         // Zero selects the server default timeout, always send a non zero budget
+         tout = std::max(std::min((*it)->remaining(),(uint64_t)0xFFFFFFFF),(uint64_t)1);
 
-   // Send message
-   for (x=0; x < msgCnt; x++) {
-      if ( zmq_sendmsg(this->zmqReq_,&(msg[x]),((x==(msgCnt-1)?0:ZMQ_SNDMORE))|ZMQ_DONTWAIT) < 0 ) {
-         bridgeLog_->warning("Failed to send transaction %" PRIu32", msg %" PRIu32, id, x);
+         pos = buff.size();
+         if ( type == rim::Write || type == rim::Post ) {
+            buff.resize(pos + ReqHeadSize + size);
+            std::memcpy(buff.data()+pos+ReqHeadSize, (*it)->begin(), size);
+         }
+         else buff.resize(pos + ReqHeadSize);
+
+         std::memcpy(buff.data()+pos,    &id,   4);
+         std::memcpy(buff.data()+pos+4,  &addr, 8);
+         std::memcpy(buff.data()+pos+12, &size, 4);
+         std::memcpy(buff.data()+pos+16, &type, 4);
+         std::memcpy(buff.data()+pos+20, &tout, 4);
+
+         // Track before sending so the response can not arrive first
+         if ( type != rim::Post ) addTransaction(*it);
+         cnt++;
+
+         bridgeLog_->debug("Requested transaction id=%" PRIu32 ", addr=0x%" PRIx64
+                           ", size=%" PRIu32 ", type=%" PRIu32 ", port: %s",
+                           id,addr,size,type,this->reqAddr_.c_str());
       }
-   }
 
-   // Add transaction
-   if ( type == rim::Post ) tran->done(0);
-   else addTransaction(tran);
+      if ( cnt > 0 ) {
+         zmq_msg_init_size(&msg,buff.size());
+         std::memcpy(zmq_msg_data(&msg), buff.data(), buff.size());
+
+         if ( zmq_sendmsg(this->zmqReq_,&msg,ZMQ_DONTWAIT) < 0 ) {
+            bridgeLog_->warning("Failed to send batch of %" PRIu32 " transactions", cnt);
+            zmq_msg_close(&msg);
+         }
+      }
+
+      // Posted writes are complete once sent
+      for (it=pend.begin(); it != pend.end(); ++it) {
+         if ( (*it) && (*it)->type() == rim::Post ) {
+            rim::TransactionLock lock(*it);
+            (*it)->done(0);
+         }
+      }
+      pend.clear();
+      winCond_.notify_all();
+   }
 }
 
 //! Run thread
 void rim::TcpClient::runThread() {
    rim::TransactionPtr tran;
-   bool      err;
-   uint64_t  more;
-   size_t    moreSize;
-   uint32_t  x;
-   uint32_t  msgCnt;
-   zmq_msg_t msg[6];
+   zmq_msg_t msg;
+   uint8_t * data;
+   size_t    msgSize;
+   size_t    pos;
+   uint32_t  dataSize;
    uint32_t  id;
    uint64_t  addr;
    uint32_t  size;
@@ -180,94 +258,71 @@ void rim::TcpClient::runThread() {
    bridgeLog_->logThreadId();
 
    while(threadEn_) {
+      zmq_msg_init(&msg);
 
-         for (x=0; x < 6; x++) zmq_msg_init(&(msg[x]));
-         msgCnt = 0;
-         x = 0;
-
-         // Get message
-         do {
-
-            // Get the message
-            if ( zmq_recvmsg(this->zmqResp_,&(msg[x]),0) > 0 ) {
-               if ( x != 5 ) x++;
-               msgCnt++;
-
-               // Is there more data?
-               more = 0;
-               moreSize = 8;
-               zmq_getsockopt(this->zmqResp_, ZMQ_RCVMORE, &more, &moreSize);
-            } else more = 1;
-      } while ( threadEn_ && more );
-
-         // Proper message received
-         if ( msgCnt == 6 ) {
-
-            // Check sizes
-            if ( (zmq_msg_size(&(msg[0])) != 4) || (zmq_msg_size(&(msg[1])) != 8) ||
-                 (zmq_msg_size(&(msg[2])) != 4) || (zmq_msg_size(&(msg[3])) != 4) ||
-                 (zmq_msg_size(&(msg[5])) != 4) ) {
-               bridgeLog_->warning("Bad message sizes");
-               for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-               continue; // while (1)
-            }
+      if ( zmq_recvmsg(this->zmqResp_,&msg,0) <= 0 ) {
+         zmq_msg_close(&msg);
+         continue;
+      }
 
-            // Get return fields
-            std::memcpy(&id,     zmq_msg_data(&(msg[0])), 4);
-            std::memcpy(&addr,   zmq_msg_data(&(msg[1])), 8);
-            std::memcpy(&size,   zmq_msg_data(&(msg[2])), 4);
-            std::memcpy(&type,   zmq_msg_data(&(msg[3])), 4);
-            std::memcpy(&result, zmq_msg_data(&(msg[5])), 4);
-
-            // Find Transaction
-            if ( (tran = getTransaction(id)) == NULL ) {
-               bridgeLog_->warning("Failed to find transaction id=%" PRIu32,id);
-               for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-               continue; // while (1)
-            }
+      data    = (uint8_t *)zmq_msg_data(&msg);
+      msgSize = zmq_msg_size(&msg);
+      pos     = 0;
+
+      // Process each response record in the batch
+      while ( (pos + RespHeadSize) <= msgSize ) {
+         std::memcpy(&id,     data+pos,    4);
+         std::memcpy(&addr,   data+pos+4,  8);
+         std::memcpy(&size,   data+pos+12, 4);
+         std::memcpy(&type,   data+pos+16, 4);
+         std::memcpy(&result, data+pos+20, 4);
+         pos += RespHeadSize;
 
-            // Lock transaction
-            rim::TransactionLockPtr lock = tran->lock();
+         dataSize = (type == rim::Write) ? 0 : size;
+
+         if ( (pos + dataSize) > msgSize ) {
+            bridgeLog_->warning("Bad message size. Id=%" PRIu32,id);
+            break;
+         }
+
+         // Find Transaction
+         if ( (tran = getTransaction(id)) == NULL ) 
+            bridgeLog_->warning("Failed to find transaction id=%" PRIu32,id);
+
+         else {
+            rim::TransactionLock lock(tran);
 
             // Transaction expired
-            if ( tran->expired() ) {
+            if ( tran->expired() ) 
                bridgeLog_->warning("Transaction expired. Id=%" PRIu32,id);
-               for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-               continue; // while (1)
-            }
 
             // Double check transaction
-            if ( (addr != tran->address()) || (size != tran->size()) || (type != tran->type()) ) {
+            else if ( (addr != tran->address()) || (size != tran->size()) || (type != tran->type()) ) {
                bridgeLog_->warning("Transaction data mistmatch. Id=%" PRIu32,id);
                tran->done(rim::ProtocolError);
-               for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-               continue; // while (1)
             }
 
-            // Copy data if read
-            if ( type != rim::Write ) {
-               if (zmq_msg_size(&(msg[4])) != size) {
-                  bridgeLog_->warning("Transaction size mistmatch. Id=%" PRIu32,id);
-                  tran->done(rim::ProtocolError);
-                  for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-                  continue; // while (1)
-               }
-               std::memcpy(tran->begin(),zmq_msg_data(&(msg[4])), size);
+            else {
+               if ( dataSize != 0 ) std::memcpy(tran->begin(), data+pos, size);
+               tran->done(result);
+               bridgeLog_->debug("Response for transaction id=%" PRIu32 ", addr=0x%" PRIx64
+                                 ", size=%" PRIu32 ", type=%" PRIu32 ", result=%" PRIu32
+                                 ", port: %s", id,addr,size,type,result,this->respAddr_.c_str());
             }
-            tran->done(result);
-            bridgeLog_->debug("Response for transaction id=%" PRIu32 ", addr=0x%" PRIx64
-                              ", size=%" PRIu32 ", type=%" PRIu32 ", cnt=%" PRIu32
-                              ", port: %s", id,addr,size,type,msgCnt, this->respAddr_.c_str());
          }
-         for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
+         pos += dataSize;
       }
+      zmq_msg_close(&msg);
+      winCond_.notify_all();
+   }
 }
 
 void rim::TcpClient::setup_python () {
 #ifndef NO_PYTHON
 
    bp::class_<rim::TcpClient, rim::TcpClientPtr, bp::bases<rim::Slave>, boost::noncopyable >("TcpClient",bp::init<std::string,uint16_t>())
-       .def("close", &rim::TcpClient::close);
+       .def("close",     &rim::TcpClient::close)
+       .def("setWindow", &rim::TcpClient::setWindow);
 
    bp::implicitly_convertible<rim::TcpClientPtr, rim::SlavePtr>();
 #endif
@@ -96,91 +96,130 @@ void rim::TcpServer::close() {
 
 //! Run thread
 void rim::TcpServer::runThread() {
-   uint8_t * data;
-   uint64_t  more;
-   size_t    moreSize;
-   uint32_t  x;
+
+   // Record tracking
+   struct Record {
+      uint32_t  tid;
+      uint32_t  id;
+      uint64_t  addr;
+      uint32_t  size;
+      uint32_t  type;
+      uint32_t  tout;
+      uint8_t * data;
+      uint32_t  respPos;
+   };
+
+   std::vector<Record> recs;
+   std::vector<Record>::iterator it;
+   zmq_msg_t reqMsg[MaxBatch];
+   zmq_msg_t respMsg;
+   uint8_t * req;
+   uint8_t * resp;
+   size_t    reqSize;
+   size_t    pos;
+   uint32_t  respSize;
    uint32_t  msgCnt;
-   zmq_msg_t msg[6];
-   uint32_t  id;
-   uint64_t  addr;
-   uint32_t  size;
-   uint32_t  type;
+   uint32_t  x;
    uint32_t  result;
+   Record    rec;
 
    bridgeLog_->logThreadId();
 
    while(threadEn_) {
+      recs.clear();
+      respSize = 0;
+      msgCnt   = 0;
+
+      // Wait for a request, then pick up any others that are already queued
+      zmq_msg_init(&(reqMsg[0]));
+      if ( zmq_recvmsg(this->zmqReq_,&(reqMsg[0]),0) <= 0 ) {
+         zmq_msg_close(&(reqMsg[0]));
+         continue;
+      }
+      msgCnt = 1;
 
-         for (x=0; x < 6; x++) zmq_msg_init(&(msg[x]));
-         msgCnt = 0;
-         x = 0;
-
-         // Get message
-         do {
-
-            // Get the message
-            if ( zmq_recvmsg(this->zmqReq_,&(msg[x]),0) > 0 ) {
-               if ( x != 4 ) x++;
-               msgCnt++;
-
-               // Is there more data?
-               more = 0;
-               moreSize = 8;
-               zmq_getsockopt(this->zmqReq_, ZMQ_RCVMORE, &more, &moreSize);
-            } else more = 1;
-      } while ( threadEn_ && more );
-
-         // Proper message received
-         if ( msgCnt == 4 || msgCnt == 5) {
-
-            // Check sizes
-            if ( (zmq_msg_size(&(msg[0])) != 4) || (zmq_msg_size(&(msg[1])) != 8) ||
-                 (zmq_msg_size(&(msg[2])) != 4) || (zmq_msg_size(&(msg[3])) != 4) ) {
-               bridgeLog_->warning("Bad message sizes");
-               for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-               continue; // while (1)
-            }
+      while ( msgCnt < MaxBatch ) {
+         zmq_msg_init(&(reqMsg[msgCnt]));
+         if ( zmq_recvmsg(this->zmqReq_,&(reqMsg[msgCnt]),ZMQ_DONTWAIT) <= 0 ) {
+            zmq_msg_close(&(reqMsg[msgCnt]));
+            break;
+         }
+         msgCnt++;
+      }
 
-            // Get return fields
-            std::memcpy(&id,   zmq_msg_data(&(msg[0])), 4);
-            std::memcpy(&addr, zmq_msg_data(&(msg[1])), 8);
-            std::memcpy(&size, zmq_msg_data(&(msg[2])), 4);
-            std::memcpy(&type, zmq_msg_data(&(msg[3])), 4);
+      // Decode records
+      for (x=0; x < msgCnt; x++) {
+         req     = (uint8_t *)zmq_msg_data(&(reqMsg[x]));
+         reqSize = zmq_msg_size(&(reqMsg[x]));
+         pos     = 0;
+
+         while ( (pos + ReqHeadSize) <= reqSize ) {
+            std::memcpy(&(rec.id),   req+pos,    4);
+            std::memcpy(&(rec.addr), req+pos+4,  8);
+            std::memcpy(&(rec.size), req+pos+12, 4);
+            std::memcpy(&(rec.type), req+pos+16, 4);
+            std::memcpy(&(rec.tout), req+pos+20, 4);
+            pos += ReqHeadSize;
 
             // Write data is expected
-            if ( (type == rim::Write) || (type == rim::Post) ) {
-               if ((msgCnt != 5) || (zmq_msg_size(&(msg[4])) != size) ) {
-                  bridgeLog_->warning("Transaction write data error. Id=%" PRIu32,id);
-                  for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
-                  continue; // while (1)
+            if ( (rec.type == rim::Write) || (rec.type == rim::Post) ) {
+               if ( (pos + rec.size) > reqSize ) {
+                  bridgeLog_->warning("Transaction write data error. Id=%" PRIu32,rec.id);
+                  break;
                }
+               rec.data = req + pos;
+               pos += rec.size;
             }
-            else zmq_msg_init_size(&(msg[4]),size);
+            else rec.data = NULL;
 
-            // Data pointer
-            data = (uint8_t *)zmq_msg_data(&(msg[4]));
+            // Posted writes do not generate a response
+            if ( rec.type == rim::Post ) rec.respPos = 0;
+            else {
+               rec.respPos = respSize;
+               respSize += RespHeadSize + ((rec.type == rim::Write) ? 0 : rec.size);
+            }
+            recs.push_back(rec);
+         }
+      }
 
-            bridgeLog_->debug("Starting transaction id=%" PRIu32 ", addr=0x%" PRIx64 ", size=%" PRIu32 ", type=%" PRIu32,id,addr,size,type);
+      // Allocate the response, read data is returned directly into it
+      zmq_msg_init_size(&respMsg,respSize);
+      resp = (uint8_t *)zmq_msg_data(&respMsg);
 
-            // Execute transaction and wait for result
-            this->setError(0);
-            reqTransaction(addr,size,data,type);
-            waitTransaction(0);
-            result = getError();
+      // Dispatch all transactions before waiting on any of them
+      for (it=recs.begin(); it != recs.end(); ++it) {
+         if ( it->data == NULL ) it->data = resp + it->respPos + RespHeadSize;
 
-            bridgeLog_->debug("Done transaction id=%" PRIu32 ", addr=0x%" PRIx64 ", size=%" PRIu32 ", type=%" PRIu32 ", result=%" PRIu32,id,addr,size,type,result);
+         bridgeLog_->debug("Starting transaction id=%" PRIu32 ", addr=0x%" PRIx64 ", size=%" PRIu32 ", type=%" PRIu32,
+                           it->id,it->addr,it->size,it->type);
 
-            // Result message
-            zmq_msg_init_size(&(msg[5]),4);
-            std::memcpy(zmq_msg_data(&(msg[5])),&result, 4);
+         // Expire with the client side transaction
+         it->tid = reqTransactionTimeout(it->addr,it->size,it->data,it->type,it->tout);
+      }
 
-            // Send message
-            for (x=0; x < 6; x++) 
-               zmq_sendmsg(this->zmqResp_,&(msg[x]),(x==5)?0:ZMQ_SNDMORE);
+      // Wait for results in order
+      for (it=recs.begin(); it != recs.end(); ++it) {
+         this->setError(0);
+         waitTransaction(it->tid);
+         result = getError();
+
+         bridgeLog_->debug("Done transaction id=%" PRIu32 ", addr=0x%" PRIx64 ", size=%" PRIu32 ", type=%" PRIu32 ", result=%" PRIu32,
+                           it->id,it->addr,it->size,it->type,result);
+
+         if ( it->type != rim::Post ) {
+            std::memcpy(resp+it->respPos,    &(it->id),   4);
+            std::memcpy(resp+it->respPos+4,  &(it->addr), 8);
+            std::memcpy(resp+it->respPos+12, &(it->size), 4);
+            std::memcpy(resp+it->respPos+16, &(it->type), 4);
+            std::memcpy(resp+it->respPos+20, &result,     4);
          }
-         else for (x=0; x < msgCnt; x++) zmq_msg_close(&(msg[x]));
       }
+
+      for (x=0; x < msgCnt; x++) zmq_msg_close(&(reqMsg[x]));
+
+      // Send response
+      if ( respSize == 0 || zmq_sendmsg(this->zmqResp_,&respMsg,0) < 0 ) zmq_msg_close(&respMsg);
+   }
 }
 
 void rim::TcpServer::setup_python () {
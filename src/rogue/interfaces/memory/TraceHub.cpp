@@ -0,0 +1,247 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Trace Hub
+ * ----------------------------------------------------------------------------
+ * File       : TraceHub.cpp
+ * Created    : 2019-01-28
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface hub which records transactions to a trace file.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/TraceHub.h>
+#include <rogue/interfaces/memory/Transaction.h>
+#include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GeneralError.h>
+#include <rogue/GilRelease.h>
+#include <cstring>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a hub, class creator
+rim::TraceHubPtr rim::TraceHub::create (uint64_t offset) {
+   rim::TraceHubPtr b = std::make_shared<rim::TraceHub>(offset);
+   return(b);
+}
+
+//! Create a hub
+rim::TraceHub::TraceHub(uint64_t offset) : Hub(offset,0,0) {
+   fd_     = -1;
+   dataEn_ = true;
+   count_  = 0;
+   size_   = 0;
+
+   log_ = rogue::Logging::create("memory.TraceHub");
+}
+
+//! Destroy a hub
+rim::TraceHub::~TraceHub() {
+   stopAsync();
+   this->close();
+}
+
+void rim::TraceHub::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::TraceHub, rim::TraceHubPtr, bp::bases<rim::Hub>, boost::noncopyable>("TraceHub",bp::init<uint64_t>())
+       .def("open",          &rim::TraceHub::open)
+       .def("close",         &rim::TraceHub::close)
+       .def("setDataEnable", &rim::TraceHub::setDataEnable)
+       .def("getCount",      &rim::TraceHub::getCount)
+       .def("getSize",       &rim::TraceHub::getSize)
+   ;
+
+   bp::implicitly_convertible<rim::TraceHubPtr, rim::HubPtr>();
+   bp::implicitly_convertible<rim::TraceHubPtr, rim::MasterPtr>();
+   bp::implicitly_convertible<rim::TraceHubPtr, rim::SlavePtr>();
+#endif
+}
+
+//! Open a trace file and start recording
+void rim::TraceHub::open(std::string file) {
+   uint32_t head[2];
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(traceMtx_);
+
+   if ( fd_ >= 0 ) {
+      flush();
+      ::close(fd_);
+      fd_ = -1;
+   }
+
+   if ( (fd_ = ::open(file.c_str(),O_RDWR|O_CREAT|O_TRUNC,S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH)) < 0 )
+      throw(rogue::GeneralError::open("TraceHub::open",file));
+
+   head[0] = TraceMagic;
+   head[1] = TraceVersion;
+
+   buffer_.clear();
+   buffer_.reserve(FlushSize + RecordHeader);
+   buffer_.insert(buffer_.end(),(uint8_t *)head,(uint8_t *)head + sizeof(head));
+
+   count_ = 0;
+   size_  = 0;
+   start_ = std::chrono::steady_clock::now();
+}
+
+//! Stop recording and close the trace file
+void rim::TraceHub::close() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(traceMtx_);
+
+   if ( fd_ >= 0 ) {
+      flush();
+      ::close(fd_);
+   }
+   fd_ = -1;
+}
+
+//! Enable or disable recording of transaction data
+void rim::TraceHub::setDataEnable(bool enable) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(traceMtx_);
+   dataEn_ = enable;
+}
+
+//! Get the number of recorded transactions
+uint64_t rim::TraceHub::getCount() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(traceMtx_);
+   return(count_);
+}
+
+//! Get the size of the trace file
+uint64_t rim::TraceHub::getSize() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(traceMtx_);
+   return(size_ + buffer_.size());
+}
+
+//! Write the record buffer to the file, traceMtx_ must be held
+void rim::TraceHub::flush() {
+   if ( fd_ < 0 || buffer_.empty() ) return;
+
+   if ( write(fd_,buffer_.data(),buffer_.size()) != (ssize_t)buffer_.size() ) {
+      ::close(fd_);
+      fd_ = -1;
+      log_->error("Write failed, closing file!");
+   }
+   else size_ += buffer_.size();
+
+   buffer_.clear();
+}
+
+//! Append a record, traceMtx_ must be held
+void rim::TraceHub::record(uint32_t type, uint64_t time, uint64_t address, uint32_t size,
+                           uint32_t error, uint32_t latency, uint8_t *data) {
+   uint8_t  head[RecordHeader];
+   uint32_t value;
+
+   value = RecordHeader - 4 + ((data == NULL) ? 0 : size);
+   std::memcpy(head,&value,4);
+
+   value = (type << 24) | (((data == NULL) ? 0 : FlagData) << 16);
+   std::memcpy(head+4,&value,4);
+
+   std::memcpy(head+8, &time,   8);
+   std::memcpy(head+16,&address,8);
+   std::memcpy(head+24,&size,   4);
+   std::memcpy(head+28,&error,  4);
+   std::memcpy(head+32,&latency,4);
+
+   buffer_.insert(buffer_.end(),head,head+RecordHeader);
+   if ( data != NULL ) buffer_.insert(buffer_.end(),data,data+size);
+
+   ++count_;
+   if ( buffer_.size() >= FlushSize ) flush();
+}
+
+//! Post a transaction. Master will call this method with the access attributes.
+void rim::TraceHub::doTransaction(rim::TransactionPtr tran) {
+   std::shared_ptr<std::vector<uint8_t> > buff;
+   std::chrono::steady_clock::time_point req;
+   rim::TransactionPtr sub;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(traceMtx_);
+
+      // Not recording
+      if ( fd_ < 0 ) {
+         rim::Hub::doTransaction(tran);
+         return;
+      }
+   }
+
+   // Adjust address
+   tran->address_ |= getOffset();
+   req = std::chrono::steady_clock::now();
+
+   {
+      rim::TransactionLock lock(tran);
+
+      buff = std::make_shared<std::vector<uint8_t> >(tran->size_,0);
+      if ( tran->type_ == rim::Write || tran->type_ == rim::Post || tran->type_ == rim::Verify )
+         std::memcpy(buff->data(),tran->begin(),tran->size_);
+
+      sub = allocTransaction();
+      sub->iter_     = buff->data();
+      sub->size_     = tran->size_;
+      sub->address_  = tran->address_;
+      sub->type_     = tran->type_;
+      sub->priority_ = tran->priority_;
+      sub->setDeadline(tran->deadline());
+   }
+
+   asyncTransaction(sub,[this,buff,tran,req](uint32_t id, uint32_t error) {
+      std::chrono::steady_clock::time_point now;
+      uint32_t type;
+      uint64_t addr;
+
+      {
+         rim::TransactionLock lock(tran);
+
+         type = tran->type_;
+         addr = tran->address_;
+
+         if ( ! tran->expired() ) {
+            if ( error == 0 && (tran->type_ == rim::Read || tran->type_ == rim::Verify) )
+               std::memcpy(tran->begin(),buff->data(),tran->size_);
+            tran->done(error);
+         }
+      }
+
+      now = std::chrono::steady_clock::now();
+
+      {
+         std::lock_guard<std::mutex> lock(traceMtx_);
+
+         // Closed while in flight, or requested before the current file was opened
+         if ( fd_ < 0 || req < start_ ) return;
+
+         record(type,
+                std::chrono::duration_cast<std::chrono::microseconds>(req - start_).count(),
+                addr, buff->size(), error,
+                std::chrono::duration_cast<std::chrono::microseconds>(now - req).count(),
+                dataEn_ ? buff->data() : NULL);
+      }
+   });
+}
+
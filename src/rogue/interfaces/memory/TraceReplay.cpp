@@ -0,0 +1,281 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Trace Replay
+ * ----------------------------------------------------------------------------
+ * File       : TraceReplay.cpp
+ * Created    : 2019-01-28
+ * ----------------------------------------------------------------------------
+ * Description:
+ * A memory interface master which re-issues a recorded transaction trace.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the rogue software platform, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/TraceReplay.h>
+#include <rogue/interfaces/memory/TraceHub.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GeneralError.h>
+#include <rogue/GilRelease.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Create a replay master, class creator
+rim::TraceReplayPtr rim::TraceReplay::create () {
+   rim::TraceReplayPtr r = std::make_shared<rim::TraceReplay>();
+   return(r);
+}
+
+//! Create a replay master
+rim::TraceReplay::TraceReplay() : Master() {
+   depth_       = 16;
+   outstanding_ = 0;
+   count_       = 0;
+   bytes_       = 0;
+   errors_      = 0;
+   mismatches_  = 0;
+   latSum_      = 0;
+   latMax_      = 0;
+   elapsed_     = 0.0;
+
+   log_ = rogue::Logging::create("memory.TraceReplay");
+}
+
+//! Destroy a replay master
+rim::TraceReplay::~TraceReplay() {
+   stopAsync();
+}
+
+void rim::TraceReplay::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::TraceReplay, rim::TraceReplayPtr, bp::bases<rim::Master>, boost::noncopyable>("TraceReplay",bp::init<>())
+       .def("load",     &rim::TraceReplay::load)
+       .def("getCount", &rim::TraceReplay::getCount)
+       .def("setDepth", &rim::TraceReplay::setDepth)
+       .def("run",      &rim::TraceReplay::run)
+       .def("getStats", &rim::TraceReplay::getStats)
+   ;
+
+   bp::implicitly_convertible<rim::TraceReplayPtr, rim::MasterPtr>();
+#endif
+}
+
+//! Load a trace file
+void rim::TraceReplay::load(std::string file) {
+   std::vector<uint8_t> raw;
+   uint8_t  chunk[65536];
+   uint32_t head[2];
+   uint32_t value;
+   uint64_t pos;
+   ssize_t  ret;
+   int32_t  fd;
+   Record   r;
+
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(replayMtx_);
+
+   if ( (fd = ::open(file.c_str(),O_RDONLY)) < 0 )
+      throw(rogue::GeneralError::open("TraceReplay::load",file));
+
+   while ( (ret = read(fd,chunk,sizeof(chunk))) > 0 ) raw.insert(raw.end(),chunk,chunk+ret);
+   ::close(fd);
+
+   if ( ret < 0 ) throw(rogue::GeneralError::open("TraceReplay::load",file));
+
+   if ( raw.size() < sizeof(head) )
+      throw(rogue::GeneralError::create("TraceReplay::load","File %s is not a trace file",file.c_str()));
+
+   std::memcpy(head,raw.data(),sizeof(head));
+
+   if ( head[0] != rim::TraceHub::TraceMagic || head[1] != rim::TraceHub::TraceVersion )
+      throw(rogue::GeneralError::create("TraceReplay::load","File %s is not a version %i trace file",
+                                        file.c_str(),rim::TraceHub::TraceVersion));
+
+   records_.clear();
+   data_.clear();
+   pos = sizeof(head);
+
+   while ( (pos + rim::TraceHub::RecordHeader) <= raw.size() ) {
+      std::memcpy(&value,    raw.data()+pos,   4);
+      std::memcpy(&r.time,   raw.data()+pos+8, 8);
+      std::memcpy(&r.address,raw.data()+pos+16,8);
+      std::memcpy(&r.size,   raw.data()+pos+24,4);
+      std::memcpy(&r.error,  raw.data()+pos+28,4);
+      std::memcpy(&r.latency,raw.data()+pos+32,4);
+
+      // Truncated record, the file was not closed
+      if ( (pos + 4 + value) > raw.size() ) break;
+
+      r.type   = raw[pos+7];
+      r.data   = (raw[pos+6] & rim::TraceHub::FlagData) != 0;
+      r.offset = data_.size();
+
+      if ( r.data ) data_.insert(data_.end(),raw.data()+pos+rim::TraceHub::RecordHeader,
+                                             raw.data()+pos+rim::TraceHub::RecordHeader+r.size);
+      else data_.resize(data_.size() + r.size,0);
+
+      records_.push_back(r);
+      pos += 4 + value;
+   }
+
+   if ( pos != raw.size() ) log_->warning("Ignoring %i trailing bytes in %s",(int)(raw.size()-pos),file.c_str());
+
+   // Records are written in completion order
+   std::stable_sort(records_.begin(),records_.end(),[](const Record & a, const Record & b) { return(a.time < b.time); });
+
+   work_.resize(data_.size());
+   log_->info("Loaded %i transactions from %s",(int)records_.size(),file.c_str());
+}
+
+//! Get the number of loaded transactions
+uint32_t rim::TraceReplay::getCount() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(replayMtx_);
+   return(records_.size());
+}
+
+//! Set the max transactions in flight
+void rim::TraceReplay::setDepth(uint32_t depth) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(replayMtx_);
+   depth_ = depth;
+}
+
+//! Re-issue the loaded trace and wait for it to complete
+void rim::TraceReplay::run(double speed) {
+   std::chrono::steady_clock::time_point start;
+   std::chrono::steady_clock::time_point sent;
+   uint32_t x;
+
+   rogue::GilRelease noGil;
+   std::unique_lock<std::mutex> lock(replayMtx_);
+
+   count_      = 0;
+   bytes_      = 0;
+   errors_     = 0;
+   mismatches_ = 0;
+   latSum_     = 0;
+   latMax_     = 0;
+
+   std::memcpy(work_.data(),data_.data(),data_.size());
+   start = std::chrono::steady_clock::now();
+
+   for (x=0; x < records_.size(); x++) {
+      Record & r = records_[x];
+
+      // Recorded timing, relative to the first transaction
+      if ( speed > 0.0 ) {
+         lock.unlock();
+         std::this_thread::sleep_until(start + std::chrono::microseconds(
+            (uint64_t)((double)(r.time - records_[0].time) / speed)));
+         lock.lock();
+      }
+
+      while ( depth_ != 0 && outstanding_ >= depth_ ) replayCond_.wait(lock);
+      ++outstanding_;
+
+      lock.unlock();
+      sent = std::chrono::steady_clock::now();
+      reqTransactionAsync(r.address,r.size,work_.data()+r.offset,r.type,[this,x,sent](uint32_t id, uint32_t error) {
+         complete(x,sent,error);
+      });
+      lock.lock();
+   }
+
+   while ( outstanding_ != 0 ) replayCond_.wait(lock);
+   elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Record completion
+void rim::TraceReplay::complete(uint32_t index, std::chrono::steady_clock::time_point sent, uint32_t error) {
+   uint64_t lat;
+
+   lat = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sent).count();
+
+   std::lock_guard<std::mutex> lock(replayMtx_);
+   Record & r = records_[index];
+
+   ++count_;
+   bytes_  += r.size;
+   latSum_ += lat;
+   latMax_  = std::max(latMax_,lat);
+
+   if ( error != 0 ) ++errors_;
+
+   // Compare read data against the recording
+   else if ( r.data && r.error == 0 && (r.type == rim::Read || r.type == rim::Verify) &&
+             std::memcmp(work_.data()+r.offset,data_.data()+r.offset,r.size) != 0 ) ++mismatches_;
+
+   --outstanding_;
+   replayCond_.notify_all();
+}
+
+#ifndef NO_PYTHON
+
+//! Get statistics of the last run
+boost::python::dict rim::TraceReplay::getStats() {
+   uint64_t count, bytes, errors, mismatches, latSum, latMax;
+   uint64_t recSum, recMax, first, last;
+   uint32_t recCount;
+   double elapsed;
+   bp::dict ret;
+   uint32_t x;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(replayMtx_);
+
+      count      = count_;
+      bytes      = bytes_;
+      errors     = errors_;
+      mismatches = mismatches_;
+      latSum     = latSum_;
+      latMax     = latMax_;
+      elapsed    = elapsed_;
+      recCount   = records_.size();
+
+      recSum = 0;
+      recMax = 0;
+      first  = records_.empty() ? 0 : records_.front().time;
+      last   = first;
+
+      for (x=0; x < records_.size(); x++) {
+         recSum += records_[x].latency;
+         recMax  = std::max(recMax,(uint64_t)records_[x].latency);
+         last    = std::max(last,records_[x].time + records_[x].latency);
+      }
+   }
+
+   ret["count"]              = count;
+   ret["bytes"]              = bytes;
+   ret["errors"]             = errors;
+   ret["mismatches"]         = mismatches;
+   ret["elapsed"]            = elapsed;
+   ret["recordedTime"]       = (double)(last - first) / 1e6;
+   ret["rate"]               = (elapsed > 0.0) ? ((double)count / elapsed) : 0.0;
+   ret["bandwidth"]          = (elapsed > 0.0) ? ((double)bytes / elapsed) : 0.0;
+   ret["latencyAvg"]         = (count == 0) ? 0.0 : ((double)latSum / (double)count) / 1e6;
+   ret["latencyMax"]         = (double)latMax / 1e6;
+   ret["recordedLatencyAvg"] = (recCount == 0) ? 0.0 : ((double)recSum / (double)recCount) / 1e6;
+   ret["recordedLatencyMax"] = (double)recMax / 1e6;
+   return(ret);
+}
+
+#endif
+
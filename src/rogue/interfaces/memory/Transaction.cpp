@@ -28,6 +28,7 @@
 #include <rogue/GilRelease.h>
 #include <rogue/ScopedGil.h>
 #include <sys/time.h>
+#include <chrono>
 
 namespace rim = rogue::interfaces::memory;
 
@@ -37,10 +38,7 @@ namespace bp  = boost::python;
 #endif
 
 // Init class counter
-uint32_t rim::Transaction::classIdx_ = 0;
-
-//! Class instance lock
-std::mutex rim::Transaction::classMtx_;
+std::atomic<uint32_t> rim::Transaction::classIdx_(1);
 
 //! Create a master container
 rim::TransactionPtr rim::Transaction::create (struct timeval timeout) {
@@ -56,8 +54,10 @@ void rim::Transaction::setup_python() {
       .def("address", &rim::Transaction::address)
       .def("size",    &rim::Transaction::size)
       .def("type",    &rim::Transaction::type)
+      .def("priority",&rim::Transaction::priority)
       .def("done",    &rim::Transaction::done)
       .def("expired", &rim::Transaction::expired)
+      .def("remaining",&rim::Transaction::remaining)
       .def("setData", &rim::Transaction::setData)
       .def("getData", &rim::Transaction::getData)
    ;
@@ -65,26 +65,31 @@ void rim::Transaction::setup_python() {
 }
 
 //! Create object
-rim::Transaction::Transaction(struct timeval timeout) : timeout_(timeout) {
-   gettimeofday(&startTime_,NULL);
+rim::Transaction::Transaction(struct timeval timeout) {
+   reset(timeout);
+} 
 
-   endTime_.tv_sec    = 0;
-   endTime_.tv_usec   = 0;
+//! Reset the transaction for reuse with a new id
+void rim::Transaction::reset(struct timeval timeout) {
+   timeout_   = std::chrono::seconds(timeout.tv_sec) + std::chrono::microseconds(timeout.tv_usec);
+   startTime_ = std::chrono::steady_clock::now();
+   endTime_   = startTime_ + timeout_;
+   doneTime_  = startTime_;
 
    pyValid_ = false;
+   stats_.reset();
+   notify_  = nullptr;
 
    iter_    = NULL;
    address_ = 0;
    size_    = 0;
    type_    = 0;
+   priority_ = rim::PriorityNormal;
    error_   = 0;
    done_    = false;
 
-   classMtx_.lock();
-   if ( classIdx_ == 0 ) classIdx_ = 1;
-   id_ = classIdx_;
-   classIdx_++;
-   classMtx_.unlock();
+   // Zero is never used as an id
+   while ( (id_ = classIdx_.fetch_add(1)) == 0 ) ;
 } 
 
 //! Destroy object
@@ -97,7 +102,20 @@ rim::TransactionLockPtr rim::Transaction::lock() {
 
 //! Get expired state
 bool rim::Transaction::expired() { 
-   return (iter_ == NULL || done_); 
+   return (iter_ == NULL || done_ || std::chrono::steady_clock::now() >= endTime_); 
+}
+
+//! Get the deadline
+std::chrono::steady_clock::time_point rim::Transaction::deadline() {
+   return endTime_;
+}
+
+//! Get the time remaining before the deadline
+uint64_t rim::Transaction::remaining() {
+   std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+   if ( now >= endTime_ ) return 0;
+   return std::chrono::duration_cast<std::chrono::microseconds>(endTime_ - now).count();
 }
 
 //! Get id
@@ -112,30 +130,48 @@ uint32_t rim::Transaction::size() { return size_; }
 //! Get type
 uint32_t rim::Transaction::type() { return type_; }
 
+//! Get priority
+uint32_t rim::Transaction::priority() { return priority_; }
+
 //! Complete transaction with passed error, lock must be held
 void rim::Transaction::done(uint32_t error) {
-   error_ = error;
-   done_  = true;
+   {
+      std::lock_guard<std::mutex> lock(condMtx_);
+
+      // Already timed out by the waiter
+      if ( done_ ) return;
+
+      error_    = error;
+      done_     = true;
+      doneTime_ = std::chrono::steady_clock::now();
+
+      if ( notify_ ) notify_(id_);
+   }
    cond_.notify_all();
 }
 
 //! Wait for the transaction to complete
 uint32_t rim::Transaction::wait() {
-   struct timeval currTime;
-
-   std::unique_lock<std::mutex> lock(lock_);
+   uint32_t ret;
 
-   while (! done_) {
+   {
+      std::unique_lock<std::mutex> lock(condMtx_);
 
-      // Timeout?
-      gettimeofday(&currTime,NULL);
-      if ( endTime_.tv_sec  != 0 && endTime_.tv_usec != 0 && 
-           timercmp(&currTime,&(endTime_),>) ) {
+      while ( (! done_) && std::chrono::steady_clock::now() < endTime_ ) 
+         cond_.wait_until(lock,endTime_);
+   }
 
-         done_  = true;
-         error_ = rim::TimeoutError;
+   // Expire under the transaction lock so that a slave currently holding
+   // the lock completes its update before the data buffer is released
+   std::lock_guard<std::mutex> lock(lock_);
+   {
+      std::lock_guard<std::mutex> clock(condMtx_);
+      if ( ! done_ ) {
+         error_    = rim::TimeoutError;
+         done_     = true;
+         doneTime_ = std::chrono::steady_clock::now();
       }
-      else cond_.wait_for(lock,std::chrono::microseconds(1000));
+      ret = error_;
    }
 
    // Reset
@@ -148,18 +184,30 @@ uint32_t rim::Transaction::wait() {
    iter_    = NULL;
    pyValid_ = false;
 
-   return (error_);
+   return (ret);
 }
 
-//! Refresh the timer
-void rim::Transaction::refreshTimer(rim::TransactionPtr ref) {
-   struct timeval currTime;
-   gettimeofday(&currTime,NULL);
+//! Set completion notifier
+void rim::Transaction::setNotify(std::function<void(uint32_t)> notify) {
+   std::lock_guard<std::mutex> lock(condMtx_);
+   notify_ = notify;
+}
+
+//! Set the deadline
+void rim::Transaction::setDeadline(std::chrono::steady_clock::time_point deadline) {
+   endTime_ = deadline;
+}
+
+//! Time out the transaction if its deadline has passed
+bool rim::Transaction::expire() {
    std::lock_guard<std::mutex> lock(lock_);
+   std::lock_guard<std::mutex> clock(condMtx_);
 
-   // Refresh if start time is later then the reference
-   if ( ref == NULL || timercmp(&startTime_,&(ref->startTime_),>=) )
-      timeradd(&currTime,&timeout_,&endTime_);
+   if ( (! done_) && (doneTime_ = std::chrono::steady_clock::now()) >= endTime_ ) {
+      error_ = rim::TimeoutError;
+      done_  = true;
+   }
+   return done_;
 }
 
 //! start iterator, caller must lock around access
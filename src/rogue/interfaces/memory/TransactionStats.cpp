@@ -0,0 +1,162 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title      : Memory Transaction Statistics
+ * ----------------------------------------------------------------------------
+ * File       : TransactionStats.cpp
+ * Created    : 2018-03-19
+ * ----------------------------------------------------------------------------
+ * Description:
+ * Latency, throughput and error statistics for memory transactions serviced 
+ * by a Slave device.
+ * ----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+#include <rogue/interfaces/memory/TransactionStats.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/GilRelease.h>
+#include <cstring>
+
+namespace rim = rogue::interfaces::memory;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+// Registry
+std::map<uint32_t, rim::TransactionStatsPtr> rim::TransactionStats::registry_;
+std::mutex rim::TransactionStats::regMtx_;
+std::atomic<uint64_t> rim::TransactionStats::regEpoch_(1);
+
+//! Get the statistics object for a Slave ID, creating it if needed
+rim::TransactionStatsPtr rim::TransactionStats::get(uint32_t id) {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(regMtx_);
+
+   rim::TransactionStatsPtr & ret = registry_[id];
+
+   if ( ! ret ) {
+      ret = std::make_shared<rim::TransactionStats>(id);
+      regEpoch_++;
+   }
+   return(ret);
+}
+
+//! Get the statistics object for a Slave ID if it exists
+rim::TransactionStatsPtr rim::TransactionStats::find(uint32_t id) {
+   std::map<uint32_t, rim::TransactionStatsPtr>::iterator it;
+
+   std::lock_guard<std::mutex> lock(regMtx_);
+
+   if ( (it = registry_.find(id)) == registry_.end() ) return(rim::TransactionStatsPtr());
+   else return(it->second);
+}
+
+//! Get the registry change count
+uint64_t rim::TransactionStats::epoch() {
+   return(regEpoch_.load());
+}
+
+void rim::TransactionStats::setup_python() {
+#ifndef NO_PYTHON
+   bp::class_<rim::TransactionStats, rim::TransactionStatsPtr, boost::noncopyable>("TransactionStats",bp::no_init)
+      .def("get",       &rim::TransactionStats::get)
+      .staticmethod("get")
+      .def("setEnable", &rim::TransactionStats::setEnable)
+      .def("getEnable", &rim::TransactionStats::getEnable)
+      .def("reset",     &rim::TransactionStats::reset)
+      .def("getStats",  &rim::TransactionStats::getStatsPy)
+   ;
+#endif
+}
+
+//! Create a statistics object
+rim::TransactionStats::TransactionStats(uint32_t id) {
+   id_     = id;
+   enable_ = false;
+   std::memset(stats_,0,sizeof(stats_));
+}
+
+//! Enable or disable recording
+void rim::TransactionStats::setEnable(bool enable) {
+   enable_ = enable;
+}
+
+//! Get enable state
+bool rim::TransactionStats::getEnable() {
+   return(enable_.load());
+}
+
+//! Clear all statistics
+void rim::TransactionStats::reset() {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(statMtx_);
+   std::memset(stats_,0,sizeof(stats_));
+}
+
+//! Record a completed transaction
+void rim::TransactionStats::record(uint32_t type, uint32_t size, uint32_t error, uint64_t latency) {
+   uint32_t bin;
+
+   if ( (! enable_) || type < rim::Read || type > rim::Verify ) return;
+
+   // Bin N holds latencies below 2^N us
+   for (bin=0; bin < (HistBins-1) && (latency >> bin) != 0; bin++);
+
+   std::lock_guard<std::mutex> lock(statMtx_);
+   TypeStats & s = stats_[type-rim::Read];
+
+   s.count++;
+   s.hist[bin]++;
+   s.totalUs += latency;
+   if ( latency > s.maxUs ) s.maxUs = latency;
+
+   if ( error == rim::TimeoutError ) s.timeouts++;
+   else if ( error != 0 ) s.errors++;
+   else s.bytes += size;
+}
+
+#ifndef NO_PYTHON
+
+//! Get statistics as a dictionary
+bp::dict rim::TransactionStats::getStatsPy() {
+   const char * names[4] = {"Read","Write","Post","Verify"};
+   TypeStats copy[4];
+   bp::dict ret;
+   uint32_t x;
+   uint32_t y;
+
+   {
+      rogue::GilRelease noGil;
+      std::lock_guard<std::mutex> lock(statMtx_);
+      std::memcpy(copy,stats_,sizeof(stats_));
+   }
+
+   for (x=0; x < 4; x++) {
+      bp::dict d;
+      bp::list hist;
+
+      for (y=0; y < HistBins; y++) hist.append(copy[x].hist[y]);
+
+      d["count"]    = copy[x].count;
+      d["bytes"]    = copy[x].bytes;
+      d["errors"]   = copy[x].errors;
+      d["timeouts"] = copy[x].timeouts;
+      d["meanUs"]   = (copy[x].count == 0) ? 0.0 : ((double)copy[x].totalUs / (double)copy[x].count);
+      d["maxUs"]    = copy[x].maxUs;
+      d["hist"]     = hist;
+
+      ret[names[x]] = d;
+   }
+   return(ret);
+}
+
+#endif
+
@@ -22,11 +22,21 @@
 #include <rogue/interfaces/memory/Slave.h>
 #include <rogue/interfaces/memory/Master.h>
 #include <rogue/interfaces/memory/Hub.h>
+#include <rogue/interfaces/memory/CoalesceHub.h>
+#include <rogue/interfaces/memory/CacheHub.h>
+#include <rogue/interfaces/memory/PriorityHub.h>
+#include <rogue/interfaces/memory/ArbiterHub.h>
+#include <rogue/interfaces/memory/Block.h>
+#include <rogue/interfaces/memory/Emulate.h>
+#include <rogue/interfaces/memory/Poller.h>
 #include <rogue/interfaces/memory/Constants.h>
 #include <rogue/interfaces/memory/Transaction.h>
 #include <rogue/interfaces/memory/TransactionLock.h>
+#include <rogue/interfaces/memory/TransactionStats.h>
 #include <rogue/interfaces/memory/TcpClient.h>
 #include <rogue/interfaces/memory/TcpServer.h>
+#include <rogue/interfaces/memory/TraceHub.h>
+#include <rogue/interfaces/memory/TraceReplay.h>
 #include <boost/python.hpp>
 
 namespace bp  = boost::python;
@@ -59,13 +69,29 @@ void rim::setup_module() {
    bp::scope().attr("Post")   = Post;
    bp::scope().attr("Verify") = Verify;
 
+   // Transaction priority constants
+   bp::scope().attr("PriorityHigh")   = PriorityHigh;
+   bp::scope().attr("PriorityNormal") = PriorityNormal;
+   bp::scope().attr("PriorityLow")    = PriorityLow;
+
    rim::Master::setup_python(); 
    rim::Slave::setup_python(); 
    rim::Hub::setup_python(); 
+   rim::CoalesceHub::setup_python(); 
+   rim::CacheHub::setup_python(); 
+   rim::PriorityHub::setup_python(); 
+   rim::ArbiterHub::setup_python();
+   rim::ArbiterPort::setup_python();
+   rim::Block::setup_python(); 
+   rim::Emulate::setup_python(); 
+   rim::Poller::setup_python(); 
    rim::Transaction::setup_python(); 
    rim::TransactionLock::setup_python(); 
+   rim::TransactionStats::setup_python(); 
    rim::TcpClient::setup_python(); 
    rim::TcpServer::setup_python(); 
+   rim::TraceHub::setup_python();
+   rim::TraceReplay::setup_python();
 
 }
 
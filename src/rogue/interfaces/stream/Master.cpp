@@ -40,6 +40,7 @@ ris::MasterPtr ris::Master::create () {
 //! Creator
 ris::Master::Master() { 
    primary_ = ris::Slave::create();
+   primarySet_ = false;
 }
 
 //! Destructor
@@ -48,7 +49,9 @@ ris::Master::~Master() { }
 //! Set primary slave, used for buffer request forwarding
 void ris::Master::setSlave ( std::shared_ptr<interfaces::stream::Slave> slave ) {
    rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(slaveMtx_);
    primary_ = slave;
+   primarySet_ = true;
 }
 
 //! Add secondary slave
@@ -58,6 +61,13 @@ void ris::Master::addSlave ( ris::SlavePtr slave ) {
    slaves_.push_back(slave);
 }
 
+//! Get the number of attached slaves
+uint32_t ris::Master::slaveCount () {
+   rogue::GilRelease noGil;
+   std::lock_guard<std::mutex> lock(slaveMtx_);
+   return(slaves_.size() + (primarySet_ ? 1 : 0));
+}
+
 //! Request frame from primary slave
 ris::FramePtr ris::Master::reqFrame ( uint32_t size, bool zeroCopyEn ) {
    rogue::GilRelease noGil;
@@ -95,6 +105,7 @@ void ris::Master::setup_python() {
       .def("_addSlave",      &ris::Master::addSlave)
       .def("_reqFrame",      &ris::Master::reqFrame)
       .def("_sendFrame",     &ris::Master::sendFrame)
+      .def("_slaveCount",    &ris::Master::slaveCount)
    ;
 #endif
 }
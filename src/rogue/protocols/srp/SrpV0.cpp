@@ -35,6 +35,7 @@
 #include <rogue/Logging.h>
 #include <rogue/GilRelease.h>
 #include <string.h>
+#include <algorithm>
 
 namespace rps = rogue::protocols::srp;
 namespace rim = rogue::interfaces::memory;
@@ -55,30 +56,45 @@ rps::SrpV0Ptr rps::SrpV0::create () {
 void rps::SrpV0::setup_python() {
 #ifndef NO_PYTHON
 
-   bp::class_<rps::SrpV0, rps::SrpV0Ptr, bp::bases<ris::Master,ris::Slave,rim::Slave>, boost::noncopyable >("SrpV0",bp::init<>());
+   bp::class_<rps::SrpV0, rps::SrpV0Ptr, bp::bases<ris::Master,ris::Slave,rim::Slave>, boost::noncopyable >("SrpV0",bp::init<>())
+      .def("setSplitDepth", &rps::SrpV0::setSplitDepth)
+      .def("getSplitDepth", &rps::SrpV0::getSplitDepth)
+   ;
 #endif
 }
 
 //! Creator with version constant
-rps::SrpV0::SrpV0() : ris::Master(), ris::Slave(), rim::Slave(4,2048) { 
-   log_ = rogue::Logging::create("SrpV0");
+rps::SrpV0::SrpV0() : ris::Master(), ris::Slave(), rim::Slave(4,SplitMax) { 
+   log_   = rogue::Logging::create("SrpV0");
+   depth_ = 8;
 }
 
 //! Deconstructor
 rps::SrpV0::~SrpV0() {}
 
+//! Set the number of requests kept in flight for a split transaction
+void rps::SrpV0::setSplitDepth(uint32_t depth) {
+   depth_ = (depth == 0) ? 1 : depth;
+}
+
+//! Get the number of requests kept in flight for a split transaction
+uint32_t rps::SrpV0::getSplitDepth() {
+   return depth_;
+}
+
 //! Setup header, return frame size
-bool rps::SrpV0::setupHeader(rim::TransactionPtr tran, uint32_t *header, uint32_t &headerLen, uint32_t &frameLen, bool tx) {
+bool rps::SrpV0::setupHeader(uint32_t type, uint32_t id, uint64_t address, uint32_t size,
+                             uint32_t *header, uint32_t &headerLen, uint32_t &frameLen, bool tx) {
    bool doWrite = false;
 
-   header[0] = tran->id();
-   header[1] = (tran->address() >> 2) & 0x3FFFFFFF;
-   header[2] = (tran->size()/4)-1; // reads
+   header[0] = id;
+   header[1] = (address >> 2) & 0x3FFFFFFF;
+   header[2] = (size/4)-1; // reads
 
    // Build header for write
-   if (tran->type() == rim::Write || tran->type() == rim::Post) {
+   if (type == rim::Write || type == rim::Post) {
       header[1] |= 0x40000000;
-      frameLen  = (tran->size() + WrHeadLen + TailLen);
+      frameLen  = (size + WrHeadLen + TailLen);
       headerLen = WrHeadLen;
       doWrite = true;
    }
@@ -87,15 +103,15 @@ bool rps::SrpV0::setupHeader(rim::TransactionPtr tran, uint32_t *header, uint32_
       headerLen = RdHeadLen;
    }
    else {
-      frameLen = (tran->size() + RxHeadLen + TailLen);
+      frameLen = (size + RxHeadLen + TailLen);
       headerLen = RxHeadLen;
    }
 
    return doWrite;
 }
 
-//! Post a transaction
-void rps::SrpV0::doTransaction(rim::TransactionPtr tran) {
+//! Send a request for a section of a transaction, transaction lock must be held
+void rps::SrpV0::sendRequest(rim::TransactionPtr & tran, uint32_t offset, uint32_t size) {
    ris::Frame::iterator fIter;
    rim::Transaction::iterator tIter;
    ris::FramePtr  frame;
@@ -105,54 +121,198 @@ void rps::SrpV0::doTransaction(rim::TransactionPtr tran) {
    uint32_t headerLen;
    bool     doWrite;
 
-   // Size error
-   if ((tran->address() % min()) != 0 ) {
-      tran->done(rim::AddressError);
-      return;
-   }
-
-   // Size error
-   if ((tran->size() % min()) != 0 || tran->size() < min() || tran->size() > max()) {
-      tran->done(rim::SizeError);
-      return;
-   }
-
    // Setup header and frame size
-   doWrite = setupHeader(tran,header,headerLen,frameSize,true);
+   doWrite = setupHeader(tran->type(),tran->id(),tran->address()+offset,size,header,headerLen,frameSize,true);
 
    // Request frame
    frame = reqFrame(frameSize,true);
    frame->setPayload(frameSize);
 
    // Setup iterators
-   rogue::GilRelease noGil;
-   rim::TransactionLockPtr lock = tran->lock();
    fIter = frame->beginWrite();
-   tIter = tran->begin();
+   tIter = tran->begin() + offset;
 
    // Write header
    ris::toFrame(fIter,headerLen,header); 
 
    // Write data
-   if ( doWrite ) ris::toFrame(fIter, tran->size(), tIter);
+   if ( doWrite ) ris::toFrame(fIter, size, tIter);
 
    // Last field is zero
    tail[0] = 0;
    ris::toFrame(fIter,TailLen,tail); 
 
-   if ( tran->type() == rim::Post ) tran->done(0);
-   else addTransaction(tran);
-
    log_->debug("Send frame for id=%i, addr 0x%0.8x. Size=%i, type=%i, doWrite=%i",
-               tran->id(),tran->address(),tran->size(),tran->type(),doWrite);
+               tran->id(),tran->address()+offset,size,tran->type(),doWrite);
    log_->debug("Send frame for id=%i, header: 0x%0.8x 0x%0.8x 0x%0.8x",
                tran->id(),header[0],header[1],header[2]);
 
    sendFrame(frame);
 }
 
+//! Send split requests up to the pipeline depth, transaction lock must be held
+void rps::SrpV0::sendSplit(rim::TransactionPtr & tran) {
+   std::map<uint32_t, Split>::iterator it;
+   uint32_t offset;
+   uint32_t size;
+
+   while (1) {
+      {
+         std::lock_guard<std::mutex> lock(splitMtx_);
+
+         if ( (it = splitMap_.find(tran->id())) == splitMap_.end() ) return;
+
+         Split & s = it->second;
+         if ( s.pending >= depth_ || s.next >= tran->size() ) return;
+
+         offset = s.next;
+         size   = std::min(FrameMax, tran->size() - offset);
+         s.next += size;
+         s.pending++;
+      }
+      sendRequest(tran,offset,size);
+   }
+}
+
+//! Post a transaction
+void rps::SrpV0::doTransaction(rim::TransactionPtr tran) {
+   std::map<uint32_t, Split>::iterator it;
+   uint32_t offset;
+
+   // Size error
+   if ((tran->address() % min()) != 0 ) {
+      tran->done(rim::AddressError);
+      return;
+   }
+
+   // Size error
+   if ((tran->size() % min()) != 0 || tran->size() < min() || tran->size() > max()) {
+      tran->done(rim::SizeError);
+      return;
+   }
+
+   rogue::GilRelease noGil;
+   rim::TransactionLock lock(tran);
+
+   // Single frame
+   if ( tran->size() <= FrameMax ) {
+      if ( tran->type() == rim::Post ) tran->done(0);
+      else addTransaction(tran);
+      sendRequest(tran,0,tran->size());
+   }
+
+   // Posted writes receive no response, send all requests
+   else if ( tran->type() == rim::Post ) {
+      for (offset=0; offset < tran->size(); offset += FrameMax)
+         sendRequest(tran,offset,std::min(FrameMax,tran->size()-offset));
+      tran->done(0);
+   }
+
+   // Split transaction, responses are tracked locally
+   else {
+      {
+         std::lock_guard<std::mutex> slock(splitMtx_);
+
+         // Drop transactions the Master is no longer waiting on
+         for (it = splitMap_.begin(); it != splitMap_.end(); ) {
+            if ( it->second.tran->expired() ) it = splitMap_.erase(it);
+            else ++it;
+         }
+
+         Split & s = splitMap_[tran->id()];
+         s.tran    = tran;
+         s.next    = 0;
+         s.recv    = 0;
+         s.pending = 0;
+      }
+      sendSplit(tran);
+   }
+}
+
+//! Process a response for a split transaction
+void rps::SrpV0::acceptSplit(rim::TransactionPtr & tran, ris::FramePtr & frame, uint32_t *header, uint32_t fSize) {
+   std::map<uint32_t, Split>::iterator it;
+   ris::Frame::iterator fIter;
+   rim::Transaction::iterator tIter;
+   uint32_t expHeader[MaxHeadLen/4];
+   uint32_t expHeadLen;
+   uint32_t expFrameLen;
+   uint32_t tail[TailLen/4];
+   uint32_t offset;
+   uint32_t size;
+   uint32_t error;
+   bool     doWrite;
+   bool     last;
+
+   rim::TransactionLock lock(tran);
+
+   // Transaction expired
+   if ( tran->expired() ) {
+      log_->warning("Transaction expired. Id=%i",tran->id());
+      std::lock_guard<std::mutex> slock(splitMtx_);
+      splitMap_.erase(tran->id());
+      return;
+   }
+
+   // Locate the request within the transaction, address field holds 32-bit word address
+   offset = ((header[1] & 0x3FFFFFFF) << 2) - (uint32_t)tran->address();
+   error  = 0;
+
+   if ( offset >= tran->size() || (offset % FrameMax) != 0 ) {
+      log_->warning("Bad header for %i",tran->id());
+      return;
+   }
+   size = std::min(FrameMax, tran->size() - offset);
+
+   doWrite = setupHeader(tran->type(),tran->id(),tran->address()+offset,size,expHeader,expHeadLen,expFrameLen,false);
+
+   // Check frame size
+   if ( fSize != expFrameLen ) {
+      log_->warning("Bad receive length for %i exp=%i, got=%i",tran->id(),expFrameLen,fSize);
+      return;
+   }
+
+   // Check header
+   if ( memcmp(header,expHeader,RxHeadLen) != 0 ) {
+     log_->warning("Bad header for %i",tran->id());
+     return;
+   }
+
+   // Read tail error value
+   fIter = frame->endRead()-TailLen;
+   ris::fromFrame(fIter,TailLen,tail);
+   if ( tail[0] != 0 ) {
+      if ( tail[0] & 0x20000 ) error = rim::BusTimeout;
+      else if ( tail[0] & 0x10000 ) error = rim::BusFail;
+      else error = tail[0];
+      log_->warning("Error detected for ID id=%i, tail=0x%0.8x",tran->id(),tail[0]);
+   }
+
+   // Copy data if read
+   else if ( ! doWrite ) {
+      fIter = frame->beginRead() + RxHeadLen;
+      tIter = tran->begin() + offset;
+      ris::fromFrame(fIter, size, tIter);
+   }
+
+   {
+      std::lock_guard<std::mutex> slock(splitMtx_);
+      if ( (it = splitMap_.find(tran->id())) == splitMap_.end() ) return;
+
+      it->second.pending--;
+      it->second.recv += size;
+      last = (error != 0 || it->second.recv >= tran->size());
+
+      if ( last ) splitMap_.erase(it);
+   }
+
+   if ( last ) tran->done(error);
+   else sendSplit(tran);
+}
+
 //! Accept a frame from master
 void rps::SrpV0::acceptFrame ( ris::FramePtr frame ) {
+   std::map<uint32_t, Split>::iterator it;
    ris::Frame::iterator fIter;
    rim::Transaction::iterator tIter;
    rim::TransactionPtr tran;
@@ -185,6 +345,17 @@ void rps::SrpV0::acceptFrame ( ris::FramePtr frame ) {
    log_->debug("Got frame id=%i header: 0x%0.8x 0x%0.8x 0x%0.8x", 
                id, header[0],header[1],header[2]);
 
+   // Split transaction
+   {
+      std::lock_guard<std::mutex> slock(splitMtx_);
+      if ( (it = splitMap_.find(id)) != splitMap_.end() ) tran = it->second.tran;
+   }
+
+   if ( tran ) {
+      acceptSplit(tran,frame,header,fSize);
+      return;
+   }
+
    // Find Transaction
    if ( (tran = getTransaction(id)) == NULL ) {
      log_->warning("Invalid ID frame for id=%i",id);
@@ -192,7 +363,7 @@ void rps::SrpV0::acceptFrame ( ris::FramePtr frame ) {
    }
 
    // Setup transaction iterator
-   rim::TransactionLockPtr lock = tran->lock();
+   rim::TransactionLock lock(tran);
 
    // Transaction expired
    if ( tran->expired() ) {
@@ -202,7 +373,7 @@ void rps::SrpV0::acceptFrame ( ris::FramePtr frame ) {
    tIter = tran->begin();
 
    // Setup header and frame size
-   doWrite = setupHeader(tran,expHeader,expHeadLen,expFrameLen,false);
+   doWrite = setupHeader(tran->type(),tran->id(),tran->address(),tran->size(),expHeader,expHeadLen,expFrameLen,false);
 
    // Check frame size
    if ( fSize != expFrameLen ) {
@@ -236,4 +407,3 @@ void rps::SrpV0::acceptFrame ( ris::FramePtr frame ) {
    // Done
    tran->done(0);
 }
-
@@ -35,6 +35,8 @@
 #include <rogue/Logging.h>
 #include <rogue/GilRelease.h>
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 namespace rps = rogue::protocols::srp;
 namespace rim = rogue::interfaces::memory;
@@ -55,7 +57,17 @@ rps::SrpV3Ptr rps::SrpV3::create () {
 void rps::SrpV3::setup_python() {
 #ifndef NO_PYTHON
 
-   bp::class_<rps::SrpV3, rps::SrpV3Ptr, bp::bases<ris::Master,ris::Slave,rim::Slave>,boost::noncopyable >("SrpV3",bp::init<>());
+   bp::class_<rps::SrpV3, rps::SrpV3Ptr, bp::bases<ris::Master,ris::Slave,rim::Slave>,boost::noncopyable >("SrpV3",bp::init<>())
+      .def("setSplitDepth", &rps::SrpV3::setSplitDepth)
+      .def("getSplitDepth", &rps::SrpV3::getSplitDepth)
+      .def("setWindow",        &rps::SrpV3::setWindow)
+      .def("getWindow",        &rps::SrpV3::getWindow)
+      .def("getOutstanding",   &rps::SrpV3::getOutstanding)
+      .def("getQueueDepth",    &rps::SrpV3::getQueueDepth)
+      .def("getMaxQueueDepth", &rps::SrpV3::getMaxQueueDepth)
+      .def("getStallCount",    &rps::SrpV3::getStallCount)
+      .def("resetStats",       &rps::SrpV3::resetStats)
+   ;
 
    bp::implicitly_convertible<rps::SrpV3Ptr, ris::MasterPtr>();
    bp::implicitly_convertible<rps::SrpV3Ptr, ris::SlavePtr>();
@@ -64,22 +76,88 @@ void rps::SrpV3::setup_python() {
 }
 
 //! Creator with version constant
-rps::SrpV3::SrpV3() : ris::Master(), ris::Slave(), rim::Slave(4,4096) { 
-   log_ = rogue::Logging::create("SrpV3");
+rps::SrpV3::SrpV3() : ris::Master(), ris::Slave(), rim::Slave(4,SplitMax) { 
+   log_   = rogue::Logging::create("SrpV3");
+   depth_ = 8;
+
+   window_      = 0;
+   outstanding_ = 0;
+   stalls_      = 0;
+   maxQueue_    = 0;
 }
 
 //! Deconstructor
-rps::SrpV3::~SrpV3() {}
+rps::SrpV3::~SrpV3() {
+   stopWheel();
+}
+
+//! Set the number of requests kept in flight for a split transaction
+void rps::SrpV3::setSplitDepth(uint32_t depth) {
+   depth_ = (depth == 0) ? 1 : depth;
+}
+
+//! Get the number of requests kept in flight for a split transaction
+uint32_t rps::SrpV3::getSplitDepth() {
+   return depth_;
+}
+
+//! Set the outstanding request window
+void rps::SrpV3::setWindow(uint32_t window) {
+   rogue::GilRelease noGil;
+   {
+      std::lock_guard<std::mutex> lock(winMtx_);
+      window_ = window;
+   }
+   drainQueue();
+}
+
+//! Get the outstanding request window
+uint32_t rps::SrpV3::getWindow() {
+   std::lock_guard<std::mutex> lock(winMtx_);
+   return window_;
+}
+
+//! Get the number of requests in flight
+uint32_t rps::SrpV3::getOutstanding() {
+   std::lock_guard<std::mutex> lock(winMtx_);
+   return outstanding_;
+}
+
+//! Get the number of requests waiting for a credit
+uint32_t rps::SrpV3::getQueueDepth() {
+   std::lock_guard<std::mutex> lock(winMtx_);
+   return queue_.size();
+}
+
+//! Get the largest number of requests which have waited for a credit
+uint32_t rps::SrpV3::getMaxQueueDepth() {
+   std::lock_guard<std::mutex> lock(winMtx_);
+   return maxQueue_;
+}
+
+//! Get the number of requests which have waited for a credit
+uint64_t rps::SrpV3::getStallCount() {
+   std::lock_guard<std::mutex> lock(winMtx_);
+   return stalls_;
+}
+
+//! Reset the queue statistics
+void rps::SrpV3::resetStats() {
+   std::lock_guard<std::mutex> lock(winMtx_);
+   stalls_   = 0;
+   maxQueue_ = queue_.size();
+}
 
 //! Setup header, return frame size
-bool rps::SrpV3::setupHeader(rim::TransactionPtr tran, uint32_t *header, uint32_t &frameLen, bool tx) {
+bool rps::SrpV3::setupHeader(uint32_t type, uint32_t id, uint64_t address, uint32_t size,
+                             uint32_t *header, uint32_t &frameLen, bool tx) {
    bool doWrite = true;
 
    // Bits 7:0 of first 32-bit word are version
    header[0] = 0x03;
 
    // Bits 9:8: 0x0 = read, 0x1 = write, 0x2 = posted write
-   switch ( tran->type() ) {
+   switch ( type ) {
       case rim::Write : header[0] |= 0x100; break;
       case rim::Post  : header[0] |= 0x200; break;
       default: doWrite = false; break; // Read or verify
@@ -92,31 +170,31 @@ bool rps::SrpV3::setupHeader(rim::TransactionPtr tran, uint32_t *header, uint32_
    header[0] |= 0x0A000000;
 
    // Header word 1, transaction ID
-   header[1] = tran->id();
+   header[1] = id;
 
    // Header word 2, lower address
-   header[2] = tran->address() & 0xFFFFFFFF;
+   header[2] = address & 0xFFFFFFFF;
 
    // Header word 3, upper address
-   header[3] = (tran->address() >> 32) & 0xFFFFFFFF;
+   header[3] = (address >> 32) & 0xFFFFFFFF;
 
    // Header word 4, request size
-   header[4] = tran->size()-1;
+   header[4] = size-1;
 
    // Determine frame length
    frameLen = HeadLen;
 
    // Transmit with write data
-   if ( tx && doWrite ) frameLen += tran->size();
+   if ( tx && doWrite ) frameLen += size;
 
    // Receive frames
-   else if ( ! tx ) frameLen += tran->size() + TailLen;
+   else if ( ! tx ) frameLen += size + TailLen;
 
    return doWrite;
 }
 
-//! Post a transaction
-void rps::SrpV3::doTransaction(rim::TransactionPtr tran) {
+//! Send a request for a section of a transaction, transaction lock must be held
+void rps::SrpV3::sendRequest(rim::TransactionPtr & tran, uint32_t offset, uint32_t size) {
    ris::Frame::iterator fIter;
    rim::Transaction::iterator tIter;
    ris::FramePtr  frame;
@@ -124,49 +202,300 @@ void rps::SrpV3::doTransaction(rim::TransactionPtr tran) {
    uint32_t header[HeadLen/4];
    bool doWrite;
 
-   // Size error
-   if ((tran->address() % min()) != 0 ) {
-      tran->done(rim::AddressError);
-      return;
-   }
-
-   // Size error
-   if ((tran->size() % min()) != 0 || tran->size() < min() || tran->size() > max()) {
-      tran->done(rim::SizeError);
-      return;
-   }
-
    // Compute header and frame size
-   doWrite = setupHeader(tran,header,frameSize,true);
+   doWrite = setupHeader(tran->type(),tran->id(),tran->address()+offset,size,header,frameSize,true);
 
    // Request frame
    frame = reqFrame(frameSize,true);
    frame->setPayload(frameSize);
 
    // Setup iterators
-   rogue::GilRelease noGil;
-   rim::TransactionLockPtr lock = tran->lock();
    fIter = frame->beginWrite();
-   tIter = tran->begin();
+   tIter = tran->begin() + offset;
 
    // Write header
    ris::toFrame(fIter,HeadLen,header);
 
    // Write data
-   if ( doWrite ) ris::toFrame(fIter, tran->size(), tIter);
-
-   if ( tran->type() == rim::Post ) tran->done(0);
-   else addTransaction(tran);
+   if ( doWrite ) ris::toFrame(fIter, size, tIter);
 
    log_->debug("Send frame for id=%i, addr 0x%0.8x. Size=%i, type=%i",
-               tran->id(),tran->address(),tran->size(),tran->type());
+               tran->id(),tran->address()+offset,size,tran->type());
    log_->debug("Send frame for id=%i, header: 0x%0.8x 0x%0.8x 0x%0.8x 0x%0.8x 0x%0.8x",
                tran->id(), header[0],header[1],header[2],header[3],header[4]);
    sendFrame(frame);
 }
 
+//! Send a request if a credit is available, otherwise queue it, transaction lock must be held
+void rps::SrpV3::issueRequest(rim::TransactionPtr & tran, uint32_t offset, uint32_t size) {
+   {
+      std::lock_guard<std::mutex> lock(winMtx_);
+
+      // Queue behind earlier requests to keep submission order
+      if ( window_ != 0 && (outstanding_ >= window_ || ! queue_.empty()) ) {
+         queue_.push_back({tran, offset, size});
+         if ( queue_.size() > maxQueue_ ) maxQueue_ = queue_.size();
+         stalls_++;
+         return;
+      }
+      outstanding_++;
+      credits_[tran->id()]++;
+   }
+   sendRequest(tran,offset,size);
+}
+
+//! Return credits held by a transaction
+void rps::SrpV3::releaseCredit(uint32_t id, bool all) {
+   std::map<uint32_t, uint32_t>::iterator it;
+   uint32_t count;
+
+   std::lock_guard<std::mutex> lock(winMtx_);
+
+   // Posted write, unknown id or credits already returned
+   if ( (it = credits_.find(id)) == credits_.end() ) return;
+
+   count = all ? it->second : 1;
+   outstanding_ -= count;
+
+   if ( (it->second -= count) == 0 ) credits_.erase(it);
+}
+
+//! Send queued requests while credits are available, no transaction lock may be held
+void rps::SrpV3::drainQueue() {
+   Request req;
+
+   while (1) {
+      {
+         std::lock_guard<std::mutex> lock(winMtx_);
+
+         if ( queue_.empty() || (window_ != 0 && outstanding_ >= window_) ) return;
+
+         req = std::move(queue_.front());
+         queue_.pop_front();
+
+         if ( req.tran->expired() ) continue;
+
+         outstanding_++;
+         credits_[req.tran->id()]++;
+      }
+
+      rim::TransactionLock lock(req.tran);
+
+      if ( req.tran->expired() ) releaseCredit(req.tran->id(),true);
+      else sendRequest(req.tran,req.offset,req.size);
+   }
+}
+
+//! Drop split transactions which are no longer waited on
+void rps::SrpV3::dropExpired() {
+   std::map<uint32_t, Split>::iterator it;
+   std::vector<uint32_t> ids;
+   std::vector<uint32_t>::iterator iIt;
+
+   {
+      std::lock_guard<std::mutex> lock(splitMtx_);
+
+      for (it = splitMap_.begin(); it != splitMap_.end(); ) {
+         if ( it->second.tran->expired() ) {
+            ids.push_back(it->first);
+            it = splitMap_.erase(it);
+         }
+         else ++it;
+      }
+   }
+
+   if ( ids.empty() ) return;
+
+   for (iIt = ids.begin(); iIt != ids.end(); ++iIt) releaseCredit(*iIt,true);
+   drainQueue();
+}
+
+//! Return the credits of a timed out transaction
+void rps::SrpV3::expireTransaction(rim::TransactionPtr tran) {
+   rim::Slave::expireTransaction(tran);
+   {
+      std::lock_guard<std::mutex> slock(splitMtx_);
+      splitMap_.erase(tran->id());
+   }
+   releaseCredit(tran->id(),true);
+   drainQueue();
+}
+
+//! Send split requests up to the pipeline depth, transaction lock must be held
+void rps::SrpV3::sendSplit(rim::TransactionPtr & tran) {
+   std::map<uint32_t, Split>::iterator it;
+   uint32_t offset;
+   uint32_t size;
+
+   while (1) {
+      {
+         std::lock_guard<std::mutex> lock(splitMtx_);
+
+         if ( (it = splitMap_.find(tran->id())) == splitMap_.end() ) return;
+
+         Split & s = it->second;
+         if ( s.pending >= depth_ || s.next >= tran->size() ) return;
+
+         offset = s.next;
+         size   = std::min(FrameMax, tran->size() - offset);
+         s.next += size;
+         s.pending++;
+      }
+      issueRequest(tran,offset,size);
+   }
+}
+
+//! Post a transaction
+void rps::SrpV3::doTransaction(rim::TransactionPtr tran) {
+   uint32_t offset;
+
+   // Size error
+   if ((tran->address() % min()) != 0 ) {
+      tran->done(rim::AddressError);
+      return;
+   }
+
+   // Size error
+   if ((tran->size() % min()) != 0 || tran->size() < min() || tran->size() > max()) {
+      tran->done(rim::SizeError);
+      return;
+   }
+
+   rogue::GilRelease noGil;
+   dropExpired();
+
+   rim::TransactionLock lock(tran);
+
+   // Deadline passed before the request was sent
+   if ( tran->expired() ) {
+      log_->debug("Dropping expired transaction id=%i",tran->id());
+      return;
+   }
+
+   // Single frame, posted writes receive no response and do not use a credit
+   if ( tran->size() <= FrameMax ) {
+      if ( tran->type() == rim::Post ) {
+         tran->done(0);
+         sendRequest(tran,0,tran->size());
+      }
+      else {
+         addTransaction(tran);
+         issueRequest(tran,0,tran->size());
+      }
+   }
+
+   // Posted writes receive no response, send all requests
+   else if ( tran->type() == rim::Post ) {
+      for (offset=0; offset < tran->size(); offset += FrameMax)
+         sendRequest(tran,offset,std::min(FrameMax,tran->size()-offset));
+      tran->done(0);
+   }
+
+   // Split transaction, responses are tracked locally and the timer wheel returns
+   // the credits of requests lost after a timeout
+   else {
+      {
+         std::lock_guard<std::mutex> slock(splitMtx_);
+         Split & s = splitMap_[tran->id()];
+         s.tran    = tran;
+         s.next    = 0;
+         s.recv    = 0;
+         s.pending = 0;
+      }
+      addTransaction(tran);
+      sendSplit(tran);
+   }
+}
+
+//! Process a response for a split transaction
+void rps::SrpV3::acceptSplit(rim::TransactionPtr & tran, ris::FramePtr & frame,
+                             uint32_t *header, uint32_t *tail, uint32_t fSize) {
+   std::map<uint32_t, Split>::iterator it;
+   ris::Frame::iterator fIter;
+   rim::Transaction::iterator tIter;
+   uint32_t expHeader[HeadLen/4];
+   uint32_t expFrameLen;
+   uint64_t address;
+   uint32_t offset;
+   uint32_t size;
+   uint32_t error;
+   bool     doWrite;
+   bool     last;
+
+   rim::TransactionLock lock(tran);
+
+   // Transaction expired
+   if ( tran->expired() ) {
+      log_->warning("Transaction expired. Id=%i",tran->id());
+      {
+         std::lock_guard<std::mutex> slock(splitMtx_);
+         splitMap_.erase(tran->id());
+      }
+      getTransaction(tran->id());
+      releaseCredit(tran->id(),true);
+      return;
+   }
+
+   // Locate the request within the transaction
+   address = ((uint64_t)header[3] << 32) | header[2];
+   offset  = address - tran->address();
+   size    = header[4] + 1;
+   error   = 0;
+
+   doWrite = setupHeader(tran->type(),tran->id(),address,size,expHeader,expFrameLen,false);
+
+   // Check header
+   if ( address < tran->address() || offset >= tran->size() || (offset % FrameMax) != 0 ||
+        size != std::min(FrameMax, tran->size() - offset) ||
+        (header[0] & 0xFFFFC3FF) != expHeader[0] ) {
+      log_->warning("Bad header for %i",tran->id());
+      error = rim::ProtocolError;
+   }
+
+   // Check tail
+   else if ( tail[0] != 0 ) {
+      if ( tail[0] & 0xFF) error = rim::BusFail | (tail[0] & 0xFF);
+      else if ( tail[0] & 0x100 ) error = rim::BusTimeout;
+      else error = tail[0];
+      log_->warning("Error detected for ID id=%i, tail=0x%0.8x",tran->id(),tail[0]);
+   }
+
+   // Verify frame size
+   else if ( fSize != expFrameLen ) {
+      log_->warning("Size mismatch id=%i. fsize=%i, exp=%i",tran->id(), fSize, expFrameLen);
+      error = rim::ProtocolError;
+   }
+
+   // Copy data if read
+   else if ( ! doWrite ) {
+      fIter = frame->beginRead() + HeadLen;
+      tIter = tran->begin() + offset;
+      ris::fromFrame(fIter, size, tIter);
+   }
+
+   {
+      std::lock_guard<std::mutex> slock(splitMtx_);
+      if ( (it = splitMap_.find(tran->id())) == splitMap_.end() ) return;
+
+      it->second.pending--;
+      it->second.recv += size;
+      last = (error != 0 || it->second.recv >= tran->size());
+
+      if ( last ) splitMap_.erase(it);
+   }
+
+   // Requests still in flight after an error no longer hold credits
+   if ( last ) {
+      getTransaction(tran->id());
+      releaseCredit(tran->id(),true);
+      tran->done(error);
+   }
+   else sendSplit(tran);
+}
+
 //! Accept a frame from master
 void rps::SrpV3::acceptFrame ( ris::FramePtr frame ) {
+   std::map<uint32_t, Split>::iterator it;
    ris::Frame::iterator fIter;
    rim::Transaction::iterator tIter;
    rim::TransactionPtr tran;
@@ -200,6 +529,21 @@ void rps::SrpV3::acceptFrame ( ris::FramePtr frame ) {
    log_->debug("Got frame id=%i, header: 0x%0.8x 0x%0.8x 0x%0.8x 0x%0.8x 0x%0.8x tail: 0x%0.8x",
                id, header[0],header[1],header[2],header[3],header[4],tail[0]);
 
+   // Return the credit and send waiting requests
+   releaseCredit(id,false);
+   drainQueue();
+
+   // Split transaction
+   {
+      std::lock_guard<std::mutex> slock(splitMtx_);
+      if ( (it = splitMap_.find(id)) != splitMap_.end() ) tran = it->second.tran;
+   }
+
+   if ( tran ) {
+      acceptSplit(tran,frame,header,tail,fSize);
+      return;
+   }
+
    // Find Transaction
    if ( (tran = getTransaction(id)) == NULL ) {
      log_->warning("Failed to find transaction id=%i",id);
@@ -207,7 +551,7 @@ void rps::SrpV3::acceptFrame ( ris::FramePtr frame ) {
    }
 
    // Lock transaction
-   rim::TransactionLockPtr lock = tran->lock();
+   rim::TransactionLock lock(tran);
 
    // Transaction expired
    if ( tran->expired() ) {
@@ -217,7 +561,7 @@ void rps::SrpV3::acceptFrame ( ris::FramePtr frame ) {
    tIter = tran->begin();
 
    // Setup expect header and length
-   doWrite = setupHeader(tran,expHeader,expFrameLen,false);
+   doWrite = setupHeader(tran->type(),tran->id(),tran->address(),tran->size(),expHeader,expFrameLen,false);
 
    // Check header
    if ( ((header[0] & 0xFFFFC3FF) != expHeader[0]) ||
@@ -249,4 +593,3 @@ void rps::SrpV3::acceptFrame ( ris::FramePtr frame ) {
 
    tran->done(0);
 }
-
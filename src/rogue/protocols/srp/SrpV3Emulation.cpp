@@ -0,0 +1,158 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Title         : SLAC Register Protocol (SRP) SrpV3 Emulation
+ * ----------------------------------------------------------------------------
+ * File          : SrpV3Emulation.cpp
+ * Created       : 2018-03-20
+ *-----------------------------------------------------------------------------
+ * Description :
+ *    Firmware side of SRP Version 3, serving requests from a memory slave
+ *-----------------------------------------------------------------------------
+ * This file is part of the rogue software platform. It is subject to 
+ * the license terms in the LICENSE.txt file found in the top-level directory 
+ * of this distribution and at: 
+    * https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+ * No part of the rogue software platform, including this file, may be 
+ * copied, modified, propagated, or distributed except according to the terms 
+ * contained in the LICENSE.txt file.
+ *-----------------------------------------------------------------------------
+**/
+#include <stdint.h>
+#include <memory>
+#include <rogue/interfaces/stream/Master.h>
+#include <rogue/interfaces/stream/Slave.h>
+#include <rogue/interfaces/stream/Frame.h>
+#include <rogue/interfaces/stream/FrameLock.h>
+#include <rogue/interfaces/stream/FrameIterator.h>
+#include <rogue/interfaces/memory/Master.h>
+#include <rogue/interfaces/memory/Constants.h>
+#include <rogue/protocols/srp/SrpV3Emulation.h>
+#include <rogue/Logging.h>
+#include <rogue/GilRelease.h>
+#include <string.h>
+#include <inttypes.h>
+
+namespace rps = rogue::protocols::srp;
+namespace rim = rogue::interfaces::memory;
+namespace ris = rogue::interfaces::stream;
+
+#ifndef NO_PYTHON
+#include <boost/python.hpp>
+namespace bp  = boost::python;
+#endif
+
+//! Class creation
+rps::SrpV3EmulationPtr rps::SrpV3Emulation::create () {
+   rps::SrpV3EmulationPtr p = std::make_shared<rps::SrpV3Emulation>();
+   return(p);
+}
+
+//! Setup class in python
+void rps::SrpV3Emulation::setup_python() {
+#ifndef NO_PYTHON
+
+   bp::class_<rps::SrpV3Emulation, rps::SrpV3EmulationPtr, bp::bases<ris::Master,ris::Slave,rim::Master>,boost::noncopyable >("SrpV3Emulation",bp::init<>());
+
+   bp::implicitly_convertible<rps::SrpV3EmulationPtr, ris::MasterPtr>();
+   bp::implicitly_convertible<rps::SrpV3EmulationPtr, ris::SlavePtr>();
+   bp::implicitly_convertible<rps::SrpV3EmulationPtr, rim::MasterPtr>();
+#endif
+}
+
+//! Creator
+rps::SrpV3Emulation::SrpV3Emulation() : ris::Master(), ris::Slave(), rim::Master() { 
+   log_ = rogue::Logging::create("SrpV3Emulation");
+}
+
+//! Deconstructor
+rps::SrpV3Emulation::~SrpV3Emulation() {
+   stopAsync();
+}
+
+//! Send a response frame for a completed request
+void rps::SrpV3Emulation::respond(std::shared_ptr<std::vector<uint8_t> > buff, uint32_t size, uint32_t error) {
+   ris::Frame::iterator fIter;
+   ris::FramePtr frame;
+   uint32_t tail;
+
+   // Bits 7:0 = bus error, bit 8 = bus timeout
+   if ( error == 0 ) tail = 0;
+   else if ( error == rim::BusTimeout || error == rim::TimeoutError ) tail = 0x100;
+   else if ( (error & 0xFF) != 0 ) tail = error & 0xFF;
+   else tail = 0xFF;
+
+   memcpy(buff->data() + HeadLen + size, &tail, TailLen);
+
+   frame = reqFrame(buff->size(),true);
+   frame->setPayload(buff->size());
+
+   fIter = frame->beginWrite();
+   ris::toFrame(fIter, buff->size(), buff->data());
+
+   log_->debug("Send response for id=%i, size=%i, tail=0x%0.8x",
+               ((uint32_t *)buff->data())[1], size, tail);
+   sendFrame(frame);
+}
+
+//! Accept a request frame
+void rps::SrpV3Emulation::acceptFrame ( ris::FramePtr frame ) {
+   std::shared_ptr<std::vector<uint8_t> > buff;
+   ris::Frame::iterator fIter;
+   uint32_t header[HeadLen/4];
+   uint64_t address;
+   uint32_t fSize;
+   uint32_t size;
+   uint32_t type;
+
+   rogue::GilRelease noGil;
+   ris::FrameLockPtr frLock = frame->lock();
+
+   // Check frame size
+   if ( (fSize = frame->getPayload()) < HeadLen ) {
+      log_->warning("Got undersize frame size = %i",fSize);
+      return;
+   }
+
+   // Get the header
+   fIter = frame->beginRead();
+   ris::fromFrame(fIter,HeadLen,header);
+
+   if ( (header[0] & 0xFF) != 0x03 ) {
+      log_->warning("Bad version in header 0x%0.8x",header[0]);
+      return;
+   }
+
+   // Bits 9:8: 0x0 = read, 0x1 = write, 0x2 = posted write
+   switch ( (header[0] >> 8) & 0x3 ) {
+      case 0x0 : type = rim::Read;  break;
+      case 0x1 : type = rim::Write; break;
+      case 0x2 : type = rim::Post;  break;
+      default: 
+         log_->warning("Bad opcode in header 0x%0.8x",header[0]);
+         return;
+   }
+
+   address = ((uint64_t)header[3] << 32) | header[2];
+   size    = header[4] + 1;
+
+   // Write requests carry the data, read requests are header only
+   if ( fSize != ((type == rim::Read) ? HeadLen : (HeadLen + size)) ) {
+      log_->warning("Bad request size for id=%i. fsize=%i, size=%i",header[1],fSize,size);
+      return;
+   }
+
+   // Response carries the header, data and tail
+   buff = std::make_shared<std::vector<uint8_t> >(HeadLen + size + TailLen);
+   memcpy(buff->data(), header, HeadLen);
+   if ( type != rim::Read ) ris::fromFrame(fIter, size, buff->data() + HeadLen);
+
+   log_->debug("Got request id=%i, addr 0x%" PRIx64 ", size=%i, type=%i",header[1],address,size,type);
+
+   // Posted writes are not answered
+   if ( type == rim::Post )
+      reqTransactionAsync(address, size, buff->data() + HeadLen, type, [buff](uint32_t id, uint32_t error) { });
+   else
+      reqTransactionAsync(address, size, buff->data() + HeadLen, type, 
+            [this, buff, size](uint32_t id, uint32_t error) { respond(buff,size,error); });
+}
+
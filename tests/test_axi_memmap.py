@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : AxiMemMap mapped register test script
+#-----------------------------------------------------------------------------
+# File       : test_axi_memmap.py
+# Created    : 2019-03-04
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to 
+# the license terms in the LICENSE.txt file found in the top-level directory 
+# of this distribution and at: 
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+# No part of the rogue software platform, including this file, may be 
+# copied, modified, propagated, or distributed except according to the terms 
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import struct
+import tempfile
+import pyrogue as pr
+import rogue.hardware.axi
+
+RegSize = 0x10000
+
+class RegTree(pr.Root):
+
+    def __init__(self, path):
+        pr.Root.__init__(self,name='regTree',description="Mapped register tree")
+
+        # Regular file stands in for the register space
+        self.memMap = rogue.hardware.axi.AxiMemMap(path)
+
+        self.add(pr.Device(name='Regs', memBase=self.memMap, offset=0x0, size=RegSize))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=None)
+
+def test_axi_memmap():
+
+    with tempfile.NamedTemporaryFile() as f:
+        f.truncate(RegSize)
+        f.flush()
+
+        with RegTree(f.name) as root:
+
+            if not root.memMap.isMapped():
+                raise AssertionError('File was not mapped')
+
+            # Bulk write and read back
+            data = [x * 0x01010101 for x in range(1024)]
+            root.Regs._rawWrite(0x1000, data)
+            ret = root.Regs._rawRead(0x1000, numWords=len(data))
+
+            if ret != data:
+                raise AssertionError('Read back mismatch')
+
+            # Writes land in the backing file
+            f.seek(0x1000 + 4 * 5)
+            if struct.unpack('<I',f.read(4))[0] != data[5]:
+                raise AssertionError('Backing file mismatch')
+
+if __name__ == "__main__":
+    test_axi_memmap()
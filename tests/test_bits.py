@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory Master bit helper test script
+#-----------------------------------------------------------------------------
+# File       : test_bits.py
+# Created    : 2019-03-06
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to 
+# the license terms in the LICENSE.txt file found in the top-level directory 
+# of this distribution and at: 
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+# No part of the rogue software platform, including this file, may be 
+# copied, modified, propagated, or distributed except according to the terms 
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import random
+import rogue.interfaces.memory as rim
+
+# Long enough to exercise the 64 and 128 bit steps
+BufSize = 64
+
+def toInt(ba):
+    return int.from_bytes(ba, 'little')
+
+def clearRange(ba, lsb, size):
+    """Clear a bit range, the reference copy ORs bits into the destination"""
+    val = toInt(ba) & ~(((1 << size) - 1) << lsb)
+    return bytearray(val.to_bytes(len(ba), 'little'))
+
+def rand():
+    return bytearray(random.getrandbits(BufSize * 8).to_bytes(BufSize, 'little'))
+
+# The original bit at a time implementations (_copyBitsRef, _setBitsRef, _anyBitsRef)
+# are the oracle, every bit alignment pair is checked against every size
+def test_copy_bits():
+    random.seed(1)
+
+    for srcLsb in range(16):
+        for dstLsb in range(16):
+            for size in range(0, BufSize * 8 - 16):
+                src = rand()
+                dst = rand()
+                exp = clearRange(dst, dstLsb, size)
+
+                rim.Master._copyBitsRef(exp, dstLsb, src, srcLsb, size)
+                rim.Master._copyBits(dst, dstLsb, src, srcLsb, size)
+
+                if dst != exp:
+                    raise AssertionError(f'copyBits mismatch srcLsb={srcLsb} dstLsb={dstLsb} size={size}')
+
+def test_set_any_bits():
+    random.seed(2)
+
+    for lsb in range(16):
+        for size in range(0, BufSize * 8 - 16):
+            dst = rand()
+            exp = bytearray(dst)
+
+            rim.Master._setBitsRef(exp, lsb, size)
+            rim.Master._setBits(dst, lsb, size)
+
+            if dst != exp:
+                raise AssertionError(f'setBits mismatch lsb={lsb} size={size}')
+
+            # Range is empty or holds a single set bit, surrounding bits are random
+            rng = (((1 << size) - 1) << lsb)
+            val = toInt(rand()) & ~rng
+            if size > 0 and random.getrandbits(1):
+                val |= 1 << (lsb + random.randrange(size))
+            src = bytearray(val.to_bytes(BufSize, 'little'))
+
+            if rim.Master._anyBits(src, lsb, size) != rim.Master._anyBitsRef(src, lsb, size):
+                raise AssertionError(f'anyBits mismatch lsb={lsb} size={size}')
+
+if __name__ == "__main__":
+    test_copy_bits()
+    test_set_any_bits()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory block value test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_block.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import pyrogue as pr
+import pyrogue.interfaces.simulation
+import rogue
+
+class BlockTree(pr.Root):
+
+    def __init__(self):
+        pr.Root.__init__(self,name='blockTree',description="Block value tree")
+
+        self.mem = pyrogue.interfaces.simulation.MemEmulate()
+
+        self.add(pr.Device(name='Dev', memBase=self.mem, offset=0x0, size=0x1000))
+
+        self.Dev.add(pr.RemoteVariable(name='UInt12', offset=0x0, bitSize=12, bitOffset=4, base=pr.UInt, mode='RW'))
+        self.Dev.add(pr.RemoteVariable(name='Int4',   offset=0x4, bitSize=4,  bitOffset=0, base=pr.Int,  mode='RW'))
+        self.Dev.add(pr.RemoteVariable(name='Int8',   offset=0x4, bitSize=8,  bitOffset=8, base=pr.Int,  mode='RW'))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=None)
+
+def expectError(var, value):
+    try:
+        var._block.set(var, value)
+    except (rogue.GeneralError, pr.MemoryError):
+        return
+    raise AssertionError('No error setting {} to {}'.format(var.path,value))
+
+def test_memory_block():
+
+    with BlockTree() as root:
+
+        # Values in range round trip through the native block
+        for var, value in [(root.Dev.UInt12, 0xFFF), (root.Dev.Int4, -8), (root.Dev.Int4, 7),
+                           (root.Dev.Int8, -128), (root.Dev.Int8, 127)]:
+            var.set(value)
+            if var.get() != value:
+                raise AssertionError('{} read {} after writing {}'.format(var.path,var.get(),value))
+
+        # Values outside of the field are rejected instead of truncated
+        expectError(root.Dev.UInt12, 0x1000)
+        expectError(root.Dev.Int4,   8)
+        expectError(root.Dev.Int4,   15)
+        expectError(root.Dev.Int8,   255)
+        expectError(root.Dev.Int8,   -129)
+
+        if root.Dev.UInt12.get() != 0xFFF or root.Dev.Int4.get() != 7 or root.Dev.Int8.get() != 127:
+            raise AssertionError('Rejected value was staged')
+
+if __name__ == "__main__":
+    test_memory_block()
@@ -0,0 +1,326 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory hub test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_hubs.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import time
+import pyrogue as pr
+import rogue.interfaces.memory as rim
+
+class MemRecord(rim.Slave):
+    """
+    Memory space which records the transactions it receives. With hold set
+    transactions are kept until release() is called.
+    """
+
+    def __init__(self, *, minWidth=4, maxSize=1024):
+        rim.Slave.__init__(self,minWidth,maxSize)
+        self.data = bytearray(0x1000)
+        self.log  = []
+        self.hold = False
+        self.held = []
+
+    def _doTransaction(self,transaction):
+        self.log.append((transaction.address(),transaction.size(),transaction.type()))
+
+        if self.hold:
+            self.held.append(transaction)
+        else:
+            self._complete(transaction)
+
+    def release(self):
+        """Complete the oldest held transaction"""
+        transaction = self.held.pop(0)
+        with transaction.lock():
+            self._complete(transaction)
+        time.sleep(0.05)
+
+    def _complete(self,transaction):
+        address = transaction.address()
+        size    = transaction.size()
+        type    = transaction.type()
+
+        if type == rim.Write or type == rim.Post:
+            ba = bytearray(size)
+            transaction.getData(ba,0)
+            self.data[address:address+size] = ba
+        else:
+            transaction.setData(self.data[address:address+size],0)
+
+        transaction.done(0)
+
+def request(mast, reqs):
+    """Issue a list of (address, buffer, type) requests and return the ids"""
+    return mast._reqTransactions([(a, b, len(b), 0, t) for a,b,t in reqs])
+
+def test_coalesce_hub():
+    rec = MemRecord()
+    hub = rim.CoalesceHub(0,0,8)
+    pr.busConnect(hub,rec)
+
+    mast = rim.Master()
+    mast._setSlave(hub)
+
+    # Contiguous writes are merged into one
+    wr  = [bytearray([x]*4) for x in range(4)]
+    ids = request(mast,[(4*x, wr[x], rim.Write) for x in range(4)])
+    hub.flush()
+
+    if mast._waitTransactions(ids) != [0]*4:
+        raise AssertionError('Merged write failed')
+
+    if rec.log != [(0x0,16,rim.Write)]:
+        raise AssertionError('Writes not merged: {}'.format(rec.log))
+
+    # Reads are merged across a gap and the data scattered back
+    rec.log = []
+    rd  = [bytearray(4) for x in range(3)]
+    ids = request(mast,[(0x0, rd[0], rim.Read), (0x4, rd[1], rim.Read), (0xC, rd[2], rim.Read)])
+    hub.flush()
+
+    if mast._waitTransactions(ids) != [0]*3:
+        raise AssertionError('Merged read failed')
+
+    if rec.log != [(0x0,16,rim.Read)]:
+        raise AssertionError('Reads not merged: {}'.format(rec.log))
+
+    if rd != [wr[0], wr[1], wr[3]]:
+        raise AssertionError('Read data not scattered: {}'.format(rd))
+
+    # Writes are never reordered, even when they do not merge
+    rec.log = []
+    ids = request(mast,[(0x104, bytearray(4), rim.Write), (0x100, bytearray(4), rim.Write)])
+    hub.flush()
+    mast._waitTransactions(ids)
+
+    if rec.log != [(0x104,4,rim.Write), (0x100,4,rim.Write)]:
+        raise AssertionError('Writes reordered: {}'.format(rec.log))
+
+    # A read queued after a write to the same address sees the write
+    rec.log = []
+    rd  = bytearray(4)
+    ids = request(mast,[(0x200, bytearray([0xAA]*4), rim.Write), (0x200, rd, rim.Read)])
+    hub.flush()
+    mast._waitTransactions(ids)
+
+    if rec.log != [(0x200,4,rim.Write), (0x200,4,rim.Read)] or rd != bytearray([0xAA]*4):
+        raise AssertionError('Read passed write: {}'.format(rec.log))
+
+    # Writes which would need padding are forwarded unmerged
+    rec.log = []
+    ids = request(mast,[(0x300, bytearray(2), rim.Write), (0x302, bytearray(2), rim.Write),
+                        (0x304, bytearray(2), rim.Write)])
+    hub.flush()
+    mast._waitTransactions(ids)
+
+    if rec.log != [(0x300,2,rim.Write), (0x302,2,rim.Write), (0x304,2,rim.Write)]:
+        raise AssertionError('Unaligned writes merged: {}'.format(rec.log))
+
+def test_cache_hub():
+    rec = MemRecord()
+    hub = rim.CacheHub(0,200000)
+    hub.addRange(0x0,0x100)
+    pr.busConnect(hub,rec)
+
+    mast = rim.Master()
+    mast._setSlave(hub)
+
+    def read(address):
+        rd = bytearray(4)
+        if mast._waitTransactions(request(mast,[(address, rd, rim.Read)])) != [0]:
+            raise AssertionError('Read failed')
+        return rd
+
+    rec.data[0x10:0x14] = bytearray([1]*4)
+
+    # First read misses, second is served from the shadow copy
+    if read(0x10) != bytearray([1]*4) or read(0x10) != bytearray([1]*4):
+        raise AssertionError('Read data mismatch')
+
+    if len(rec.log) != 1 or hub.getHits() != 1 or hub.getMisses() != 1:
+        raise AssertionError('Cache hit not served: {}'.format(rec.log))
+
+    # A write is forwarded and invalidates the shadow copy
+    ids = request(mast,[(0x10, bytearray([2]*4), rim.Write)])
+    mast._waitTransactions(ids)
+
+    if read(0x10) != bytearray([2]*4) or len(rec.log) != 3:
+        raise AssertionError('Write did not invalidate: {}'.format(rec.log))
+
+    # A hit returns the shadow copy, a stale entry is read again
+    rec.data[0x10:0x14] = bytearray([3]*4)
+
+    if read(0x10) != bytearray([2]*4):
+        raise AssertionError('Expected shadow data')
+
+    time.sleep(0.3)
+
+    if read(0x10) != bytearray([3]*4):
+        raise AssertionError('Stale data served')
+
+    # Reads outside of the registered ranges are always forwarded
+    count = len(rec.log)
+    read(0x800)
+    read(0x800)
+
+    if len(rec.log) != count + 2:
+        raise AssertionError('Uncached read served from shadow')
+
+def test_priority_hub():
+    rec = MemRecord()
+    rec.hold = True
+    hub = rim.PriorityHub(0,1)
+    pr.busConnect(hub,rec)
+
+    mast = {}
+    for prio in [rim.PriorityHigh, rim.PriorityNormal, rim.PriorityLow]:
+        mast[prio] = rim.Master()
+        mast[prio]._setSlave(hub)
+        mast[prio]._setPriority(prio)
+
+    # First transaction takes the only slot, the rest queue
+    ids = {}
+    for address, prio in [(0x0, rim.PriorityLow), (0x4, rim.PriorityLow),
+                          (0x8, rim.PriorityNormal), (0xC, rim.PriorityHigh)]:
+        ids.setdefault(prio,[]).extend(request(mast[prio],[(address, bytearray(4), rim.Read)]))
+
+    if hub.getOutstanding() != 1 or hub.getQueued(rim.PriorityLow) != 1:
+        raise AssertionError('Depth limit not applied')
+
+    while rec.held:
+        rec.release()
+
+    for prio in ids:
+        if mast[prio]._waitTransactions(ids[prio]) != [0]*len(ids[prio]):
+            raise AssertionError('Transaction failed')
+
+    # Served highest priority first
+    if [x[0] for x in rec.log] != [0x0, 0xC, 0x8, 0x4]:
+        raise AssertionError('Priority order not kept: {}'.format(rec.log))
+
+    # A starving low priority transaction is forwarded ahead of newer high priority work
+    rec.log = []
+    hub.setStarvation(100000)
+    ids = request(mast[rim.PriorityLow],[(0x0, bytearray(4), rim.Read), (0x4, bytearray(4), rim.Read)])
+    time.sleep(0.2)
+    hid = request(mast[rim.PriorityHigh],[(0xC, bytearray(4), rim.Read)])
+
+    while rec.held:
+        rec.release()
+
+    mast[rim.PriorityLow]._waitTransactions(ids)
+    mast[rim.PriorityHigh]._waitTransactions(hid)
+
+    if [x[0] for x in rec.log] != [0x0, 0x4, 0xC]:
+        raise AssertionError('Starving transaction not promoted: {}'.format(rec.log))
+
+    if hub.getStats()[rim.PriorityLow]['promoted'] != 1:
+        raise AssertionError('Promotion not counted: {}'.format(hub.getStats()))
+
+def test_arbiter_hub():
+    rec = MemRecord()
+    rec.hold = True
+    hub = rim.ArbiterHub(0,1)
+    pr.busConnect(hub,rec)
+
+    # Port A forwards two transactions per turn, port B one
+    ports = {'A' : rim.ArbiterPort(hub,2,0), 'B' : rim.ArbiterPort(hub,1,0)}
+    base  = {'A' : 0x0, 'B' : 0x800}
+    mast  = {}
+    ids   = {}
+
+    for p in ports:
+        mast[p] = rim.Master()
+        mast[p]._setSlave(ports[p])
+        ids[p] = request(mast[p],[(base[p] + 4*x, bytearray(4), rim.Read) for x in range(6)])
+
+    if hub.getOutstanding() != 1:
+        raise AssertionError('Depth limit not applied')
+
+    while rec.held:
+        rec.release()
+
+    for p in ports:
+        if mast[p]._waitTransactions(ids[p]) != [0]*6:
+            raise AssertionError('Transaction failed')
+
+    # Weighted round robin while both ports have work, in order within a port
+    order = ''.join('A' if x[0] < 0x800 else 'B' for x in rec.log)
+
+    if order != 'AABAABAABBBB':
+        raise AssertionError('Round robin weights not applied: {}'.format(order))
+
+    for p in ports:
+        if [x[0] for x in rec.log if (x[0] >= 0x800) == (p == 'B')] != [base[p] + 4*x for x in range(6)]:
+            raise AssertionError('Port {} reordered: {}'.format(p,rec.log))
+
+class CountHub(rim.Hub):
+    """
+    Hub with a python transaction override, counts the transactions it forwards.
+    """
+
+    def __init__(self, offset):
+        rim.Hub.__init__(self,offset,0,0)
+        self.count = 0
+
+    def _doTransaction(self,transaction):
+        self.count += 1
+        rim.Hub._doTransaction(self,transaction)
+
+def test_hub_chain():
+    rec = MemRecord()
+
+    # Pass-through hubs, python hubs without an override are skipped as well
+    hubs = [rim.Hub(0x100,0,0), pr.Device(name='Dev', offset=0x20, size=0x100), rim.Hub(0x0,0,0)]
+    for x in range(len(hubs) - 1):
+        pr.busConnect(hubs[x],hubs[x+1])
+    pr.busConnect(hubs[-1],rec)
+
+    mast = rim.Master()
+    mast._setSlave(hubs[0])
+
+    if mast._reqMinAccess() != 4 or mast._reqMaxAccess() != 1024:
+        raise AssertionError('Access sizes not resolved through the chain')
+
+    mast._waitTransactions(request(mast,[(0x4, bytearray(4), rim.Write)]))
+
+    if rec.log != [(0x124,4,rim.Write)]:
+        raise AssertionError('Offsets not applied: {}'.format(rec.log))
+
+    # Rewiring the chain is seen by the next transaction
+    rec2 = MemRecord(minWidth=8, maxSize=64)
+    pr.busConnect(hubs[-1],rec2)
+    mast._waitTransactions(request(mast,[(0x8, bytearray(8), rim.Write)]))
+
+    if len(rec.log) != 1 or rec2.log != [(0x128,8,rim.Write)]:
+        raise AssertionError('Chain not resolved again after setSlave')
+
+    if mast._reqMinAccess() != 8 or mast._reqMaxAccess() != 64:
+        raise AssertionError('Access sizes not resolved again after setSlave')
+
+    # A python override in the chain is always called
+    cnt = CountHub(0x400)
+    pr.busConnect(hubs[-1],cnt)
+    pr.busConnect(cnt,rec)
+    mast._waitTransactions(request(mast,[(0x0, bytearray(4), rim.Write)]))
+
+    if cnt.count != 1 or rec.log[-1] != (0x520,4,rim.Write):
+        raise AssertionError('Python hub skipped: {}'.format(rec.log))
+
+if __name__ == "__main__":
+    test_coalesce_hub()
+    test_cache_hub()
+    test_priority_hub()
+    test_arbiter_hub()
+    test_hub_chain()
+
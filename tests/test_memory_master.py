@@ -0,0 +1,320 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory master test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_master.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import time
+import threading
+import pyrogue.interfaces.simulation
+import rogue.interfaces.memory as rim
+
+class MemTrack(rim.Slave):
+    """
+    Memory space which tracks the transactions it receives and only
+    completes them when complete() is called.
+    """
+
+    def __init__(self):
+        rim.Slave.__init__(self,4,1024)
+        self.ids = []
+        self.remaining = []
+
+    def _doTransaction(self,transaction):
+        self._addTransaction(transaction)
+        self.ids.append(transaction.id())
+        self.remaining.append(transaction.remaining())
+
+    def complete(self, id, error=0):
+        """Complete a tracked transaction, returns False if it is no longer tracked"""
+        transaction = self._getTransaction(id)
+        if transaction is None:
+            return False
+
+        with transaction.lock():
+            transaction.done(error)
+        return True
+
+def test_transaction_wait():
+    mem = MemTrack()
+
+    mast = rim.Master()
+    mast._setSlave(mem)
+    mast._setTimeout(1000000)
+
+    # A waiter wakes as soon as the transaction completes from another thread
+    mast._reqTransaction(0x0,bytearray(4),4,0,rim.Read)
+    timer = threading.Timer(0.1, lambda: mem.complete(mem.ids[-1]))
+    timer.start()
+
+    start = time.time()
+    mast._waitTransaction(0)
+    elapsed = time.time() - start
+
+    if mast._getError() != 0 or elapsed > 0.15:
+        raise AssertionError('Wait not woken on completion: error={} elapsed={}'.format(mast._getError(),elapsed))
+
+    # A transaction that never completes times out at its deadline
+    mast._setTimeout(100000)
+    mast._reqTransaction(0x0,bytearray(4),4,0,rim.Read)
+
+    start = time.time()
+    mast._waitTransaction(0)
+    elapsed = time.time() - start
+
+    if mast._getError() != rim.TimeoutError or elapsed > 0.3:
+        raise AssertionError('Wait not timed out: error={} elapsed={}'.format(mast._getError(),elapsed))
+
+    # Many waiters on delayed completions
+    emu = pyrogue.interfaces.simulation.MemEmulate()
+    emu.setLatency(20000)
+    mast._setSlave(emu)
+    mast._setTimeout(1000000)
+    mast._setError(0)
+
+    start = time.time()
+    for x in range(50):
+        mast._reqTransaction(4*x,bytearray(4),4,0,rim.Write)
+    mast._waitTransaction(0)
+
+    if mast._getError() != 0 or (time.time() - start) > 0.2:
+        raise AssertionError('Delayed completions not waited on together')
+
+def test_async():
+    emu = pyrogue.interfaces.simulation.MemEmulate()
+    emu.setLatency(10000)
+
+    mast = rim.Master()
+    mast._setSlave(emu)
+    mast._setTimeout(1000000)
+
+    results = {}
+    done    = threading.Event()
+
+    def callback(id, error):
+        results[id] = error
+        if len(results) == len(ids):
+            done.set()
+
+    # Completions are delivered to the callback, data is in place when it runs
+    wr  = [bytearray([x]*4) for x in range(8)]
+    ids = [mast._reqTransactionAsync(4*x,wr[x],4,0,rim.Write,callback) for x in range(8)]
+
+    if not done.wait(1.0) or results != {id : 0 for id in ids}:
+        raise AssertionError('Async writes not completed: {}'.format(results))
+
+    results.clear()
+    done.clear()
+    rd  = [bytearray(4) for x in range(8)]
+    ids = [mast._reqTransactionAsync(4*x,rd[x],4,0,rim.Read,callback) for x in range(8)]
+
+    if not done.wait(1.0) or rd != wr:
+        raise AssertionError('Async read data mismatch: {}'.format(rd))
+
+    # A transaction which never completes is timed out without a waiter
+    mem = MemTrack()
+    mast._setSlave(mem)
+    mast._setTimeout(100000)
+
+    results.clear()
+    done.clear()
+    ids = [mast._reqTransactionAsync(0x0,bytearray(4),4,0,rim.Read,callback)]
+
+    if not done.wait(0.5) or results != {ids[0] : rim.TimeoutError}:
+        raise AssertionError('Async transaction not timed out: {}'.format(results))
+
+def test_slave_tracking():
+    mem = MemTrack()
+
+    mast = rim.Master()
+    mast._setSlave(mem)
+    mast._setTimeout(1000000)
+
+    # Tracked transactions are found by id in any order
+    ids = mast._reqTransactions([(4*x, bytearray(4), 4, 0, rim.Read) for x in range(500)])
+
+    if mem.ids != ids:
+        raise AssertionError('Slave did not receive all transactions')
+
+    for id in reversed(ids):
+        if not mem.complete(id):
+            raise AssertionError('Transaction {} not tracked'.format(id))
+
+    if mast._waitTransactions(ids) != [0]*len(ids):
+        raise AssertionError('Tracked transactions failed')
+
+    # Completed ids are removed from the table
+    if mem.complete(ids[0]):
+        raise AssertionError('Completed transaction still tracked')
+
+    # The timer wheel expires tracked transactions at their deadline, while
+    # responses to other transactions keep arriving
+    mast._setTimeout(200000)
+    mem.ids = []
+    stuck = mast._reqTransactions([(0x0, bytearray(4), 4, 0, rim.Read)])
+
+    start = time.time()
+    while time.time() - start < 0.4:
+        ids = mast._reqTransactions([(0x4, bytearray(4), 4, 0, rim.Read)])
+        mem.complete(ids[0])
+        mast._waitTransactions(ids)
+        time.sleep(0.02)
+
+    if mem.complete(stuck[0]):
+        raise AssertionError('Expired transaction still tracked')
+
+    if mast._waitTransactions(stuck) != [rim.TimeoutError]:
+        raise AssertionError('Tracked transaction not expired')
+
+class MemKeep(rim.Slave):
+    """
+    Memory space which completes transactions at once and keeps a reference to each.
+    """
+
+    def __init__(self):
+        rim.Slave.__init__(self,4,1024)
+        self.kept = []
+
+    def _doTransaction(self,transaction):
+        self.kept.append((transaction,transaction.id(),transaction.address()))
+        transaction.done(0)
+
+def test_transaction_pool():
+    mem = MemKeep()
+
+    mast = rim.Master()
+    mast._setSlave(mem)
+
+    # Transactions still referenced from python are never recycled
+    for x in range(200):
+        mast._reqTransaction(4*x,bytearray(4),4,0,rim.Write)
+        mast._waitTransaction(0)
+
+    for tran, id, address in mem.kept:
+        if tran.id() != id or tran.address() != address:
+            raise AssertionError('Referenced transaction recycled: id {} -> {}'.format(id,tran.id()))
+
+    # Recycled transactions get new ids, ids are unique across threads
+    emu  = pyrogue.interfaces.simulation.MemEmulate()
+    seen = []
+
+    def worker():
+        m = rim.Master()
+        m._setSlave(emu)
+        ids = []
+        for x in range(500):
+            ids.extend(m._reqTransactions([(0x0, bytearray(4), 4, 0, rim.Write)]))
+            m._waitTransactions(ids[-1:])
+        seen.extend(ids)
+
+    threads = [threading.Thread(target=worker) for x in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    if len(set(seen)) != len(seen) or 0 in seen:
+        raise AssertionError('Transaction ids reused')
+
+def test_bulk():
+    emu = pyrogue.interfaces.simulation.MemEmulate()
+    emu.setLatency(5000)
+
+    mast = rim.Master()
+    mast._setSlave(emu)
+
+    # Bulk writes and reads, errors are returned per transaction in id order
+    wr  = [bytearray([x]*4) for x in range(16)]
+    ids = mast._reqTransactions([(4*x, wr[x], 4, 0, rim.Write) for x in range(16)])
+
+    if len(set(ids)) != 16 or mast._waitTransactions(ids) != [0]*16:
+        raise AssertionError('Bulk write failed')
+
+    rd  = [bytearray(4) for x in range(16)]
+    ids = mast._reqTransactions([(4*x, rd[x], 4, 0, rim.Read) for x in range(16)])
+
+    if mast._waitTransactions(list(reversed(ids))) != [0]*16 or rd != wr:
+        raise AssertionError('Bulk read mismatch')
+
+    # A failing entry does not affect the others, the master error is updated
+    rd  = [bytearray(4) for x in range(3)]
+    ids = mast._reqTransactions([(0x0, rd[0], 4, 0, rim.Read), (0x2, rd[1], 4, 0, rim.Read),
+                                 (0x8, rd[2], 4, 0, rim.Read)])
+
+    if mast._waitTransactions(ids) != [0, rim.AddressError, 0] or rd[0] != wr[0] or rd[2] != wr[2]:
+        raise AssertionError('Bulk error not isolated')
+
+    if mast._getError() != rim.AddressError:
+        raise AssertionError('Master error not updated')
+
+    # Unknown ids return no error
+    if mast._waitTransactions(ids) != [0]*3 or mast._reqTransactions([]) != []:
+        raise AssertionError('Unexpected result for completed or empty requests')
+
+def test_deadline():
+    mem = MemTrack()
+
+    mast = rim.Master()
+    mast._setSlave(mem)
+    mast._setTimeout(500000)
+
+    # The slave sees the time left before the deadline
+    ids = mast._reqTransactions([(0x0, bytearray(4), 4, 0, rim.Read)])
+    mem.complete(ids[0])
+    mast._waitTransactions(ids)
+
+    if not (400000 < mem.remaining[-1] <= 500000):
+        raise AssertionError('Unexpected remaining time: {}'.format(mem.remaining[-1]))
+
+    # The deadline is fixed at request time
+    mast._setTimeout(100000)
+    ids = mast._reqTransactions([(0x0, bytearray(4), 4, 0, rim.Read)])
+    mast._setTimeout(2000000)
+
+    start = time.time()
+    if mast._waitTransactions(ids) != [rim.TimeoutError] or (time.time() - start) > 0.5:
+        raise AssertionError('Deadline extended after request')
+
+    # A transaction which expires while queued in a hub is never forwarded
+    mem.ids = []
+    hub = rim.PriorityHub(0,1)
+    hub._setSlave(mem)
+
+    first = rim.Master()
+    first._setSlave(hub)
+    first._setTimeout(1000000)
+
+    mast._setSlave(hub)
+    mast._setTimeout(100000)
+
+    fid = first._reqTransactions([(0x0, bytearray(4), 4, 0, rim.Read)])
+    ids = mast._reqTransactions([(0x4, bytearray(4), 4, 0, rim.Read)])
+
+    if len(mem.ids) != 1 or mem.remaining[-1] <= 100000:
+        raise AssertionError('Depth limit not applied')
+
+    time.sleep(0.2)
+    mem.complete(mem.ids[0])
+
+    if first._waitTransactions(fid) != [0] or mast._waitTransactions(ids) != [rim.TimeoutError]:
+        raise AssertionError('Unexpected result for queued transactions')
+
+    if len(mem.ids) != 1 or hub.getOutstanding() != 0:
+        raise AssertionError('Expired transaction forwarded: {}'.format(mem.ids))
+
+if __name__ == "__main__":
+    test_transaction_wait()
+    test_async()
+    test_slave_tracking()
+    test_transaction_pool()
+    test_bulk()
+    test_deadline()
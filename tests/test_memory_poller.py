@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory poller test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_poller.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import time
+import pyrogue.interfaces.simulation
+import rogue.interfaces.memory as rim
+
+def test_memory_poller():
+    mem = pyrogue.interfaces.simulation.MemEmulate()
+
+    mast = rim.Master()
+    mast._setSlave(mem)
+
+    block = rim.Block(0x100,4)
+    block._setSlave(mem)
+
+    updates = []
+    poller = rim.Poller(10000)
+    poller.setCallback(lambda u: updates.extend(u))
+    poller.addBlock(block,0.05)
+    poller.start()
+
+    # The first poll is always reported
+    time.sleep(0.3)
+
+    if len(updates) != 1 or updates[0][0]._getOffset() != 0x100 or updates[0][1] != 0:
+        raise AssertionError('First poll not reported: {}'.format(updates))
+
+    # Unchanged data is not reported again, a change is reported once
+    mast._reqTransaction(0x100,bytearray([1,2,3,4]),4,0,rim.Write)
+    mast._waitTransaction(0)
+    time.sleep(0.3)
+
+    if len(updates) != 2:
+        raise AssertionError('Change not reported once: {}'.format(updates))
+
+    time.sleep(0.3)
+
+    if len(updates) != 2:
+        raise AssertionError('Unchanged data reported: {}'.format(updates))
+
+    # A disabled block is not polled
+    poller.setEnable(block,False)
+    mast._reqTransaction(0x100,bytearray([5,6,7,8]),4,0,rim.Write)
+    mast._waitTransaction(0)
+    time.sleep(0.3)
+
+    if len(updates) != 2:
+        raise AssertionError('Disabled block polled: {}'.format(updates))
+
+    # Blocks which are dropped while their poll is in flight are released with the GIL held
+    updates.clear()
+    for x in range(50):
+        tmp = rim.Block(0x200 + 4*x,4)
+        tmp._setSlave(mem)
+        poller.addBlock(tmp,0.01)
+        time.sleep(0.005)
+        poller.removeBlock(tmp)
+        del tmp
+
+    poller.removeBlock(block)
+    poller.stop()
+
+    if poller.getCount() != 0:
+        raise AssertionError('Blocks left in the poller')
+
+if __name__ == "__main__":
+    test_memory_poller()
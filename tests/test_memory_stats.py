@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory transaction statistics test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_stats.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import pyrogue as pr
+import pyrogue.interfaces.simulation
+import rogue.interfaces.memory as rim
+
+class StatsTree(pr.Root):
+
+    def __init__(self):
+        pr.Root.__init__(self,name='statsTree',description="Statistics tree")
+
+        self.mem = pyrogue.interfaces.simulation.MemEmulate()
+
+        self.add(pr.Device(name='Dev', memBase=self.mem, offset=0x0, size=0x1000))
+
+        for i in range(4):
+            self.Dev.add(pr.RemoteVariable(
+                name         = 'Reg{}'.format(i),
+                offset       = 4*i,
+                bitSize      = 32,
+                bitOffset    = 0x00,
+                base         = pr.UInt,
+                mode         = 'RW',
+            ))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=None)
+
+def test_memory_stats():
+
+    with StatsTree() as root:
+        root.setMemoryStats(True)
+        root.getMemoryStats(reset=True)
+
+        # Single, bulk and tree level transactions are all recorded
+        mast = rim.Master()
+        mast._setSlave(root.mem)
+        mast._reqTransaction(0x100,bytearray(4),4,0,rim.Write)
+        mast._waitTransaction(0)
+
+        ids = mast._reqTransactions([(0x100 + 4*x, bytearray(4), 4, 0, rim.Read) for x in range(8)])
+        mast._waitTransactions(ids)
+
+        root.WriteAll()
+        root.ReadAll()
+
+        stats = root.getMemoryStats()['statsTree.Dev']
+
+        if stats['Write']['count'] < 2 or stats['Write']['errors'] != 0:
+            raise AssertionError('Write statistics missing: {}'.format(stats['Write']))
+
+        if stats['Read']['count'] < 9 or stats['Read']['bytes'] < 36:
+            raise AssertionError('Read statistics missing: {}'.format(stats['Read']))
+
+        root.setMemoryStats(False)
+
+if __name__ == "__main__":
+    test_memory_stats()
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory TCP bridge pipelining test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_tcp.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import time
+import pyrogue as pr
+import pyrogue.interfaces.simulation
+import rogue.interfaces.memory as rim
+
+def test_memory_tcp():
+    mem    = pyrogue.interfaces.simulation.MemEmulate()
+    server = rim.TcpServer("127.0.0.1",9040)
+    client = rim.TcpClient("127.0.0.1",9040)
+    pr.busConnect(server,mem)
+
+    mast = rim.Master()
+    mast._setSlave(client)
+    mast._setTimeout(2000000)
+
+    time.sleep(1)
+
+    # Batch of writes and reads kept in flight together
+    wr = [bytearray([x & 0xFF, x >> 8, 0, 0]) for x in range(256)]
+    errors = mast._waitTransactions(mast._reqTransactions([(4*x, wr[x], 4, 0, rim.Write) for x in range(256)]))
+
+    if errors != [0] * 256:
+        raise AssertionError('Write errors: {}'.format(errors))
+
+    rd = [bytearray(4) for x in range(256)]
+    errors = mast._waitTransactions(mast._reqTransactions([(4*x, rd[x], 4, 0, rim.Read) for x in range(256)]))
+
+    if errors != [0] * 256 or rd != wr:
+        raise AssertionError('Pipelined read back mismatch')
+
+    # A transaction waiting for window space completes with a timeout when it expires
+    client.setWindow(1)
+    mem.setLatency(500000)
+    mast._setTimeout(100000)
+
+    start  = time.time()
+    errors = mast._waitTransactions(mast._reqTransactions([(0x0, bytearray(4), 4, 0, rim.Read),
+                                                          (0x4, bytearray(4), 4, 0, rim.Read)]))
+
+    if errors != [rim.TimeoutError] * 2:
+        raise AssertionError('Expected timeouts, got {}'.format(errors))
+
+    if (time.time() - start) > 0.4:
+        raise AssertionError('Timeout took {} seconds'.format(time.time() - start))
+
+if __name__ == "__main__":
+    test_memory_tcp()
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Memory trace record and replay test script
+#-----------------------------------------------------------------------------
+# File       : test_memory_trace.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import os
+import tempfile
+import pyrogue as pr
+import pyrogue.interfaces.simulation
+import rogue.interfaces.memory
+
+class TraceTree(pr.Root):
+
+    def __init__(self):
+        pr.Root.__init__(self,name='traceTree',description="Trace record tree")
+
+        # Sparse memory behind a recording hub
+        self.mem   = pyrogue.interfaces.simulation.MemEmulate()
+        self.trace = rogue.interfaces.memory.TraceHub(0)
+        pr.busConnect(self.trace,self.mem)
+
+        self.add(pr.Device(name='Dev', memBase=self.trace, offset=0x0, size=0x10000))
+
+        for i in range(16):
+            self.Dev.add(pr.RemoteVariable(
+                name         = 'Reg{}'.format(i),
+                offset       = 4*i,
+                bitSize      = 32,
+                bitOffset    = 0x00,
+                base         = pr.UInt,
+                mode         = 'RW',
+            ))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=None)
+
+def test_memory_trace():
+    fname = os.path.join(tempfile.mkdtemp(),'test.trace')
+
+    with TraceTree() as root:
+        root.trace.open(fname)
+
+        for i in range(16):
+            root.Dev.node('Reg{}'.format(i)).set(0x1000 + i)
+
+        for i in range(16):
+            if root.Dev.node('Reg{}'.format(i)).get() != 0x1000 + i:
+                raise AssertionError('Register Mismatch')
+
+        count = root.trace.getCount()
+        root.trace.close()
+
+    if count == 0:
+        raise AssertionError('No transactions recorded')
+
+    # Replay against a fresh memory space
+    mem    = pyrogue.interfaces.simulation.MemEmulate()
+    replay = rogue.interfaces.memory.TraceReplay()
+    pr.busConnect(replay,mem)
+
+    replay.load(fname)
+
+    if replay.getCount() != count:
+        raise AssertionError('Loaded {} of {} transactions'.format(replay.getCount(),count))
+
+    replay.setDepth(1)
+    replay.run(0)
+    stats = replay.getStats()
+
+    if stats['count'] != count or stats['errors'] != 0 or stats['mismatches'] != 0:
+        raise AssertionError('Replay failed: {}'.format(stats))
+
+if __name__ == "__main__":
+    test_memory_trace()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Shadow write test script
+#-----------------------------------------------------------------------------
+# File       : test_shadow_write.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import pyrogue as pr
+import pyrogue.interfaces.simulation
+import rogue.interfaces.memory
+
+class ShadowTree(pr.Root):
+
+    def __init__(self):
+        pr.Root.__init__(self,name='shadowTree',description="Shadow write tree")
+
+        self.mem = pyrogue.interfaces.simulation.MemEmulate()
+
+        self.add(pr.Device(name='Dev', memBase=self.mem, offset=0x0, size=0x1000))
+
+        self.Dev.add(pr.RemoteVariable(
+            name         = 'Reg',
+            offset       = 0x0,
+            bitSize      = 32,
+            bitOffset    = 0x00,
+            base         = pr.UInt,
+            mode         = 'RW',
+        ))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=None)
+
+def test_shadow_write():
+
+    with ShadowTree() as root:
+        root.ShadowWrite.set(True)
+        root.Dev.Reg.set(0x1234)
+
+        # Change the hardware behind the tree
+        mast = rogue.interfaces.memory.Master()
+        mast._setSlave(root.mem)
+        mast._reqTransaction(0x0,bytearray(4),0,0,rogue.interfaces.memory.Write)
+        mast._waitTransaction(0)
+
+        # Staged value matches the shadow, the write is skipped
+        root.Dev.Reg.set(0x1234, write=False)
+        root.WriteAll()
+
+        if root.Dev.Reg.get() != 0:
+            raise AssertionError('Shadow write was not skipped')
+
+        # The read updated the shadow, the write goes out
+        root.Dev.Reg.set(0x1234, write=False)
+        root.WriteAll()
+
+        if root.Dev.Reg.get() != 0x1234:
+            raise AssertionError('Shadow write was skipped')
+
+if __name__ == "__main__":
+    test_shadow_write()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : SRP emulation test script
+#-----------------------------------------------------------------------------
+# File       : test_srp_emulate.py
+# Created    : 2019-03-05
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to 
+# the license terms in the LICENSE.txt file found in the top-level directory 
+# of this distribution and at: 
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html. 
+# No part of the rogue software platform, including this file, may be 
+# copied, modified, propagated, or distributed except according to the terms 
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import time
+import pyrogue as pr
+import pyrogue.interfaces.simulation
+import rogue.protocols.srp
+import rogue.interfaces.memory as rim
+
+class EmuTree(pr.Root):
+
+    def __init__(self):
+        pr.Root.__init__(self,name='emuTree',description="SRP emulation tree")
+
+        # Sparse memory behind an emulated SRP engine
+        self.mem = pyrogue.interfaces.simulation.MemEmulate()
+        self.emu = rogue.protocols.srp.SrpV3Emulation()
+        pr.busConnect(self.emu,self.mem)
+
+        # SRP bridge connected over a stream loopback
+        self.srp = rogue.protocols.srp.SrpV3()
+        self.srp.setWindow(4)
+        pr.streamConnectBiDir(self.srp,self.emu)
+
+        self.add(pr.Device(name='Dev', memBase=self.srp, offset=0x0, size=0x100000))
+
+        self.Dev.add(pr.RemoteVariable(   
+            name         = 'ScratchPad',
+            offset       = 0x04,
+            bitSize      = 32,
+            bitOffset    = 0x00,
+            base         = pr.UInt,
+            mode         = 'RW',
+        ))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=None)
+
+def test_srp_emulate():
+
+    with EmuTree() as root:
+
+        root.Dev.ScratchPad.set(0x12345678)
+
+        if root.Dev.ScratchPad.get() != 0x12345678:
+            raise AssertionError('Scratchpad Mismatch')
+
+        # Larger than one SRP frame, split into pipelined requests
+        data = [x for x in range(8192)]
+        root.Dev._rawWrite(0x10000, data)
+
+        if root.Dev._rawRead(0x10000, numWords=len(data)) != data:
+            raise AssertionError('Bulk read back mismatch')
+
+        if root.srp.getOutstanding() != 0:
+            raise AssertionError('Credits not returned')
+
+def srpChain(mem):
+    """SrpV3 bridge and emulation in front of a memory emulator"""
+    emu = rogue.protocols.srp.SrpV3Emulation()
+    pr.busConnect(emu,mem)
+
+    srp = rogue.protocols.srp.SrpV3()
+    pr.streamConnectBiDir(srp,emu)
+
+    mast = rim.Master()
+    mast._setSlave(srp)
+    return srp, emu, mast
+
+def test_srp_split():
+    mem = pyrogue.interfaces.simulation.MemEmulate()
+    srp, emu, mast = srpChain(mem)
+    srp.setSplitDepth(2)
+
+    # Not a multiple of the frame size, split into pipelined requests
+    wr = bytearray((x * 7) & 0xFF for x in range(20000))
+    rd = bytearray(len(wr))
+
+    mast._reqTransaction(0x1000,wr,len(wr),0,rim.Write)
+    mast._waitTransaction(0)
+    mast._reqTransaction(0x1000,rd,len(rd),0,rim.Read)
+    mast._waitTransaction(0)
+
+    if mast._getError() != 0 or rd != wr:
+        raise AssertionError('Split transaction mismatch')
+
+    # Failing requests complete the parent once, with an error
+    mem = pyrogue.interfaces.simulation.MemEmulate(maxSize=1024)
+    srp, emu, mast = srpChain(mem)
+    mast._setTimeout(500000)
+
+    start = time.time()
+    mast._reqTransaction(0x1000,rd,len(rd),0,rim.Read)
+    mast._waitTransaction(0)
+
+    if mast._getError() == 0 or mast._getError() == rim.TimeoutError or (time.time() - start) > 0.4:
+        raise AssertionError('Split error not reported: 0x{:x}'.format(mast._getError()))
+
+def test_srp_window():
+    mem = pyrogue.interfaces.simulation.MemEmulate()
+    mem.setLatency(20000)
+    srp, emu, mast = srpChain(mem)
+    srp.setWindow(2)
+
+    # Requests past the window are queued, never more than the window in flight
+    ids = mast._reqTransactions([(4*x, bytearray(4), 4, 0, rim.Read) for x in range(16)])
+
+    peak = 0
+    while srp.getOutstanding() != 0 or srp.getQueueDepth() != 0:
+        peak = max(peak, srp.getOutstanding())
+        time.sleep(0.002)
+
+    if mast._waitTransactions(ids) != [0]*16:
+        raise AssertionError('Windowed requests failed')
+
+    if peak > 2 or srp.getMaxQueueDepth() < 10 or srp.getStallCount() == 0:
+        raise AssertionError('Window not applied: peak={} maxQueue={}'.format(peak,srp.getMaxQueueDepth()))
+
+    # Credits of a timed out transaction are returned
+    mem.setLatency(300000)
+    mast._setTimeout(50000)
+    ids = mast._reqTransactions([(4*x, bytearray(4), 4, 0, rim.Read) for x in range(4)])
+
+    if mast._waitTransactions(ids) != [rim.TimeoutError]*4:
+        raise AssertionError('Requests did not time out')
+
+    time.sleep(0.1)
+
+    if srp.getOutstanding() != 0 or srp.getQueueDepth() != 0:
+        raise AssertionError('Credits not returned after timeout')
+
+if __name__ == "__main__":
+    test_srp_emulate()
+    test_srp_split()
+    test_srp_window()
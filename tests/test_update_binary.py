@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : Binary variable update format test script
+#-----------------------------------------------------------------------------
+# File       : test_update_binary.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import pyrogue as pr
+
+def test_update_binary():
+
+    entries = [
+        (0,  None,          None),
+        (1,  True,          'True'),
+        (2,  False,         'False'),
+        (3,  -5,            '-5'),
+        (4,  0x7FFFFFFFFFFFFFFF, '0x7fffffffffffffff'),
+        (5,  1.5,           '1.5'),
+        (6,  'Hello µ', 'Hello µ'),
+        (7,  b'\x00\x01\xFF', ''),
+        (8,  1 << 64,       'big'),          # Beyond 64 bits, pickle fallback
+        (9,  [1, 2, 3],     '[1, 2, 3]'),    # Pickle fallback
+        (10, {'a': 'b'},    None),           # Pickle fallback, no display value
+    ]
+
+    ret = pr.binaryToUpdate(pr.updateToBinary(entries))
+
+    if len(ret) != len(entries):
+        raise AssertionError('Decoded {} of {} entries'.format(len(ret),len(entries)))
+
+    for exp,got in zip(entries,ret):
+        if got != exp or type(got[1]) != type(exp[1]):
+            raise AssertionError('Mismatch: sent {}, got {}'.format(exp,got))
+
+    # Empty message
+    if pr.binaryToUpdate(pr.updateToBinary([])) != []:
+        raise AssertionError('Empty message mismatch')
+
+if __name__ == "__main__":
+    test_update_binary()
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+#-----------------------------------------------------------------------------
+# Title      : ZMQ server and client test script
+#-----------------------------------------------------------------------------
+# File       : test_zmq.py
+# Created    : 2019-01-28
+#-----------------------------------------------------------------------------
+# This file is part of the rogue software platform. It is subject to
+# the license terms in the LICENSE.txt file found in the top-level directory
+# of this distribution and at:
+#    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+# No part of the rogue software platform, including this file, may be
+# copied, modified, propagated, or distributed except according to the terms
+# contained in the LICENSE.txt file.
+#-----------------------------------------------------------------------------
+import time
+import threading
+import jsonpickle
+import pyrogue as pr
+import pyrogue.interfaces
+import pyrogue.interfaces.simulation
+import rogue.interfaces
+
+Port = 9110
+
+class ZmqTree(pr.Root):
+
+    def __init__(self):
+        pr.Root.__init__(self,name='zmqTree',description="ZMQ test tree")
+
+        self.mem = pyrogue.interfaces.simulation.MemEmulate()
+
+        self.add(pr.Device(name='Dev', memBase=self.mem, offset=0x0, size=0x1000))
+
+        for i in range(4):
+            self.Dev.add(pr.RemoteVariable(
+                name         = 'Reg{}'.format(i),
+                offset       = 4*i,
+                bitSize      = 32,
+                bitOffset    = 0x00,
+                base         = pr.UInt,
+                mode         = 'RW',
+            ))
+
+        self.start(timeout=2.0, pollEn=False, zmqPort=Port)
+
+def request(client, path, attr, *args, **kwargs):
+    return jsonpickle.decode(client._send(jsonpickle.encode({'path':path, 'attr':attr, 'args':args, 'kwargs':kwargs})))
+
+def test_zmq_server():
+
+    with ZmqTree() as root:
+        client = rogue.interfaces.ZmqClient('localhost',Port)
+
+        # Malformed escapes are rejected by the broker, the server keeps running
+        for bad in ['\\uZZZZ', '\\u12', '\\uD800\\u0041', '\\q']:
+            client._send('{{"path":"zmqTree.Dev.Reg0{}","attr":"get","args":[],"kwargs":{{"read":false}}}}'.format(bad))
+
+        root.Dev.Reg0.set(5)
+
+        if request(client,'zmqTree.Dev.Reg0','get') != 5:
+            raise AssertionError('Server stopped after a malformed request')
+
+        # Requests from several clients are served by the worker pool
+        errors = []
+
+        def worker(idx):
+            c = rogue.interfaces.ZmqClient('localhost',Port)
+            path = 'zmqTree.Dev.Reg{}'.format(idx)
+
+            for x in range(20):
+                request(c,path,'set',x + 100*idx)
+                if request(c,path,'get') != x + 100*idx:
+                    errors.append((idx,x))
+
+        threads = [threading.Thread(target=worker,args=(i,)) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        if errors:
+            raise AssertionError('Concurrent requests failed: {}'.format(errors))
+
+def test_zmq_batch():
+
+    with ZmqTree() as root:
+        paths  = ['zmqTree.Dev.Reg{}'.format(i) for i in range(4)]
+        values = [0x10, 0x20, 0x30, 0x40]
+
+        # Batch set and get through the virtual client, one request each
+        client = pyrogue.interfaces.VirtualClient('localhost',Port)
+        client.setMany(dict(zip(paths,values)))
+
+        if [root.getNode(p).value() for p in paths] != values:
+            raise AssertionError('Batch set not applied')
+
+        if client.getMany(paths) != values:
+            raise AssertionError('Batch get mismatch: {}'.format(client.getMany(paths)))
+
+        if client.getMany(paths,disp=True) != [root.getNode(p).valueDisp() for p in paths]:
+            raise AssertionError('Batch get display mismatch')
+
+        # Published updates reach the client side cache
+        root.Dev.Reg1.set(0x99)
+        time.sleep(1.0)
+
+        if client.root.Dev.Reg1.value() != 0x99:
+            raise AssertionError('Client cache not updated')
+
+        # Native client batch access uses display values
+        native = rogue.interfaces.ZmqClient('localhost',Port)
+        native.setMany({paths[0] : root.Dev.Reg0.genDisp(0x55)})
+
+        if root.Dev.Reg0.value() != 0x55:
+            raise AssertionError('Native batch set not applied')
+
+        if list(native.getMany(paths)) != [root.getNode(p).valueDisp() for p in paths]:
+            raise AssertionError('Native batch get mismatch')
+
+if __name__ == "__main__":
+    test_zmq_server()
+    test_zmq_batch()